@@ -0,0 +1,244 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "BatchDetector.hpp"
+#include "FaceApi.hpp"
+
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QWaitCondition>
+
+
+namespace Tevian
+{
+	struct BatchDetector::Job
+	{
+		QMutex mutex;
+		
+		QWaitCondition added;
+		
+		QQueue<QString> queue;
+		
+		bool closed;
+		
+		//! Reset when detector is destroyed
+		BatchDetector* target;
+	};
+	
+	namespace
+	{
+		//! Login touches shared settings
+		QMutex loginMutex;
+		
+		class DetectWorker : public QRunnable
+		{
+		public:
+			DetectWorker(const BatchDetector::Options& options,
+			             const std::shared_ptr<BatchDetector::Job>& job)
+					: m_options { options },
+					  m_job { job }
+			{ }
+			
+			void run() Q_DECL_OVERRIDE
+			{
+				// Created in worker thread, network manager
+				// of api must live here
+				Client::FaceApi api(m_options.url, m_options.path);
+				BatchDetector::configure(api, m_options);
+				
+				QString file;
+				while (take(file))
+				{
+					QElapsedTimer timer;
+					timer.start();
+					
+					QJsonDocument document;
+					api.detect(file, document);
+					
+					const auto latency = timer.elapsed();
+					const auto error = BatchDetector::errorOf(document);
+					
+					QMutexLocker locker(&m_job->mutex);
+					if (!m_job->target)
+					{
+						return;
+					}
+					
+					if (error.isEmpty())
+					{
+						QMetaObject::invokeMethod(m_job->target, "detected", Qt::QueuedConnection,
+						                          Q_ARG(QString, file),
+						                          Q_ARG(QJsonDocument, document),
+						                          Q_ARG(qint64, latency));
+					} else
+					{
+						QMetaObject::invokeMethod(m_job->target, "failed", Qt::QueuedConnection,
+						                          Q_ARG(QString, file),
+						                          Q_ARG(QString, error),
+						                          Q_ARG(qint64, latency));
+					}
+				}
+				
+				QMutexLocker locker(&m_job->mutex);
+				if (m_job->target)
+				{
+					QMetaObject::invokeMethod(m_job->target, "finishWorker", Qt::QueuedConnection);
+				}
+			}
+		
+		private:
+			/**
+			 * \brief Waits for next file.
+			 *
+			 * \returns false if queue is closed and empty.
+			 * */
+			bool take(QString& file)
+			{
+				QMutexLocker locker(&m_job->mutex);
+				
+				while (m_job->queue.isEmpty() && !m_job->closed)
+				{
+					m_job->added.wait(&m_job->mutex);
+				}
+				
+				if (m_job->queue.isEmpty())
+				{
+					return false;
+				}
+				file = m_job->queue.dequeue();
+				return true;
+			}
+		
+		private:
+			BatchDetector::Options m_options;
+			
+			std::shared_ptr<BatchDetector::Job> m_job;
+		};
+	}
+	
+	BatchDetector::BatchDetector(const Options& options, QObject* parent)
+			: QObject(parent),
+			  m_options { options },
+			  m_pool { },
+			  m_job { std::make_shared<Job>() },
+			  m_workers { 0 }
+	{
+		m_job->closed = false;
+		m_job->target = this;
+		m_options.concurrency = qMax(1, m_options.concurrency);
+		m_pool.setMaxThreadCount(m_options.concurrency);
+		
+		// Workers block on requests, they don't use CPU
+		m_pool.setExpiryTimeout(-1);
+	}
+	
+	BatchDetector::~BatchDetector()
+	{
+		{
+			QMutexLocker locker(&m_job->mutex);
+			m_job->target = nullptr;
+			m_job->queue.clear();
+			m_job->closed = true;
+			m_job->added.wakeAll();
+		}
+		m_pool.waitForDone();
+	}
+	
+	void BatchDetector::start()
+	{
+		if (m_workers > 0)
+		{
+			return;
+		}
+		
+		m_workers = m_options.concurrency;
+		for (int i = 0; i < m_workers; ++i)
+		{
+			m_pool.start(new DetectWorker(m_options, m_job));
+		}
+	}
+	
+	void BatchDetector::add(const QStringList& files)
+	{
+		QMutexLocker locker(&m_job->mutex);
+		for (const auto& file : files)
+		{
+			m_job->queue.enqueue(file);
+		}
+		m_job->added.wakeAll();
+	}
+	
+	void BatchDetector::close()
+	{
+		QMutexLocker locker(&m_job->mutex);
+		m_job->closed = true;
+		m_job->added.wakeAll();
+	}
+	
+	void BatchDetector::cancel()
+	{
+		QMutexLocker locker(&m_job->mutex);
+		m_job->queue.clear();
+		m_job->closed = true;
+		m_job->added.wakeAll();
+	}
+	
+	int BatchDetector::pending() const
+	{
+		QMutexLocker locker(&m_job->mutex);
+		return m_job->queue.size();
+	}
+	
+	bool BatchDetector::isRunning() const
+	{
+		return m_workers > 0;
+	}
+	
+	void BatchDetector::configure(Client::FaceApi& api, const Options& options)
+	{
+		api.setTimeOut(options.timeout);
+		{
+			QMutexLocker locker(&loginMutex);
+			api.login(options.email, options.password, "Bearer");
+		}
+		
+		api.setThreshold(options.threshold);
+		api.setMinSize(options.minSize);
+		api.setMaxSize(options.maxSize);
+		api.setLandmarks(options.facets & LandmarksFacet);
+		api.setAttributes(options.facets & AttributesFacet);
+		api.setDemographics(options.facets & DemographicsFacet);
+	}
+	
+	QString
+	BatchDetector::errorOf(const QJsonDocument& document)
+	{
+		if (document.isNull() || document.isEmpty())
+		{
+			return QString("No response");
+		}
+		
+		const auto object = document.object();
+		const auto status = object.value("status_code").toInt(200);
+		
+		if (status >= 400)
+		{
+			return QString("%1 %2").arg(status).arg(object.value("message").toString());
+		}
+		return QString();
+	}
+	
+	void BatchDetector::finishWorker()
+	{
+		if (--m_workers == 0)
+		{
+			emit finished();
+		}
+	}
+}// namespace Tevian
\ No newline at end of file
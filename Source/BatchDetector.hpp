@@ -0,0 +1,140 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "FaceData.hpp"
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QJsonDocument>
+
+
+namespace Tevian
+{
+	namespace Client
+	{
+		class FaceApi;
+	}
+	
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Sends detect requests of many images at once.
+	 *
+	 * \details Every worker is a pool thread owning its own
+	 * \c FaceApi, logged in once, and takes files from shared
+	 * queue until it's closed and drained. Requests of one
+	 * worker are blocking, so count of workers is count of
+	 * requests in flight. Files may be added while running.
+	 * Results are posted to the object's thread.
+	 * */
+	class TEVIAN_API BatchDetector : public QObject
+	{
+	Q_OBJECT
+	public:
+		struct Options
+		{
+			QString url;
+			
+			QString path;
+			
+			QString email;
+			
+			QString password;
+			
+			//! Requests in flight
+			int concurrency = 4;
+			
+			//! Request timeout in milliseconds
+			int timeout = 30000;
+			
+			float threshold = 0.0;
+			
+			int minSize = 0;
+			
+			int maxSize = 0;
+			
+			Facets facets = NoFacets;
+		};
+		
+		//! Queue and state shared with workers
+		struct Job;
+		
+		explicit BatchDetector(const Options& options, QObject* parent = nullptr);
+		
+		~BatchDetector() Q_DECL_OVERRIDE;
+		
+		/**
+		 * \brief Starts workers, they wait for files
+		 * if queue is empty.
+		 * */
+		void start();
+		
+		/**
+		 * \brief Appends files to queue.
+		 * */
+		void add(const QStringList& files);
+		
+		/**
+		 * \brief No more files will be added, \c finished
+		 * is emitted when queue is drained.
+		 * */
+		void close();
+		
+		/**
+		 * \brief Drops queued files and closes queue.
+		 * */
+		void cancel();
+		
+		//! Files waiting for a worker
+		int pending() const;
+		
+		bool isRunning() const;
+		
+		/**
+		 * \brief Logs api in and applies detection
+		 * parameters of options.
+		 *
+		 * \note Login is serialized, it touches settings.
+		 * */
+		static void configure(Client::FaceApi& api, const Options& options);
+		
+		/**
+		 * \returns Reason of failed request, empty
+		 * if document holds detection results.
+		 * */
+		static QString
+		errorOf(const QJsonDocument& document);
+	
+	signals:
+		
+		/**
+		 * \param latency Request time in milliseconds
+		 * */
+		void detected(const QString& file, const QJsonDocument& document, qint64 latency);
+		
+		void failed(const QString& file, const QString& error, qint64 latency);
+		
+		void finished();
+	
+	private slots:
+		
+		void finishWorker();
+	
+	private:
+		Options m_options;
+		
+		QThreadPool m_pool;
+		
+		std::shared_ptr<Job> m_job;
+		
+		int m_workers;
+	};
+}// namespace Tevian
\ No newline at end of file
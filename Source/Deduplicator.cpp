@@ -0,0 +1,254 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Deduplicator.hpp"
+#include "FaceDetector.hpp"
+
+#include <QMutex>
+#include <QThread>
+#include <QRunnable>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+
+namespace Tevian
+{
+	struct Deduplicator::Job
+	{
+		QMutex mutex;
+		
+		//! Reset when deduplicator is destroyed
+		Deduplicator* target;
+	};
+	
+	namespace
+	{
+		class HashTask : public QRunnable
+		{
+		public:
+			HashTask(const QString& file, PerceptualHash::Method method,
+			         const std::shared_ptr<Deduplicator::Job>& job)
+					: m_file { file },
+					  m_method { method },
+					  m_job { job }
+			{ }
+			
+			void run() Q_DECL_OVERRIDE
+			{
+				QSize size;
+				const auto hash = PerceptualHash::hashFile(m_file, m_method, &size);
+				
+				QMutexLocker locker(&m_job->mutex);
+				if (m_job->target)
+				{
+					QMetaObject::invokeMethod(m_job->target, "hashed", Qt::QueuedConnection,
+					                          Q_ARG(QString, m_file),
+					                          Q_ARG(qulonglong, hash),
+					                          Q_ARG(QSize, size));
+				}
+			}
+		
+		private:
+			QString m_file;
+			
+			PerceptualHash::Method m_method;
+			
+			std::shared_ptr<Deduplicator::Job> m_job;
+		};
+		
+		qreal aspect(const QSize& size)
+		{
+			return qreal(size.width()) / size.height();
+		}
+	}
+	
+	Deduplicator::Deduplicator(const Options& options, QObject* parent)
+			: QObject(parent),
+			  m_options { options },
+			  m_pool { },
+			  m_job { std::make_shared<Job>() },
+			  m_tree { },
+			  m_images { },
+			  m_ids { },
+			  m_hashing { 0 },
+			  m_waiting { 0 },
+			  m_duplicates { 0 }
+	{
+		m_job->target = this;
+		m_pool.setMaxThreadCount(m_options.threads > 0 ? m_options.threads : QThread::idealThreadCount());
+	}
+	
+	Deduplicator::~Deduplicator()
+	{
+		{
+			QMutexLocker locker(&m_job->mutex);
+			m_job->target = nullptr;
+		}
+		m_pool.clear();
+		m_pool.waitForDone();
+	}
+	
+	void Deduplicator::add(const QStringList& files)
+	{
+		for (const auto& file : files)
+		{
+			++m_hashing;
+			m_pool.start(new HashTask(file, m_options.method, m_job));
+		}
+	}
+	
+	void Deduplicator::setResult(const QString& file, const QJsonDocument& document)
+	{
+		const int id = m_ids.value(file, -1);
+		if (id < 0)
+		{
+			return;
+		}
+		
+		auto& image = m_images[id];
+		image.document = document;
+		image.detected = true;
+		
+		// Copies, slots may add files
+		const auto size = image.size;
+		const auto waiting = image.waiting;
+		image.waiting.clear();
+		m_waiting -= waiting.size();
+		
+		for (const auto& duplicate : waiting)
+		{
+			++m_duplicates;
+			emit this->duplicate(duplicate.file, file, rescaled(document, size, duplicate.size));
+		}
+	}
+	
+	void Deduplicator::setFailed(const QString& file)
+	{
+		const int id = m_ids.value(file, -1);
+		if (id < 0)
+		{
+			return;
+		}
+		
+		// Failed image stays in tree but isn't matched,
+		// the first of its duplicates takes its place
+		auto& image = m_images[id];
+		image.failed = true;
+		
+		const auto waiting = image.waiting;
+		image.waiting.clear();
+		m_waiting -= waiting.size();
+		
+		for (const auto& duplicate : waiting)
+		{
+			match(duplicate.file, duplicate.hash, duplicate.size);
+		}
+	}
+	
+	int Deduplicator::pending() const
+	{
+		return m_hashing + m_waiting;
+	}
+	
+	int Deduplicator::duplicates() const
+	{
+		return m_duplicates;
+	}
+	
+	QJsonDocument
+	Deduplicator::rescaled(const QJsonDocument& document, const QSize& from, const QSize& to)
+	{
+		if (from == to || from.isEmpty())
+		{
+			return document;
+		}
+		
+		const qreal sx = qreal(to.width()) / from.width();
+		const qreal sy = qreal(to.height()) / from.height();
+		
+		auto response = document.object();
+		const auto key = JsonReader::facesKey(response);
+		auto faces = response.value(key).toArray();
+		
+		for (int i = 0; i < faces.size(); ++i)
+		{
+			auto face = faces.at(i).toObject();
+			const auto bbox = face.value("bbox").toObject();
+			
+			face.insert("bbox", QJsonObject {{ "x",      qRound(bbox.value("x").toDouble() * sx) },
+			                                 { "y",      qRound(bbox.value("y").toDouble() * sy) },
+			                                 { "width",  qRound(bbox.value("width").toDouble() * sx) },
+			                                 { "height", qRound(bbox.value("height").toDouble() * sy) }});
+			
+			if (face.contains("landmarks"))
+			{
+				QJsonArray landmarks { };
+				for (const auto& value : face.value("landmarks").toArray())
+				{
+					const auto point = value.toObject();
+					landmarks.push_back(QJsonObject {{ "x", qRound(point.value("x").toDouble() * sx) },
+					                                 { "y", qRound(point.value("y").toDouble() * sy) }});
+				}
+				face.insert("landmarks", landmarks);
+			}
+			faces[i] = face;
+		}
+		
+		if (!key.isEmpty())
+		{
+			response.insert(key, faces);
+		}
+		return QJsonDocument(response);
+	}
+	
+	void Deduplicator::hashed(const QString& file, qulonglong hash, const QSize& size)
+	{
+		--m_hashing;
+		match(file, hash, size);
+	}
+	
+	void Deduplicator::match(const QString& file, quint64 hash, const QSize& size)
+	{
+		// Unreadable files are left for backend to report
+		if (size.isEmpty())
+		{
+			emit unique(file);
+			return;
+		}
+		
+		// Rescaling assumes the same framing, crops
+		// of other aspect aren't reused
+		for (const auto& candidate : m_tree.find(hash, m_options.distance))
+		{
+			auto& image = m_images[candidate.id];
+			const auto difference = qAbs(aspect(image.size) - aspect(size));
+			
+			if (image.failed || difference > m_options.aspectTolerance * qMax(aspect(image.size), aspect(size)))
+			{
+				continue;
+			}
+			
+			if (!image.detected)
+			{
+				image.waiting.push_back({ file, size, hash });
+				++m_waiting;
+				return;
+			}
+			
+			const auto original = image.file;
+			const auto document = rescaled(image.document, image.size, size);
+			++m_duplicates;
+			emit duplicate(file, original, document);
+			return;
+		}
+		
+		const int id = m_images.size();
+		m_images.push_back({ file, size, QJsonDocument(), false, false, { }});
+		m_tree.insert(hash, id);
+		m_ids.insert(file, id);
+		emit unique(file);
+	}
+}// namespace Tevian
\ No newline at end of file
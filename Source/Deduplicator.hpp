@@ -0,0 +1,166 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "HashTree.hpp"
+#include "PerceptualHash.hpp"
+
+#include <QHash>
+#include <QSize>
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+#include <QThreadPool>
+#include <QJsonDocument>
+
+
+namespace Tevian
+{
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Finds near-identical images before they are sent
+	 * to backend.
+	 *
+	 * \details Perceptual hashes of added files are computed on
+	 * own pool from thumbnails decoded at small size. File whose
+	 * hash is within \c Options::distance of already seen image
+	 * of the same aspect ratio is its duplicate, and gets response
+	 * of that image with coordinates rescaled to its size. While
+	 * the image isn't detected yet, duplicates wait for it. Other
+	 * files are \c unique, caller detects them and reports results
+	 * by \c setResult or \c setFailed.
+	 * */
+	class TEVIAN_API Deduplicator : public QObject
+	{
+	Q_OBJECT
+	public:
+		struct Options
+		{
+			//! Largest Hamming distance of duplicates
+			int distance = 4;
+			
+			PerceptualHash::Method method = PerceptualHash::PHash;
+			
+			//! Relative aspect ratio difference of duplicates
+			qreal aspectTolerance = 0.02;
+			
+			//! Hashing threads, ideal thread count if 0
+			int threads = 0;
+		};
+		
+		//! State shared with hashing tasks
+		struct Job;
+		
+		explicit Deduplicator(const Options& options = Options(), QObject* parent = nullptr);
+		
+		~Deduplicator() Q_DECL_OVERRIDE;
+		
+		/**
+		 * \brief Starts hashing files, each one is reported
+		 * by \c unique or \c duplicate.
+		 * */
+		void add(const QStringList& files);
+		
+		/**
+		 * \brief Sets response of unique file, its waiting
+		 * duplicates are reported.
+		 * */
+		void setResult(const QString& file, const QJsonDocument& document);
+		
+		/**
+		 * \brief Unique file can't be detected, its waiting
+		 * duplicates are matched again.
+		 * */
+		void setFailed(const QString& file);
+		
+		/**
+		 * \returns Files being hashed or waiting for
+		 * their original.
+		 * */
+		int pending() const;
+		
+		//! Count of files reported as duplicates
+		int duplicates() const;
+		
+		/**
+		 * \returns Response with boxes and landmarks scaled
+		 * from image of \c from size to \c to size.
+		 * */
+		static QJsonDocument
+		rescaled(const QJsonDocument& document, const QSize& from, const QSize& to);
+	
+	signals:
+		
+		/**
+		 * \brief File must be detected.
+		 * */
+		void unique(const QString& file);
+		
+		/**
+		 * \param original Image response is taken from
+		 * */
+		void duplicate(const QString& file, const QString& original, const QJsonDocument& document);
+	
+	private slots:
+		
+		void hashed(const QString& file, qulonglong hash, const QSize& size);
+	
+	private:
+		struct Duplicate
+		{
+			QString file;
+			
+			QSize size;
+			
+			quint64 hash;
+		};
+		
+		struct Image
+		{
+			QString file;
+			
+			QSize size;
+			
+			QJsonDocument document;
+			
+			bool detected;
+			
+			bool failed;
+			
+			//! Duplicates waiting for response
+			QVector<Duplicate> waiting;
+		};
+		
+		/**
+		 * \brief Reports file as duplicate or unique.
+		 * */
+		void match(const QString& file, quint64 hash, const QSize& size);
+	
+	private:
+		Options m_options;
+		
+		QThreadPool m_pool;
+		
+		std::shared_ptr<Job> m_job;
+		
+		HashTree m_tree;
+		
+		//! Unique images, index is id in tree
+		QVector<Image> m_images;
+		
+		QHash<QString, int> m_ids;
+		
+		int m_hashing;
+		
+		int m_waiting;
+		
+		int m_duplicates;
+	};
+}// namespace Tevian
\ No newline at end of file
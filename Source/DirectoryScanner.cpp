@@ -0,0 +1,392 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "DirectoryScanner.hpp"
+#include "ResultsStore.hpp"
+#include "Settings.hpp"
+
+#include <cstring>
+
+#include <QFile>
+#include <QMutex>
+#include <QQueue>
+#include <QStack>
+#include <QThread>
+#include <QRunnable>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+
+namespace Tevian
+{
+	struct DirectoryScanner::Job
+	{
+		QMutex mutex;
+		
+		//! Directory pushed or walking is over
+		QWaitCondition work;
+		
+		//! Queue has room
+		QWaitCondition space;
+		
+		QStack<QString> directories;
+		
+		//! Workers listing a directory now
+		int walking;
+		
+		QQueue<Entry> queue;
+		
+		int found;
+		
+		int skipped;
+		
+		bool cancelled;
+		
+		//! Read on owner thread, settings aren't
+		//! touched by workers
+		QString cachePath;
+		
+		//! Reset when scanner is destroyed
+		DirectoryScanner* target;
+	};
+	
+	namespace
+	{
+		struct Signature
+		{
+			const char* magic;
+			
+			int size;
+			
+			//! Position of magic in file
+			int offset;
+			
+			const char* format;
+		};
+		
+		const Signature Signatures[] = {
+				{ "\xFF\xD8\xFF",         3, 0, "jpeg" },
+				{ "\x89PNG\r\n\x1A\n",    8, 0, "png" },
+				{ "GIF87a",               6, 0, "gif" },
+				{ "GIF89a",               6, 0, "gif" },
+				{ "WEBP",                 4, 8, "webp" },
+				{ "II*\0",                4, 0, "tiff" },
+				{ "MM\0*",                4, 0, "tiff" },
+				{ "\0\0\1\0",             4, 0, "ico" },
+				{ "BM",                   2, 0, "bmp" },
+				{ "P1",                   2, 0, "pbm" },
+				{ "P4",                   2, 0, "pbm" },
+				{ "P2",                   2, 0, "pgm" },
+				{ "P5",                   2, 0, "pgm" },
+				{ "P3",                   2, 0, "ppm" },
+				{ "P6",                   2, 0, "ppm" }
+		};
+		
+		//! Longest signature end
+		const int HeadSize = 12;
+		
+		//! Files pushed to queue at once
+		const int BatchSize = 64;
+		
+		class ScanWorker : public QRunnable
+		{
+		public:
+			ScanWorker(const DirectoryScanner::Options& options,
+			           const std::shared_ptr<DirectoryScanner::Job>& job)
+					: m_options { options },
+					  m_job { job }
+			{ }
+			
+			void run() Q_DECL_OVERRIDE
+			{
+				QString directory;
+				while (next(directory))
+				{
+					scan(directory);
+					
+					QMutexLocker locker(&m_job->mutex);
+					if (--m_job->walking == 0 && m_job->directories.isEmpty())
+					{
+						m_job->work.wakeAll();
+					}
+				}
+				
+				QMutexLocker locker(&m_job->mutex);
+				if (m_job->target)
+				{
+					QMetaObject::invokeMethod(m_job->target, "finishWorker", Qt::QueuedConnection);
+				}
+			}
+		
+		private:
+			/**
+			 * \brief Waits for directory to walk.
+			 *
+			 * \returns false if there's none and no worker
+			 * can push more.
+			 * */
+			bool next(QString& directory)
+			{
+				QMutexLocker locker(&m_job->mutex);
+				
+				while (m_job->directories.isEmpty() && m_job->walking > 0 && !m_job->cancelled)
+				{
+					m_job->work.wait(&m_job->mutex);
+				}
+				
+				if (m_job->cancelled || m_job->directories.isEmpty())
+				{
+					return false;
+				}
+				directory = m_job->directories.pop();
+				++m_job->walking;
+				return true;
+			}
+			
+			void scan(const QString& directory)
+			{
+				// Private store, its records are only read
+				std::unique_ptr<ResultsStore> store { };
+				if (m_options.skipProcessed)
+				{
+					store.reset(new ResultsStore(ResultsStore::datasetFile(directory, m_job->cachePath)));
+				}
+				
+				QVector<DirectoryScanner::Entry> batch { };
+				int skipped = 0;
+				
+				QDirIterator iterator(directory, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+				while (iterator.hasNext())
+				{
+					iterator.next();
+					const auto info = iterator.fileInfo();
+					
+					if (info.isDir())
+					{
+						// Other workers take subdirectory at once
+						if (m_options.recursive && !info.isSymLink())
+						{
+							QMutexLocker locker(&m_job->mutex);
+							m_job->directories.push(info.filePath());
+							m_job->work.wakeOne();
+						}
+						continue;
+					}
+					
+					DirectoryScanner::Entry entry { };
+					entry.path = info.filePath();
+					entry.size = info.size();
+					entry.modified = info.lastModified().toMSecsSinceEpoch();
+					
+					// Stamp check is before sniffing, processed
+					// files aren't even opened
+					if (store && store->isProcessed(entry.path, entry.modified, entry.size))
+					{
+						++skipped;
+						continue;
+					}
+					
+					entry.format = DirectoryScanner::sniff(entry.path);
+					if (entry.format.isEmpty())
+					{
+						continue;
+					}
+					
+					batch.push_back(entry);
+					if (batch.size() == BatchSize && !push(batch))
+					{
+						return;
+					}
+				}
+				push(batch);
+				
+				QMutexLocker locker(&m_job->mutex);
+				m_job->skipped += skipped;
+			}
+			
+			/**
+			 * \brief Moves files to queue, waits while it's full.
+			 *
+			 * \returns false if scan is cancelled.
+			 * */
+			bool push(QVector<DirectoryScanner::Entry>& batch)
+			{
+				QMutexLocker locker(&m_job->mutex);
+				
+				for (const auto& entry : batch)
+				{
+					while (m_job->queue.size() >= m_options.capacity && !m_job->cancelled)
+					{
+						m_job->space.wait(&m_job->mutex);
+					}
+					
+					if (m_job->cancelled)
+					{
+						return false;
+					}
+					
+					if (m_job->queue.isEmpty() && m_job->target)
+					{
+						QMetaObject::invokeMethod(m_job->target, "available", Qt::QueuedConnection);
+					}
+					m_job->queue.enqueue(entry);
+					++m_job->found;
+				}
+				batch.clear();
+				return true;
+			}
+		
+		private:
+			DirectoryScanner::Options m_options;
+			
+			std::shared_ptr<DirectoryScanner::Job> m_job;
+		};
+	}
+	
+	DirectoryScanner::DirectoryScanner(const Options& options, QObject* parent)
+			: QObject(parent),
+			  m_options { options },
+			  m_pool { },
+			  m_job { std::make_shared<Job>() },
+			  m_workers { 0 }
+	{
+		m_options.capacity = qMax(1, m_options.capacity);
+		m_pool.setMaxThreadCount(m_options.threads > 0 ? m_options.threads : QThread::idealThreadCount());
+		
+		m_job->walking = 0;
+		m_job->found = 0;
+		m_job->skipped = 0;
+		m_job->cancelled = false;
+		m_job->target = this;
+	}
+	
+	DirectoryScanner::~DirectoryScanner()
+	{
+		{
+			QMutexLocker locker(&m_job->mutex);
+			m_job->target = nullptr;
+			m_job->cancelled = true;
+			m_job->work.wakeAll();
+			m_job->space.wakeAll();
+		}
+		m_pool.waitForDone();
+	}
+	
+	void DirectoryScanner::start(const QStringList& directories)
+	{
+		if (m_workers > 0)
+		{
+			return;
+		}
+		
+		{
+			QMutexLocker locker(&m_job->mutex);
+			m_job->directories.clear();
+			m_job->queue.clear();
+			m_job->walking = 0;
+			m_job->found = 0;
+			m_job->skipped = 0;
+			m_job->cancelled = false;
+			m_job->cachePath = g_settingsManager->cachePath();
+			
+			for (const auto& directory : directories)
+			{
+				m_job->directories.push(QFileInfo(directory).absoluteFilePath());
+			}
+		}
+		
+		m_workers = m_pool.maxThreadCount();
+		for (int i = 0; i < m_workers; ++i)
+		{
+			m_pool.start(new ScanWorker(m_options, m_job));
+		}
+	}
+	
+	int DirectoryScanner::take(QVector<Entry>& entries, int count)
+	{
+		QMutexLocker locker(&m_job->mutex);
+		int taken = 0;
+		
+		for (; taken < count && !m_job->queue.isEmpty(); ++taken)
+		{
+			entries.push_back(m_job->queue.dequeue());
+		}
+		
+		if (taken > 0)
+		{
+			m_job->space.wakeAll();
+		}
+		return taken;
+	}
+	
+	void DirectoryScanner::cancel()
+	{
+		QMutexLocker locker(&m_job->mutex);
+		m_job->cancelled = true;
+		m_job->directories.clear();
+		m_job->queue.clear();
+		m_job->work.wakeAll();
+		m_job->space.wakeAll();
+	}
+	
+	bool DirectoryScanner::isFinished() const
+	{
+		QMutexLocker locker(&m_job->mutex);
+		return m_workers == 0 && m_job->queue.isEmpty();
+	}
+	
+	QByteArray
+	DirectoryScanner::sniff(const QString& file)
+	{
+		// Plugins may miss some of known formats
+		static const auto supported = QImageReader::supportedImageFormats();
+		
+		QFile device(file);
+		if (!device.open(QFile::ReadOnly))
+		{
+			return QByteArray();
+		}
+		
+		const auto head = device.read(HeadSize);
+		
+		for (const auto& signature : Signatures)
+		{
+			if (head.size() >= signature.offset + signature.size
+			    && std::memcmp(head.constData() + signature.offset, signature.magic, size_t(signature.size)) == 0)
+			{
+				const QByteArray format(signature.format);
+				return supported.contains(format) ? format : QByteArray();
+			}
+		}
+		return QByteArray();
+	}
+	
+	QByteArray
+	DirectoryScanner::imageFormat(const QString& file)
+	{
+		// Table is the fast path, plugins open file again
+		const auto format = sniff(file);
+		return format.isEmpty() ? QImageReader::imageFormat(file) : format;
+	}
+	
+	void DirectoryScanner::finishWorker()
+	{
+		if (--m_workers > 0)
+		{
+			return;
+		}
+		
+		QMutexLocker locker(&m_job->mutex);
+		const auto found = m_job->found;
+		const auto skipped = m_job->skipped;
+		locker.unlock();
+		
+		emit finished(found, skipped);
+	}
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,143 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "Defines.hpp"
+
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+#include <QThreadPool>
+
+
+namespace Tevian
+{
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Finds image files in directory trees.
+	 *
+	 * \details Workers of own pool take directories from shared
+	 * stack and push found subdirectories back, so trees are
+	 * walked in parallel. Image format is sniffed from first
+	 * bytes of file, no image reader is constructed. Found files
+	 * go to bounded queue consumed by \c take while scan is still
+	 * running, workers wait when it's full.
+	 * Files having current results in \c ResultsStore may be
+	 * skipped by path, modification time and size.
+	 * */
+	class TEVIAN_API DirectoryScanner : public QObject
+	{
+	Q_OBJECT
+	public:
+		//! Default capacity of found files queue
+		static constexpr int DefaultCapacity = 1024;
+		
+		struct Entry
+		{
+			QString path;
+			
+			//! Format name as known to QImageReader
+			QByteArray format;
+			
+			qint64 size = 0;
+			
+			qint64 modified = 0;
+		};
+		
+		struct Options
+		{
+			bool recursive = true;
+			
+			//! Skip files with current stored results
+			bool skipProcessed = false;
+			
+			int capacity = DefaultCapacity;
+			
+			//! Walking threads, ideal thread count if 0
+			int threads = 0;
+		};
+		
+		//! State shared with workers
+		struct Job;
+		
+		explicit DirectoryScanner(const Options& options = Options(), QObject* parent = nullptr);
+		
+		~DirectoryScanner() Q_DECL_OVERRIDE;
+		
+		/**
+		 * \brief Starts walking directories, \c available is
+		 * emitted when queue gets files.
+		 * */
+		void start(const QStringList& directories);
+		
+		/**
+		 * \brief Moves up to \c count found files to \c entries,
+		 * doesn't wait.
+		 *
+		 * \returns Count of moved files.
+		 * */
+		int take(QVector<Entry>& entries, int count = DefaultCapacity);
+		
+		/**
+		 * \brief Stops walking, queued files are dropped.
+		 * */
+		void cancel();
+		
+		/**
+		 * \returns true if walking is over and every
+		 * found file is taken.
+		 * */
+		bool isFinished() const;
+		
+		/**
+		 * \returns Image format by file signature, empty
+		 * if file isn't image of known format.
+		 * */
+		static QByteArray
+		sniff(const QString& file);
+		
+		/**
+		 * \returns Image format by file signature, or by
+		 * image plugins if signature isn't in table, empty
+		 * if file isn't readable image.
+		 * */
+		static QByteArray
+		imageFormat(const QString& file);
+	
+	signals:
+		
+		/**
+		 * \brief Emitted when empty queue gets files.
+		 * */
+		void available();
+		
+		/**
+		 * \brief Emitted when walking is over, queue
+		 * may still hold files.
+		 *
+		 * \param found Count of found image files
+		 * \param skipped Count of files skipped as processed
+		 * */
+		void finished(int found, int skipped);
+	
+	private slots:
+		
+		void finishWorker();
+	
+	private:
+		Options m_options;
+		
+		QThreadPool m_pool;
+		
+		std::shared_ptr<Job> m_job;
+		
+		int m_workers;
+	};
+}// namespace Tevian
\ No newline at end of file
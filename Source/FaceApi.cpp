@@ -198,7 +198,7 @@ namespace Tevian
 		
 		void FaceApi::setFace2(const FaceData::face_array& other)
 		{
-			m_matchData.set(other);
+			m_matchData.set2(other[0], other[1], other[2], other[3]);
 		}
 		
 		void FaceApi::setDemographics(bool enable)
@@ -269,6 +269,13 @@ namespace Tevian
 			       m_matchData._landmarks;
 		}
 		
+		Facets FaceApi::getFacets()
+		{
+			return m_mode == Mode::Detect ?
+			       m_detectData.facets() :
+			       m_matchData.facets();
+		}
+		
 		void FaceApi::initKeys(Mode mode)
 		{
 			if (mode == Mode::Detect)
@@ -33,6 +33,13 @@ namespace Tevian
 				Match
 			};
 			
+			//! Score threshold server applies if none set
+			static constexpr float DefaultThreshold = 0.8f;
+			
+			//! Most permissive threshold used to fetch
+			//! every candidate face
+			static constexpr float SupersetThreshold = 0.1f;
+			
 			FaceApi(const QString& url, QString path = QString());
 			
 			/**
@@ -137,6 +144,11 @@ namespace Tevian
 			bool getAttributes();
 			
 			bool getLandmarks();
+			
+			/**
+			 * \returns Enabled facets as \c FacetFlag mask.
+			 * */
+			Facets getFacets();
 		
 		signals:
 			
@@ -12,6 +12,20 @@
 
 namespace Tevian
 {
+	/**
+	 * \brief Optional parts of detection result,
+	 * requested from server by flags.
+	 * */
+	enum FacetFlag : quint16
+	{
+		NoFacets            = 0x0,
+		LandmarksFacet      = 0x1,
+		AttributesFacet     = 0x2,
+		DemographicsFacet   = 0x4
+	};
+	
+	using Facets = quint16;
+	
 	struct FaceData
 	{
 		using face_array = std::array<int, 4>;
@@ -53,14 +67,24 @@ namespace Tevian
 			return isFaceEmpty(_face);
 		}
 		
+		/**
+		 * \returns Requested facets as \c FacetFlag mask.
+		 * */
+		inline Facets facets() const
+		{
+			return (_landmarks ? LandmarksFacet : NoFacets)
+			       | (_attributes ? AttributesFacet : NoFacets)
+			       | (_demographics ? DemographicsFacet : NoFacets);
+		}
+		
 		// members
 		face_array _face = face_array();
 		
-		bool _attributes;
+		bool _attributes = false;
 		
-		bool _landmarks;
+		bool _landmarks = false;
 		
-		bool _demographics;
+		bool _demographics = false;
 	};
 	
 	struct DetectData : public FaceData
@@ -93,6 +117,10 @@ namespace Tevian
 	struct ControlData : public DetectData
 	{
 		face_array _face2 { };
+		
+		//! Fetch all candidate faces once and
+		//! filter them locally
+		bool _superset = false;
 	};
 }
 
@@ -4,6 +4,14 @@
  */
 
 #include "FaceDetector.hpp"
+#include "FaceIndex.hpp"
+#include "ResultsStore.hpp"
+#include "Statistics.hpp"
+
+#include <algorithm>
+
+#include <QFileInfo>
+#include <QDateTime>
 #include <QMatrix>
 #include <QMessageBox>
 
@@ -13,9 +21,10 @@ namespace Tevian
 	using Client::FaceApi;
 	
 	Details::Demographics::Demographics(qreal mean, qreal variance,
-	                                    QString gender, QString ethnicity) Q_DECL_NOEXCEPT
-			: _ethnicity { gender },
-			  _gender { ethnicity },
+	                                    const QString& gender,
+	                                    const QString& ethnicity) Q_DECL_NOEXCEPT
+			: _ethnicity { g_stringTable->intern(ethnicity) },
+			  _gender { g_stringTable->intern(gender) },
 			  _age(Age(mean, variance))
 	{
 		++_id;
@@ -28,18 +37,87 @@ namespace Tevian
 		QString info = QString("Age mean: %1 \nAge variance: %2 \nEthnicity: %3 \nGender: %4")
 				.arg(_age._mean)
 				.arg(_age._variance)
-				.arg(_ethnicity)
-				.arg(_gender);
+				.arg(getEthnicity())
+				.arg(getGender());
 		return info;
 	}
 	
+	void Details::Attributes::set(StringCode key, StringCode value)
+	{
+		auto position = lowerBound(key);
+		auto index = int(position - m_items.cbegin());
+		
+		if (position != m_items.cend() && position->key == key)
+		{
+			m_items[index].value = value;
+		} else
+		{
+			m_items.insert(index, { key, value });
+		}
+	}
+	
+	void Details::Attributes::set(const QString& key, const QString& value)
+	{
+		set(g_stringTable->intern(key), g_stringTable->intern(value));
+	}
+	
+	StringCode Details::Attributes::value(StringCode key) const
+	{
+		auto position = lowerBound(key);
+		
+		if (position != m_items.cend() && position->key == key)
+		{
+			return position->value;
+		}
+		return StringTable::Empty;
+	}
+	
+	const QString&
+	Details::Attributes::value(const QString& key) const
+	{
+		const auto code = g_stringTable->find(key);
+		
+		// Key never seen, no face has it
+		if (code == StringTable::NoCode)
+		{
+			return g_stringTable->string(StringTable::Empty);
+		}
+		return g_stringTable->string(value(code));
+	}
+	
+	bool Details::Attributes::contains(StringCode key) const
+	{
+		auto position = lowerBound(key);
+		return position != m_items.cend() && position->key == key;
+	}
+	
+	Details::Attributes::const_iterator
+	Details::Attributes::lowerBound(StringCode key) const
+	{
+		return std::lower_bound(m_items.cbegin(), m_items.cend(), key,
+		                        [](const Attribute& attribute, StringCode code)
+		                        {
+			                        return attribute.key < code;
+		                        });
+	}
+	
+	namespace
+	{
+		/**
+		 * \returns Threshold server applies,
+		 * zero value means server's default.
+		 * */
+		float effectiveThreshold(float threshold)
+		{
+			return threshold > 0 ? threshold : FaceApi::DefaultThreshold;
+		}
+	}
+	
 	/// FaceDetector
 	FaceDetector::FaceDetector(const QString& file, Client::FaceApi* api)
 			: m_file { file },
 			  m_reader { new JsonReader },
-			  m_face { },
-			  m_demographics { Details::Demographics() },
-			  m_attributes { Details::Attributes() }
+			  m_faces { }
 	{
 		init(api);
 	}
@@ -53,66 +131,152 @@ namespace Tevian
 	{
 		/// Avoid multiple calls if no data in \c FaceApi set.
 		
+		if (!m_fetched && restore(true))
+		{
+			return m_fetched;
+		}
+		
 		if (!m_fetched)
 		{
 			QJsonDocument document;
 			m_faceApi->detect(m_file, document);
 			m_reader->setDocument(document);
+			m_unread = m_faceApi->getFacets();
+			m_pending = m_reader->isReady();
 			m_fetched = true;
 		}
 		return m_fetched;
 	}
 	
+	bool FaceDetector::restore()
+	{
+		return restore(false);
+	}
+	
 	void FaceDetector::run()
 	{
-		if (m_fetched)
+		if (m_fetched && m_pending)
 		{
-			// check if requested values are valid
-			if (m_faceApi->getAttributes())
-			{
-				readAttributes();
-			}
+			const int count = m_reader->faceCount();
 			
-			if (!FaceData::isFaceEmpty(m_faceApi->getFace()))
+			// Response to the same parameters holds the same faces,
+			// so facets of partial response are merged into held ones
+			if (!m_hasResults || count != m_faces.size())
 			{
-				readBoundingBox();
+				m_faces = QVector<Details::Face>(count);
+				m_facets = NoFacets;
 			}
 			
-			if (m_faceApi->getLandmarks())
+			for (int i = 0; i < count; ++i)
 			{
-				readFacelandmarks();
+				auto& face = m_faces[i];
+				m_reader->setFace(i);
+				
+				// Read only facets requested by the last response,
+				// others are kept from previous ones
+				readBoundingBox(*m_reader, face);
+				
+				if (m_unread & AttributesFacet)
+				{
+					readAttributes(*m_reader, face);
+				}
+				
+				if (m_unread & LandmarksFacet)
+				{
+					readFacelandmarks(*m_reader, face);
+				}
+				
+				if (m_unread & DemographicsFacet)
+				{
+					readDemographics(*m_reader, face);
+				}
 			}
 			
-			if (m_faceApi->getDemographics())
+			m_facets |= m_unread;
+			m_unread = NoFacets;
+			m_pending = false;
+			m_hasResults = true;
+			
+			store();
+		}
+		return;
+	}
+	
+	Facets FaceDetector::getFacets() const
+	{
+		return m_requested & m_facets;
+	}
+	
+	bool FaceDetector::hasResults() const
+	{
+		return m_hasResults;
+	}
+	
+	const QVector<Details::Face>&
+	FaceDetector::getAllFaces() const
+	{
+		return m_faces;
+	}
+	
+	QVector<Details::Face>
+	FaceDetector::getFaces() const
+	{
+		QVector<Details::Face> faces { };
+		
+		for (const auto& face : m_faces)
+		{
+			if (passes(face))
 			{
-				readDemographics();
+				faces.push_back(face);
 			}
 		}
-		return;
+		return faces;
+	}
+	
+	bool FaceDetector::covers(const DetectData& filter) const
+	{
+		return m_hasResults && covers(m_parameters, filter);
+	}
+	
+	bool FaceDetector::setFilter(const DetectData& filter)
+	{
+		if (!covers(filter))
+		{
+			return false;
+		}
+		
+		m_filter = filter;
+		return true;
+	}
+	
+	const DetectData&
+	FaceDetector::getFilter() const
+	{
+		return m_filter;
 	}
 	
 	const QVector<QPointF>&
 	FaceDetector::getLandmarks() const
 	{
-		return m_face.landmarks;
+		return primaryFace().landmarks;
 	}
 	
 	const std::array<int, 4>&
 	FaceDetector::getBox() const
 	{
-		return m_face.face_bounds;
+		return primaryFace().bounds;
 	}
 	
 	const Details::Attributes&
 	FaceDetector::getAttributes() const
 	{
-		return m_attributes;
+		return primaryFace().attributes;
 	}
 	
 	const Details::Demographics&
 	FaceDetector::getDemographics() const
 	{
-		return m_demographics;
+		return primaryFace().demographics;
 	}
 	
 	void FaceDetector::init(Tevian::Client::FaceApi* api)
@@ -136,107 +300,308 @@ namespace Tevian
 		m_faceApi->login(g_settingsManager->email(), g_settingsManager->password(), "Bearer");
 		m_faceApi->setParent(this);
 		m_fetched = false;
+		m_pending = false;
+		m_hasResults = false;
+		m_facets = NoFacets;
+		m_requested = NoFacets;
+		m_unread = NoFacets;
 	}
 	
-	void FaceDetector::readAttributes()
+	void FaceDetector::readAttributes(JsonReader& reader, Details::Face& face)
 	{
 		VariantMultiMap data { };
 		
-		if (m_faceApi->getAttributes())
+		face.attributes.clear();
+		data = reader.readObject(QString("attributes"));
+		for (const auto& item : data)
 		{
-			data = m_reader->readObject(QString("attributes"));
-			for (const auto& item : data)
+			face.attributes.set(item.first, item.second.toString());
+		}
+	}
+	
+	void FaceDetector::readBoundingBox(JsonReader& reader, Details::Face& face)
+	{
+		VariantMultiMap data { };
+		
+		data = reader.readObject(QString("bbox"));
+		for (const auto& item : data)
+		{
+			if (item.first.compare("x") == 0)
+			{
+				face.bounds[0] = item.second.toInt();
+			}
+			if (item.first.compare("y") == 0)
 			{
-				m_attributes.emplace(item.first.toStdString(),
-				                     item.second.toString().toStdString());
+				face.bounds[1] = item.second.toInt();
+			}
+			if (item.first.compare("width") == 0)
+			{
+				face.bounds[2] = item.second.toInt();
+			}
+			if (item.first.compare("height") == 0)
+			{
+				face.bounds[3] = item.second.toInt();
 			}
 		}
 		
+		face.score = float(reader.readValue(QString("score")).toDouble());
+	}
+	
+	void FaceDetector::readFacelandmarks(JsonReader& reader, Details::Face& face)
+	{
+		VariantMultiMap data { };
+		size_t size = 0;
+		
+		face.landmarks.clear();
+		data = reader.readArray(QString("landmarks"));
+		size = data.size();
+		// distance = (x,y)/2 -> map (x, valx), map(x + dist == y, valy)
+		const int distance = size / 2;
+		int x, y;
+		
+		auto xiter = data.begin();
+		auto yiter = data.begin();
+		
+		// xiter + dist == y
+		std::advance(yiter, distance);
+		
+		// yiter[dist, end)
+		for (; yiter != data.end(); ++yiter, ++xiter)
+		{
+			x = xiter->second.toInt(),
+					y = yiter->second.toInt();
+			
+			face.landmarks.push_back(QPointF(x, y));
+		}
 	}
 	
-	void FaceDetector::readBoundingBox()
+	void FaceDetector::readDemographics(JsonReader& reader, Details::Face& face)
 	{
 		VariantMultiMap data { };
 		
-		if (FaceData::isFaceEmpty(m_faceApi->getFace()))
+		data = reader.readObject(QString("demographics"));
+		for (const auto& item : data)
 		{
-			data = m_reader->readObject(QString("bbox"));
-			int i { };
-			for (const auto& item : data)
+			
+			if (item.first.compare("age") == 0)
+			{
+				face.demographics._age._mean = item.second.toJsonValue().toObject().
+						value("mean").toDouble();
+				face.demographics._age._variance = item.second.toJsonValue().toObject().
+						value("variance").toDouble();
+			}
+			if (item.first.compare("ethnicity") == 0)
+			{
+				face.demographics._ethnicity = g_stringTable->intern(item.second.toString());
+			}
+			if (item.first.compare("gender") == 0)
 			{
-				m_face.face_bounds[i++] = item.second.toInt();
+				face.demographics._gender = g_stringTable->intern(item.second.toString());
 			}
 		}
 	}
 	
-	void FaceDetector::readFacelandmarks()
+	QVector<Details::Face>
+	FaceDetector::readFaces(const QJsonDocument& document, Facets facets)
 	{
-		VariantMultiMap data { };
-		size_t size = 0;
-		if (m_faceApi->getLandmarks())
+		JsonReader reader;
+		reader.setDocument(document);
+		
+		QVector<Details::Face> faces(reader.faceCount());
+		for (int i = 0; i < faces.size(); ++i)
 		{
-			data = m_reader->readArray(QString("landmarks"));
-			size = m_face.landmarkSize = data.size();
-			// distance = (x,y)/2 -> map (x, valx), map(x + dist == y, valy)
-			const int distance = size / 2;
-			int x, y;
+			auto& face = faces[i];
+			reader.setFace(i);
+			readBoundingBox(reader, face);
 			
-			auto xiter = data.begin();
-			auto yiter = data.begin();
+			if (facets & AttributesFacet)
+			{
+				readAttributes(reader, face);
+			}
 			
-			// xiter + dist == y
-			std::advance(yiter, distance);
+			if (facets & LandmarksFacet)
+			{
+				readFacelandmarks(reader, face);
+			}
 			
-			// yiter[dist, end)
-			for (; yiter != data.end(); ++yiter, ++xiter)
+			if (facets & DemographicsFacet)
 			{
-				x = xiter->second.toInt(),
-						y = yiter->second.toInt();
-				
-				m_face.landmarks.push_back(QPointF(x, y));
+				readDemographics(reader, face);
 			}
 		}
+		return faces;
 	}
 	
-	void FaceDetector::readDemographics()
+	const Details::Face&
+	FaceDetector::primaryFace() const
 	{
-		VariantMultiMap data { };
-		if (m_faceApi->getDemographics())
+		static const Details::Face empty { };
+		
+		for (const auto& face : m_faces)
 		{
-			data = m_reader->readObject(QString("demographics"));
-			for (const auto& item : data)
+			if (passes(face))
 			{
-				
-				if (item.first.compare("age") == 0)
-				{
-					m_demographics._age._mean = item.second.toJsonValue().toObject().
-							value("mean").toDouble();
-					m_demographics._age._variance = item.second.toJsonValue().toObject().
-							value("variance").toDouble();
-				}
-				if (item.first.compare("ethnicity") == 0)
-				{
-					m_demographics._ethnicity = item.second.toString();
-				}
-				if (item.first.compare("gender") == 0)
-				{
-					m_demographics._gender = item.second.toString();
-				}
+				return face;
 			}
 		}
+		return empty;
+	}
+	
+	bool FaceDetector::passes(const Details::Face& face) const
+	{
+		// Limits that aren't stricter than held parameters
+		// are already applied by server
+		const auto threshold = effectiveThreshold(m_filter._threshold);
+		
+		return (threshold <= effectiveThreshold(m_parameters._threshold) || face.score >= threshold)
+		       && (m_filter._min_size <= m_parameters._min_size || face.size() >= m_filter._min_size)
+		       && (m_filter._max_size == 0 || face.size() <= m_filter._max_size);
+	}
+	
+	bool FaceDetector::restore(bool matchRequest)
+	{
+		ResultsStore::Image image;
+		
+		if (!ResultsStore::forImage(m_file)->find(m_file, image)
+		    || !ResultsStore::isCurrent(image))
+		{
+			return false;
+		}
+		
+		DetectData parameters;
+		parameters._threshold = image.threshold;
+		parameters._min_size = image.minSize;
+		parameters._max_size = image.maxSize;
+		
+		if (matchRequest)
+		{
+			// Stored data must contain all requested facets
+			// and be detected with parameters covering filter
+			if ((image.facets & m_requested) != m_requested
+			    || !covers(parameters, m_filter))
+			{
+				return false;
+			}
+		} else
+		{
+			m_faceApi->setMinSize(image.minSize);
+			m_faceApi->setMaxSize(image.maxSize);
+			m_faceApi->setThreshold(image.threshold);
+			m_requested = image.facets;
+			m_filter = parameters;
+		}
+		
+		clearResults();
+		m_parameters = parameters;
+		m_faces = image.faces;
+		m_facets = image.facets;
+		m_hasResults = true;
+		m_pending = false;
+		m_fetched = true;
+		
+		// Dataset may be indexed on opening already
+		if (!g_faceIndex->contains(m_file))
+		{
+			g_faceIndex->insert(m_file, m_faces, m_facets);
+		}
+		
+		if (!g_statistics->contains(m_file))
+		{
+			g_statistics->insert(m_file, m_faces, m_facets);
+		}
+		return true;
+	}
+	
+	void FaceDetector::clearResults()
+	{
+		m_faces.clear();
+		m_facets = NoFacets;
+		m_hasResults = false;
+	}
+	
+	bool FaceDetector::covers(const DetectData& held, const DetectData& filter)
+	{
+		return held._face == filter._face
+		       && effectiveThreshold(filter._threshold) >= effectiveThreshold(held._threshold)
+		       && filter._min_size >= held._min_size
+		       && (held._max_size == 0
+		           || (filter._max_size != 0 && filter._max_size <= held._max_size));
+	}
+	
+	void FaceDetector::store()
+	{
+		QFileInfo info(m_file);
+		ResultsStore::Image image;
+		
+		// Results for user-defined face box don't describe
+		// the image, don't keep them
+		if (!m_parameters.isFaceEmpty() || !m_hasResults)
+		{
+			return;
+		}
+		
+		image.path = m_file;
+		image.modified = info.lastModified().toMSecsSinceEpoch();
+		image.size = info.size();
+		image.facets = m_facets;
+		image.threshold = m_parameters._threshold;
+		image.minSize = m_parameters._min_size;
+		image.maxSize = m_parameters._max_size;
+		image.faces = m_faces;
+		
+		ResultsStore::forImage(m_file)->insert(image);
+		g_faceIndex->insert(m_file, m_faces, m_facets);
+		g_statistics->insert(m_file, m_faces, m_facets);
 	}
 	
 	void FaceDetector::refetch(bool refetch, const ControlData& controlData)
 	{
-		m_fetched = !refetch;                                   // Values changed, try to send new request
-		m_faceApi->setDemographics(controlData._demographics);  // Get from \c Controls class : checked?
-		m_faceApi->setAttributes(controlData._attributes);      // Get from \c Controls class : checked?
-		m_faceApi->setLandmarks(controlData._landmarks);        // Get from \c Controls class : checked?
-		m_faceApi->setFace1(controlData._face);                 // if enabled, minsize and maxsize automatically
-		// will be disabled (API)
-		m_faceApi->setMinSize(controlData._min_size);           // empty if face != NULL
-		m_faceApi->setMaxSize(controlData._max_size);           // empty if face != NULL
-		m_faceApi->setThreshold(controlData._threshold);        // empty if face != NULL
+		m_requested = controlData.facets();                     // Get from \c Controls class : checked?
+		m_filter = controlData;
+		
+		if (refetch && !covers(m_filter))
+		{
+			// Held faces can't be filtered to requested ones
+			DetectData request = m_filter;
+			
+			if (controlData._superset && request.isFaceEmpty())
+			{
+				// Fetch every candidate face once, threshold and
+				// sizes are then applied locally
+				request._threshold = qMin(effectiveThreshold(request._threshold),
+				                          FaceApi::SupersetThreshold);
+				request._min_size = 0;
+				request._max_size = 0;
+			}
+			
+			m_faceApi->setFace1(request._face);                 // if enabled, minsize and maxsize automatically
+			// will be disabled (API)
+			m_faceApi->setMinSize(request._min_size);           // empty if face != NULL
+			m_faceApi->setMaxSize(request._max_size);           // empty if face != NULL
+			m_faceApi->setThreshold(request._threshold);        // empty if face != NULL
+			
+			// Parameters as accepted by FaceApi
+			clearResults();
+			m_parameters = DetectData();
+			m_parameters.set(m_faceApi->getFace());
+			m_parameters._min_size = m_faceApi->getMinSize();
+			m_parameters._max_size = m_faceApi->getMaxSize();
+			m_parameters._threshold = m_faceApi->getThreshold();
+		} else
+		{
+			// Facet-only request must cover the same
+			// region as held results
+			m_faceApi->setFace1(m_parameters._face);
+		}
+		
+		// Narrowing change is served from held data, widening
+		// one requests only facets that aren't held yet
+		const Facets missing = m_requested & ~m_facets;
+		m_faceApi->setDemographics(missing & DemographicsFacet);
+		m_faceApi->setAttributes(missing & AttributesFacet);
+		m_faceApi->setLandmarks(missing & LandmarksFacet);
+		
+		m_fetched = !refetch || (m_hasResults && missing == NoFacets);
 		
 		fetch();                                                // update values with new ones,
 		// called from parent
@@ -244,12 +609,14 @@ namespace Tevian
 	
 	/// JsonReader
 	JsonReader::JsonReader()
-			: m_document { }
+			: m_document { },
+			  m_face { }
 	{ }
 	
 	void JsonReader::setDocument(const QJsonDocument& document)
 	{
 		m_document = document;
+		m_face = 0;
 	}
 	
 	bool JsonReader::isReady()
@@ -257,26 +624,63 @@ namespace Tevian
 		return !m_document.isEmpty();
 	}
 	
-	void JsonReader::read(QString jsonKey, QJsonValue& value)
+	int JsonReader::faceCount() const
+	{
+		return faces().size();
+	}
+	
+	void JsonReader::setFace(int index)
+	{
+		m_face = index;
+	}
+	
+	QJsonArray JsonReader::faces() const
 	{
 		if (!m_document.isEmpty())
 		{
-			for (const auto& valueRef : m_document.object())
+			const auto response = m_document.object();
+			const auto key = facesKey(response);
+			
+			if (!key.isEmpty())
 			{
-				for (const auto& d2 : valueRef.toArray())
-				{
-					if (!d2.toObject().value(jsonKey).isUndefined())
-					{
-						value = d2.toObject().value(jsonKey);
-						
-					} else
-					{
-						// Inform readObject and readArray that key doesn't exist
-						value = QJsonValue(QJsonValue::Undefined);
-					}
-				}
+				return response.value(key).toArray();
+			}
+		}
+		return QJsonArray();
+	}
+	
+	QString
+	JsonReader::facesKey(const QJsonObject& response)
+	{
+		for (auto value = response.constBegin(); value != response.constEnd(); ++value)
+		{
+			if (value.value().isArray())
+			{
+				return value.key();
 			}
 		}
+		return QString();
+	}
+	
+	void JsonReader::read(QString jsonKey, QJsonValue& value)
+	{
+		const auto data = faces();
+		
+		// Inform readObject and readArray that key doesn't exist
+		value = QJsonValue(QJsonValue::Undefined);
+		
+		if (m_face >= 0 && m_face < data.size())
+		{
+			value = data.at(m_face).toObject().value(jsonKey);
+		}
+	}
+	
+	QJsonValue
+	JsonReader::readValue(QString jsonKey)
+	{
+		QJsonValue value;
+		read(jsonKey, value);
+		return value;
 	}
 	
 	VariantMultiMap
@@ -5,12 +5,13 @@
 #pragma once
 
 
+#include <map>
 #include <memory>
-#include <unordered_map>
 
 #include "Commons.hpp"
 #include "FaceApi.hpp"
 #include "Settings.hpp"
+#include "StringTable.hpp"
 
 #include <QHash>
 #include <QRect>
@@ -28,37 +29,18 @@ namespace Tevian
 	{
 		/// FaceDetector parameters
 		
-		/**
-		 * \brief Used to save parameters like the
-		 * number and the values of landmark keys,
-		 * face bounding box coordinates.
-		 * */
-		struct FaceParameters
-		{
-			//! Number of landmark points
-			int landmarkSize;
-			
-			//! Rectangle of face coordinates
-			FaceData::face_array face_bounds;
-			
-			//! Vector of face points
-			QVector<QPointF> landmarks;
-			
-			FaceParameters() = default;
-		};
-		
 		struct Demographics
 		{
 			explicit Demographics(qreal mean = 0.0, qreal variance = 0.0,
-			                      QString gender = QString(),
-			                      QString ethnicity = QString()) Q_DECL_NOEXCEPT;
+			                      const QString& gender = QString(),
+			                      const QString& ethnicity = QString()) Q_DECL_NOEXCEPT;
 			
 			
-			//! Ethnicity of person
-			QString _ethnicity;
+			//! Ethnicity of person, code in \c StringTable
+			StringCode _ethnicity;
 			
-			//! Gender of person
-			QString _gender;
+			//! Gender of person, code in \c StringTable
+			StringCode _gender;
 			
 			//! id number of person.
 			//! Must be unique
@@ -78,21 +60,127 @@ namespace Tevian
 				qreal _variance;
 			} _age;
 			
-			inline QString getEthnicity() const
+			inline const QString& getEthnicity() const
 			{
-				return _ethnicity;
+				return g_stringTable->string(_ethnicity);
 			}
 			
-			inline QString getGender() const
+			inline const QString& getGender() const
 			{
-				return _gender;
+				return g_stringTable->string(_gender);
 			}
 			
 			QString getAsText() const;
 		};
 		
-		using Attributes = std::unordered_map<std::string, std::string>;
+		/**
+		 * \brief Interned attribute of face.
+		 * */
+		struct Attribute
+		{
+			StringCode key;
+			
+			StringCode value;
+		};
+		
+		/**
+		 * \brief Face attributes as pairs of \c StringTable
+		 * codes sorted by key.
+		 *
+		 * \details Faces of one response share the same
+		 * handful of keys and values, so strings are kept
+		 * once in table and lookup by code is binary search
+		 * over a few integers.
+		 * */
+		class TEVIAN_API Attributes
+		{
+		public:
+			using const_iterator = QVector<Attribute>::const_iterator;
+			
+			/**
+			 * \brief Adds attribute or replaces value
+			 * of existing one.
+			 * */
+			void set(StringCode key, StringCode value);
+			
+			void set(const QString& key, const QString& value);
+			
+			/**
+			 * \returns Value code of key or
+			 * \c StringTable::Empty if there's no such key.
+			 * */
+			StringCode value(StringCode key) const;
+			
+			/**
+			 * \returns Value of key or empty string.
+			 * */
+			const QString&
+			value(const QString& key) const;
+			
+			bool contains(StringCode key) const;
+			
+			inline int size() const
+			{
+				return m_items.size();
+			}
+			
+			inline bool empty() const
+			{
+				return m_items.isEmpty();
+			}
+			
+			inline void clear()
+			{
+				m_items.clear();
+			}
+			
+			inline const_iterator begin() const
+			{
+				return m_items.cbegin();
+			}
+			
+			inline const_iterator end() const
+			{
+				return m_items.cend();
+			}
+		
+		private:
+			const_iterator lowerBound(StringCode key) const;
 		
+		private:
+			QVector<Attribute> m_items;
+		};
+		
+		/**
+		 * \brief Used to save detection result of one face:
+		 * bounding box coordinates, score, landmark points,
+		 * demographics and attributes.
+		 * */
+		struct Face
+		{
+			//! Rectangle of face coordinates: x, y, width, height
+			FaceData::face_array bounds = FaceData::face_array();
+			
+			//! Detection score
+			float score = 0.0;
+			
+			//! Vector of face points
+			QVector<QPointF> landmarks;
+			
+			//! Demographics information
+			Demographics demographics;
+			
+			Attributes attributes;
+			
+			/**
+			 * \returns Face size compared with \c fd_min_size
+			 * and \c fd_max_size, the larger side of bounding box.
+			 * */
+			inline int size() const
+			{
+				return qMax(bounds[2], bounds[3]);
+			}
+		};
 	}
 	
 	class JsonReader;
@@ -138,6 +226,20 @@ namespace Tevian
 		 * */
 		bool fetch();
 		
+		/**
+		 * \brief Loads results stored by previous session.
+		 *
+		 * \returns true if image has results in
+		 * \c ResultsStore and the file didn't change since.
+		 *
+		 * \details No request is sent to server, stored
+		 * facets and detection parameters are applied to
+		 * \c FaceApi, so the next \c refetch with the same
+		 * values reuses stored data. Caller shows them by
+		 * \c getFilter and \c getFacets.
+		 * */
+		bool restore();
+		
 		/**
 		 * \brief Reads all enabled values.
 		 *
@@ -149,7 +251,56 @@ namespace Tevian
 		void run();
 		
 		/**
-		 * \returns Face landmarks.
+		 * \returns Facets requested by the last \c refetch
+		 * that detector holds results for.
+		 * */
+		Facets getFacets() const;
+		
+		/**
+		 * \returns true if detector holds results for
+		 * the last requested parameters.
+		 * */
+		bool hasResults() const;
+		
+		/**
+		 * \returns All faces held by detector, including
+		 * ones hidden by local filter.
+		 * */
+		const QVector<Details::Face>&
+		getAllFaces() const;
+		
+		/**
+		 * \returns Faces passing local threshold and
+		 * face size filter.
+		 * */
+		QVector<Details::Face>
+		getFaces() const;
+		
+		/**
+		 * \returns true if held faces are detected with
+		 * parameters not stricter than \c filter, thus
+		 * filter can be applied locally.
+		 * */
+		bool covers(const DetectData& filter) const;
+		
+		/**
+		 * \brief Applies threshold and face size limits
+		 * to held faces, no request is sent.
+		 *
+		 * \returns false if filter is out of held
+		 * results. \see covers
+		 * */
+		bool setFilter(const DetectData& filter);
+		
+		/**
+		 * \returns Threshold and face size limits applied
+		 * to held faces.
+		 * */
+		const DetectData&
+		getFilter() const;
+		
+		/**
+		 * \returns Face landmarks of the first shown face.
 		 *
 		 * \note May return empty data, if option
 		 * landmarks disabled or fetch not called first.
@@ -165,6 +316,15 @@ namespace Tevian
 		
 		const Details::Demographics&
 		getDemographics() const;
+		
+		/**
+		 * \brief Reads faces of detect response without
+		 * detector, e.g. of responses got by \c BatchDetector.
+		 *
+		 * \param facets Facets requested with response
+		 * */
+		static QVector<Details::Face>
+		readFaces(const QJsonDocument& document, Facets facets);
 	
 	private:
 		void init(Client::FaceApi* api = nullptr);
@@ -174,30 +334,67 @@ namespace Tevian
 		 * attributes like dress, glasses,
 		 * hair color etc.
 		 * */
-		void readAttributes();
+		static void readAttributes(JsonReader& reader, Details::Face& face);
 		
 		/**
 		 * \brief reads and stores person
-		 * face bounding rectangle.
+		 * face bounding rectangle and score.
 		 * */
-		void readBoundingBox();
+		static void readBoundingBox(JsonReader& reader, Details::Face& face);
 		
 		/**
 		 * \brief reads and stores person
-		 * face landmarks and their number.
+		 * face landmarks.
+		 * */
+		static void readFacelandmarks(JsonReader& reader, Details::Face& face);
+		
+		static void readDemographics(JsonReader& reader, Details::Face& face);
+		
+		/**
+		 * \returns First face passing the filter or
+		 * empty face if there's none.
+		 * */
+		const Details::Face&
+		primaryFace() const;
+		
+		/**
+		 * \returns true if face passes local filter.
+		 * */
+		bool passes(const Details::Face& face) const;
+		
+		/**
+		 * \brief Reads stored results if they satisfy
+		 * current request.
 		 *
-		 * \note
+		 * \param matchRequest If false stored results
+		 * are accepted whatever request parameters are.
 		 * */
-		void readFacelandmarks();
+		bool restore(bool matchRequest);
 		
-		void readDemographics();
+		/**
+		 * \brief Saves read results to \c ResultsStore
+		 * of image's directory.
+		 * */
+		void store();
+		
+		/**
+		 * \brief Drops held results and facets.
+		 * */
+		void clearResults();
+		
+		/**
+		 * \returns true if \c held parameters detect
+		 * every face that \c filter does.
+		 * */
+		static bool covers(const DetectData& held, const DetectData& filter);
 	
 	public slots:
 		
 		/**
 		 * \note Called when control changes current values
-		 * of \c FaceApi, then class resets old data and updates
-		 * with new ones.
+		 * of \c FaceApi. If detection parameters changed class
+		 * resets old data and updates with new ones, otherwise
+		 * only facets that aren't held are requested.
 		 * */
 		void refetch(bool, const ControlData& = ControlData());
 	
@@ -209,17 +406,34 @@ namespace Tevian
 		//! Parser
 		JsonReader* m_reader;
 		
-		//! Face parameters
-		Details::FaceParameters m_face;
-		
-		//! Demographics information
-		Details::Demographics m_demographics;
-		
-		Details::Attributes m_attributes;
+		//! Detected faces
+		QVector<Details::Face> m_faces;
 		
 		Client::FaceApi* m_faceApi;
 		
 		bool m_fetched;
+		
+		//! Set if response isn't read yet
+		bool m_pending;
+		
+		//! Set if detector holds results of \c m_parameters
+		bool m_hasResults;
+		
+		//! Facets detector holds results for
+		Facets m_facets;
+		
+		//! Facets requested from \c Controls
+		Facets m_requested;
+		
+		//! Facets of the pending response
+		Facets m_unread;
+		
+		//! Parameters held results are detected with
+		DetectData m_parameters;
+		
+		//! Parameters requested from \c Controls,
+		//! applied locally to held faces
+		DetectData m_filter;
 	};
 	
 	/**
@@ -243,6 +457,25 @@ namespace Tevian
 		 * */
 		bool isReady();
 		
+		/**
+		 * \returns Number of faces in document.
+		 * */
+		int faceCount() const;
+		
+		/**
+		 * \brief Selects face which data will
+		 * be read.
+		 * */
+		void setFace(int index);
+		
+		/**
+		 * \brief read single json value
+		 *
+		 * \returns Undefined value if key doesn't exist.
+		 * */
+		QJsonValue
+		readValue(QString jsonKey);
+		
 		/**
 		 * \brief read json array.
 		 *
@@ -268,6 +501,13 @@ namespace Tevian
 		 * */
 		VariantMultiMap
 		readObject(QString jsonKey);
+		
+		/**
+		 * \returns Key of faces array in detect response,
+		 * empty if response has none.
+		 * */
+		static QString
+		facesKey(const QJsonObject& response);
 	
 	private:
 		/**
@@ -277,11 +517,18 @@ namespace Tevian
 		 * \param jsonKey key of data to read.
 		 * */
 		void read(QString jsonKey, QJsonValue& value);
+		
+		/**
+		 * \returns Array of detected faces.
+		 * */
+		QJsonArray faces() const;
 	
 	private:
 		QJsonValue m_jsonValue;
 		
 		QJsonDocument m_document;
+		
+		int m_face;
 	};
 }
 
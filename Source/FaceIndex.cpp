@@ -0,0 +1,586 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "FaceIndex.hpp"
+#include "ResultsStore.hpp"
+
+#include <cmath>
+
+#include <QDir>
+#include <QRegExp>
+#include <QFileInfo>
+
+
+namespace Tevian
+{
+	using namespace Details;
+	
+	namespace
+	{
+		const int WordBits = 64;
+		
+		//! Age buckets of 5 years up to 120
+		const float AgeBucketWidth = 5.0f;
+		const int AgeBucketCount = 24;
+		
+		//! Score buckets of 0.05 in [0, 1]
+		const float ScoreBucketWidth = 0.05f;
+		const int ScoreBucketCount = 20;
+		
+		const float NoValue = std::numeric_limits<float>::quiet_NaN();
+		
+		//! Dead rows kept before compaction is considered
+		const int MinDeadRows = 4096;
+		
+		QString normalizePath(const QString& path)
+		{
+			return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+		}
+		
+		int wordCount(int size)
+		{
+			return (size + WordBits - 1) / WordBits;
+		}
+	}
+	
+	/// Bitmap
+	Bitmap::Bitmap(int size, bool value)
+			: m_words(wordCount(size), value ? ~quint64(0) : quint64(0)),
+			  m_size { size }
+	{
+		// Keep bits past size unset, count relies on it
+		if (value && size % WordBits)
+		{
+			m_words.last() &= (quint64(1) << (size % WordBits)) - 1;
+		}
+	}
+	
+	int Bitmap::size() const
+	{
+		return m_size;
+	}
+	
+	void Bitmap::resize(int size)
+	{
+		if (size > m_size)
+		{
+			m_words.resize(wordCount(size));
+			m_size = size;
+		}
+	}
+	
+	void Bitmap::set(int index, bool value)
+	{
+		if (index >= m_size)
+		{
+			if (!value)
+			{
+				return;
+			}
+			resize(index + 1);
+		}
+		
+		const auto mask = quint64(1) << (index % WordBits);
+		
+		if (value)
+		{
+			m_words[index / WordBits] |= mask;
+		} else
+		{
+			m_words[index / WordBits] &= ~mask;
+		}
+	}
+	
+	bool Bitmap::test(int index) const
+	{
+		return index >= 0 && index < m_size
+		       && (m_words.at(index / WordBits) >> (index % WordBits)) & 1;
+	}
+	
+	int Bitmap::count() const
+	{
+		int count = 0;
+		
+		for (auto word : m_words)
+		{
+			count += int(qPopulationCount(word));
+		}
+		return count;
+	}
+	
+	Bitmap& Bitmap::operator&=(const Bitmap& other)
+	{
+		const int common = qMin(m_words.size(), other.m_words.size());
+		
+		for (int i = 0; i < common; ++i)
+		{
+			m_words[i] &= other.m_words.at(i);
+		}
+		
+		for (int i = common; i < m_words.size(); ++i)
+		{
+			m_words[i] = 0;
+		}
+		return *this;
+	}
+	
+	Bitmap& Bitmap::operator|=(const Bitmap& other)
+	{
+		resize(other.m_size);
+		
+		for (int i = 0; i < other.m_words.size(); ++i)
+		{
+			m_words[i] |= other.m_words.at(i);
+		}
+		return *this;
+	}
+	
+	/// NumericColumn
+	NumericColumn::NumericColumn(float bucketWidth, int bucketCount)
+			: m_bucketWidth { bucketWidth },
+			  m_values { },
+			  m_buckets(bucketCount)
+	{ }
+	
+	void NumericColumn::append(float value)
+	{
+		const int row = m_values.size();
+		m_values.push_back(value);
+		
+		if (!std::isnan(value))
+		{
+			m_buckets[bucket(value)].set(row);
+		}
+	}
+	
+	float NumericColumn::at(int row) const
+	{
+		return m_values.at(row);
+	}
+	
+	int NumericColumn::size() const
+	{
+		return m_values.size();
+	}
+	
+	Bitmap NumericColumn::range(float minimum, float maximum,
+	                            bool exclusiveMinimum, bool exclusiveMaximum) const
+	{
+		Bitmap rows(m_values.size());
+		
+		if (minimum > maximum || (minimum == maximum && (exclusiveMinimum || exclusiveMaximum)))
+		{
+			return rows;
+		}
+		
+		const int first = bucket(minimum);
+		const int last = bucket(maximum);
+		
+		// Inner buckets lie in range entirely
+		for (int i = first + 1; i < last; ++i)
+		{
+			rows |= m_buckets.at(i);
+		}
+		
+		auto compare = [ & ](int row)
+		{
+			const auto value = m_values.at(row);
+			if ((exclusiveMinimum ? value > minimum : value >= minimum)
+			    && (exclusiveMaximum ? value < maximum : value <= maximum))
+			{
+				rows.set(row);
+			}
+		};
+		
+		m_buckets.at(first).forEach(compare);
+		if (last != first)
+		{
+			m_buckets.at(last).forEach(compare);
+		}
+		return rows;
+	}
+	
+	int NumericColumn::bucket(float value) const
+	{
+		const auto index = std::floor(value / m_bucketWidth);
+		return int(qBound(0.0f, index, float(m_buckets.size() - 1)));
+	}
+	
+	/// FaceQuery
+	bool FaceQuery::parse(const QString& text, FaceQuery& query, QString* error)
+	{
+		static const QRegExp condition("([^<>=]+)(<=|>=|<|>|=)(.+)");
+		
+		query = FaceQuery();
+		
+		for (const auto& token : text.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts))
+		{
+			auto pattern = condition;
+			if (!pattern.exactMatch(token))
+			{
+				if (error)
+				{
+					*error = QString("Can't parse condition %1").arg(token);
+				}
+				return false;
+			}
+			
+			const auto key = pattern.cap(1).trimmed().toLower();
+			const auto operation = pattern.cap(2);
+			const auto value = pattern.cap(3).trimmed();
+			
+			if (key == "age" || key == "score")
+			{
+				float* minimum = key == "age" ? &query.minAge : &query.minScore;
+				float* maximum = key == "age" ? &query.maxAge : &query.maxScore;
+				bool* exclusiveMinimum = key == "age" ? &query.exclusiveMinAge : &query.exclusiveMinScore;
+				bool* exclusiveMaximum = key == "age" ? &query.exclusiveMaxAge : &query.exclusiveMaxScore;
+				
+				// Range is taken by = only
+				const auto bounds = value.split("..");
+				bool ok = bounds.size() == 1 || (bounds.size() == 2 && operation == "=");
+				float first = 0;
+				float last = 0;
+				
+				if (ok)
+				{
+					first = last = bounds.first().toFloat(&ok);
+				}
+				if (ok && bounds.size() == 2)
+				{
+					last = bounds.last().toFloat(&ok);
+				}
+				
+				if (!ok)
+				{
+					if (error)
+					{
+						*error = QString("Can't parse %1 of %2").arg(value, key);
+					}
+					return false;
+				}
+				
+				if (operation == "=" || operation.startsWith('>'))
+				{
+					*minimum = first;
+					*exclusiveMinimum = operation == ">";
+				}
+				if (operation == "=" || operation.startsWith('<'))
+				{
+					*maximum = last;
+					*exclusiveMaximum = operation == "<";
+				}
+			} else if (operation != "=")
+			{
+				if (error)
+				{
+					*error = QString("Only = applies to %1").arg(key);
+				}
+				return false;
+			} else if (key == "gender")
+			{
+				query.gender = value;
+			} else if (key == "ethnicity")
+			{
+				query.ethnicity = value;
+			} else
+			{
+				query.attributes.push_back({ pattern.cap(1).trimmed(), value });
+			}
+		}
+		return true;
+	}
+	
+	/// FaceIndex
+	FaceIndex::FaceIndex()
+			: m_alive { },
+			  m_rows { },
+			  m_images { },
+			  m_imageIds { },
+			  m_imageRows { },
+			  m_attributes { },
+			  m_genders { },
+			  m_ethnicities { },
+			  m_age(AgeBucketWidth, AgeBucketCount),
+			  m_score(ScoreBucketWidth, ScoreBucketCount)
+	{ }
+	
+	FaceIndex*
+	FaceIndex::getFaceIndex()
+	{
+		static FaceIndex instance;
+		return &instance;
+	}
+	
+	void FaceIndex::insert(const QString& image, const QVector<Face>& faces, Facets facets)
+	{
+		const auto path = normalizePath(image);
+		QWriteLocker locker(&m_lock);
+		
+		removeRows(path);
+		
+		auto found = m_imageIds.constFind(path);
+		quint32 id = 0;
+		
+		if (found != m_imageIds.constEnd())
+		{
+			id = found.value();
+		} else
+		{
+			id = quint32(m_images.size());
+			m_images.push_back(path);
+			m_imageRows.push_back({ 0, 0 });
+			m_imageIds.insert(path, id);
+		}
+		
+		const bool demographics = facets & DemographicsFacet;
+		const int first = m_rows.size();
+		
+		for (int i = 0; i < faces.size(); ++i)
+		{
+			const auto& face = faces.at(i);
+			const int row = m_rows.size();
+			
+			m_rows.push_back({ id, quint16(i) });
+			m_alive.set(row);
+			
+			for (const auto& attribute : face.attributes)
+			{
+				m_attributes[attributeKey(attribute.key, attribute.value)].set(row);
+			}
+			
+			if (demographics)
+			{
+				m_genders[face.demographics._gender].set(row);
+				m_ethnicities[face.demographics._ethnicity].set(row);
+			}
+			
+			m_age.append(demographics ? float(face.demographics._age._mean) : NoValue);
+			m_score.append(face.score);
+		}
+		
+		m_imageRows[int(id)] = { first, faces.size() };
+		compact();
+	}
+	
+	int FaceIndex::insert(const ResultsStore& store)
+	{
+		const auto images = store.currentImages();
+		
+		for (const auto& image : images)
+		{
+			insert(image.path, image.faces, image.facets);
+		}
+		return images.size();
+	}
+	
+	void FaceIndex::remove(const QString& image)
+	{
+		const auto path = normalizePath(image);
+		QWriteLocker locker(&m_lock);
+		
+		removeRows(path);
+		m_imageIds.remove(path);
+		compact();
+	}
+	
+	bool FaceIndex::contains(const QString& image) const
+	{
+		const auto path = normalizePath(image);
+		QReadLocker locker(&m_lock);
+		
+		return m_imageIds.contains(path);
+	}
+	
+	int FaceIndex::size() const
+	{
+		QReadLocker locker(&m_lock);
+		return m_alive.count();
+	}
+	
+	Bitmap FaceIndex::query(const FaceQuery& query) const
+	{
+		QReadLocker locker(&m_lock);
+		Bitmap rows = m_alive;
+		
+		for (const auto& attribute : query.attributes)
+		{
+			// Strings that were never interned match no face,
+			// their lookup yields NoCode which has no bitmap
+			const auto key = g_stringTable->find(attribute.first);
+			const auto value = g_stringTable->find(attribute.second);
+			
+			if (key == StringTable::NoCode || value == StringTable::NoCode)
+			{
+				return Bitmap(m_alive.size());
+			}
+			rows &= bitmap(m_attributes, attributeKey(key, value));
+		}
+		
+		if (!query.gender.isEmpty())
+		{
+			rows &= bitmap(m_genders, g_stringTable->find(query.gender));
+		}
+		
+		if (!query.ethnicity.isEmpty())
+		{
+			rows &= bitmap(m_ethnicities, g_stringTable->find(query.ethnicity));
+		}
+		
+		const FaceQuery any { };
+		
+		if (query.minAge != any.minAge || query.maxAge != any.maxAge)
+		{
+			rows &= m_age.range(query.minAge, query.maxAge, query.exclusiveMinAge, query.exclusiveMaxAge);
+		}
+		
+		if (query.minScore != any.minScore || query.maxScore != any.maxScore)
+		{
+			rows &= m_score.range(query.minScore, query.maxScore,
+			                      query.exclusiveMinScore, query.exclusiveMaxScore);
+		}
+		return rows;
+	}
+	
+	QVector<FaceHit>
+	FaceIndex::hits(const Bitmap& rows) const
+	{
+		QReadLocker locker(&m_lock);
+		QVector<FaceHit> hits { };
+		hits.reserve(rows.count());
+		
+		rows.forEach([ & ](int row)
+		             {
+			             if (row < m_rows.size())
+			             {
+				             const auto& entry = m_rows.at(row);
+				             hits.push_back({ m_images.at(int(entry.first)), entry.second });
+			             }
+		             });
+		return hits;
+	}
+	
+	void FaceIndex::clear()
+	{
+		QWriteLocker locker(&m_lock);
+		
+		m_alive = Bitmap();
+		m_rows.clear();
+		m_images.clear();
+		m_imageIds.clear();
+		m_imageRows.clear();
+		m_attributes.clear();
+		m_genders.clear();
+		m_ethnicities.clear();
+		m_age = NumericColumn(AgeBucketWidth, AgeBucketCount);
+		m_score = NumericColumn(ScoreBucketWidth, ScoreBucketCount);
+	}
+	
+	quint64 FaceIndex::attributeKey(StringCode key, StringCode value)
+	{
+		return (quint64(key) << 32) | value;
+	}
+	
+	void FaceIndex::removeRows(const QString& image)
+	{
+		auto found = m_imageIds.constFind(image);
+		
+		if (found == m_imageIds.constEnd())
+		{
+			return;
+		}
+		
+		// Rows stay in columns but no longer match
+		// until compact() drops them
+		const auto& rows = m_imageRows.at(int(found.value()));
+		
+		for (int row = rows.first; row < rows.first + rows.second; ++row)
+		{
+			m_alive.set(row, false);
+		}
+	}
+	
+	void FaceIndex::compact()
+	{
+		const int alive = m_alive.count();
+		const int dead = m_rows.size() - alive;
+		
+		if (dead < MinDeadRows || dead < alive)
+		{
+			return;
+		}
+		
+		// Live rows keep their order, so rows of
+		// every image stay contiguous
+		QVector<int> remap(m_rows.size(), -1);
+		int next = 0;
+		m_alive.forEach([ & ](int row)
+		                {
+			                remap[row] = next++;
+		                });
+		
+		auto pack = [ & ](const Bitmap& rows)
+		{
+			Bitmap packed(alive);
+			rows.forEach([ & ](int row)
+			             {
+				             if (row < remap.size() && remap.at(row) >= 0)
+				             {
+					             packed.set(remap.at(row));
+				             }
+			             });
+			return packed;
+		};
+		
+		auto packAll = [ & ](auto& bitmaps)
+		{
+			for (auto entry = bitmaps.begin(); entry != bitmaps.end();)
+			{
+				entry.value() = pack(entry.value());
+				entry = entry.value().count() ? std::next(entry) : bitmaps.erase(entry);
+			}
+		};
+		
+		packAll(m_attributes);
+		packAll(m_genders);
+		packAll(m_ethnicities);
+		
+		// Removed images are dropped, ids of others change
+		QVector<QString> images { };
+		QVector<QPair<int, int>> imageRows { };
+		QVector<quint32> ids(m_images.size(), 0);
+		
+		for (auto entry = m_imageIds.begin(); entry != m_imageIds.end(); ++entry)
+		{
+			const auto& rows = m_imageRows.at(int(entry.value()));
+			const auto id = quint32(images.size());
+			
+			ids[int(entry.value())] = id;
+			images.push_back(entry.key());
+			imageRows.push_back({ rows.second > 0 ? remap.at(rows.first) : 0, rows.second });
+			entry.value() = id;
+		}
+		
+		QVector<QPair<quint32, quint16>> rows { };
+		NumericColumn age(AgeBucketWidth, AgeBucketCount);
+		NumericColumn score(ScoreBucketWidth, ScoreBucketCount);
+		rows.reserve(alive);
+		
+		m_alive.forEach([ & ](int row)
+		                {
+			                const auto& entry = m_rows.at(row);
+			                rows.push_back({ ids.at(int(entry.first)), entry.second });
+			                age.append(m_age.at(row));
+			                score.append(m_score.at(row));
+		                });
+		
+		m_rows = rows;
+		m_images = images;
+		m_imageRows = imageRows;
+		m_age = age;
+		m_score = score;
+		m_alive = Bitmap(alive, true);
+	}
+}
\ No newline at end of file
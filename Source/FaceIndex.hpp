@@ -0,0 +1,309 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <limits>
+
+#include "Commons.hpp"
+#include "FaceDetector.hpp"
+#include "StringTable.hpp"
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QtAlgorithms>
+#include <QReadWriteLock>
+
+
+namespace Tevian
+{
+	class ResultsStore;
+	
+	namespace Details
+	{
+		/**
+		 * \brief Fixed set of face rows, one bit per row.
+		 *
+		 * \details Operands of different sizes are treated
+		 * as if missing bits were zero.
+		 * */
+		class TEVIAN_API Bitmap
+		{
+		public:
+			explicit Bitmap(int size = 0, bool value = false);
+			
+			int size() const;
+			
+			/**
+			 * \brief Grows bitmap, new bits are unset.
+			 * */
+			void resize(int size);
+			
+			void set(int index, bool value = true);
+			
+			bool test(int index) const;
+			
+			/**
+			 * \returns Number of set bits.
+			 * */
+			int count() const;
+			
+			Bitmap& operator&=(const Bitmap& other);
+			
+			Bitmap& operator|=(const Bitmap& other);
+			
+			/**
+			 * \brief Calls \c function with index
+			 * of every set bit in ascending order.
+			 * */
+			template<typename Function>
+			void forEach(Function function) const
+			{
+				for (int i = 0; i < m_words.size(); ++i)
+				{
+					auto word = m_words.at(i);
+					
+					while (word)
+					{
+						function(i * 64 + int(qCountTrailingZeroBits(word)));
+						word &= word - 1;
+					}
+				}
+			}
+		
+		private:
+			QVector<quint64> m_words;
+			
+			int m_size;
+		};
+		
+		/**
+		 * \brief Numeric column of face rows with
+		 * bucket bitmaps for range queries.
+		 *
+		 * \details Range is answered by joining bitmaps of
+		 * buckets lying inside it, only rows of two edge
+		 * buckets are compared by value. Values out of
+		 * bucket range fall into first or last bucket,
+		 * NaN values are kept but never match.
+		 * */
+		class TEVIAN_API NumericColumn
+		{
+		public:
+			NumericColumn(float bucketWidth, int bucketCount);
+			
+			/**
+			 * \brief Appends value of next row.
+			 * */
+			void append(float value);
+			
+			float at(int row) const;
+			
+			int size() const;
+			
+			/**
+			 * \returns Rows with value in [minimum, maximum],
+			 * bound is left out of range if it's exclusive.
+			 * */
+			Bitmap range(float minimum, float maximum,
+			             bool exclusiveMinimum = false, bool exclusiveMaximum = false) const;
+		
+		private:
+			int bucket(float value) const;
+		
+		private:
+			float m_bucketWidth;
+			
+			QVector<float> m_values;
+			
+			QVector<Bitmap> m_buckets;
+		};
+	}
+	
+	/**
+	 * \brief Conditions of face search, all given
+	 * conditions must be met.
+	 * */
+	struct FaceQuery
+	{
+		//! Attribute key and value pairs
+		QVector<QPair<QString, QString>> attributes;
+		
+		//! Empty string matches any gender
+		QString gender;
+		
+		//! Empty string matches any ethnicity
+		QString ethnicity;
+		
+		float minAge = std::numeric_limits<float>::lowest();
+		
+		float maxAge = std::numeric_limits<float>::max();
+		
+		float minScore = std::numeric_limits<float>::lowest();
+		
+		float maxScore = std::numeric_limits<float>::max();
+		
+		//! Bounds are inclusive unless set
+		bool exclusiveMinAge = false;
+		
+		bool exclusiveMaxAge = false;
+		
+		bool exclusiveMinScore = false;
+		
+		bool exclusiveMaxScore = false;
+		
+		/**
+		 * \brief Parses conditions separated by spaces or
+		 * commas, e.g. "glasses=yes gender=female
+		 * age=30..40 score>0.9".
+		 *
+		 * \details \c age and \c score take =, <, <=, >
+		 * and >= with a number, = also takes a range
+		 * "min..max". \c gender and \c ethnicity take =,
+		 * other keys are attributes.
+		 *
+		 * \param error Set to description of the first
+		 * condition that can't be parsed.
+		 * */
+		static bool parse(const QString& text, FaceQuery& query, QString* error = nullptr);
+	};
+	
+	/**
+	 * \brief Face found by \c FaceIndex.
+	 * */
+	struct FaceHit
+	{
+		QString image;
+		
+		//! Index of face in image's results
+		int face;
+	};
+	
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief In-memory index of detection results of all
+	 * processed images.
+	 *
+	 * \details Every face is a row. Attribute, gender and
+	 * ethnicity values have a bitmap of rows having them,
+	 * age mean and score are bucketed columns. Query joins
+	 * bitmaps of its conditions, so its cost depends on
+	 * number of rows in words, not on faces' data.
+	 * Index is updated when detector reads or restores
+	 * results: rows of image's previous results are masked
+	 * out and new ones are appended. Columns are rebuilt
+	 * without masked rows once they outnumber live ones.
+	 *
+	 * \note Index is thread safe.
+	 * */
+	class TEVIAN_API FaceIndex
+	{
+	public:
+		static FaceIndex*
+		getFaceIndex();
+		
+		/**
+		 * \brief Adds or replaces results of image.
+		 *
+		 * \param facets Facets faces hold, numeric
+		 * values of missing facets never match.
+		 * */
+		void insert(const QString& image, const QVector<Details::Face>& faces,
+		            Facets facets);
+		
+		/**
+		 * \brief Adds all current results of store.
+		 *
+		 * \returns Number of added images.
+		 * */
+		int insert(const ResultsStore& store);
+		
+		void remove(const QString& image);
+		
+		bool contains(const QString& image) const;
+		
+		/**
+		 * \returns Number of indexed faces.
+		 * */
+		int size() const;
+		
+		/**
+		 * \returns Rows of faces matching query.
+		 * */
+		Details::Bitmap
+		query(const FaceQuery& query) const;
+		
+		/**
+		 * \returns Images and face indexes of rows.
+		 * */
+		QVector<FaceHit>
+		hits(const Details::Bitmap& rows) const;
+		
+		void clear();
+	
+	private:
+		FaceIndex();
+		
+		/**
+		 * \returns Bitmap of \c key, empty one if
+		 * there's no such key.
+		 * */
+		template<typename Key>
+		static const Details::Bitmap&
+		bitmap(const QHash<Key, Details::Bitmap>& bitmaps, const Key& key)
+		{
+			static const Details::Bitmap empty { };
+			
+			auto found = bitmaps.constFind(key);
+			return found != bitmaps.constEnd() ? found.value() : empty;
+		}
+		
+		static quint64
+		attributeKey(StringCode key, StringCode value);
+		
+		void removeRows(const QString& image);
+		
+		/**
+		 * \brief Drops dead rows and removed images once
+		 * they are most of the index.
+		 * */
+		void compact();
+	
+	private:
+		mutable QReadWriteLock m_lock;
+		
+		//! Rows of current results
+		Details::Bitmap m_alive;
+		
+		//! Image and face index of row
+		QVector<QPair<quint32, quint16>> m_rows;
+		
+		QVector<QString> m_images;
+		
+		//! Image id and its first row and row count
+		QHash<QString, quint32> m_imageIds;
+		
+		QVector<QPair<int, int>> m_imageRows;
+		
+		//! Attribute bitmaps by key and value codes
+		QHash<quint64, Details::Bitmap> m_attributes;
+		
+		QHash<StringCode, Details::Bitmap> m_genders;
+		
+		QHash<StringCode, Details::Bitmap> m_ethnicities;
+		
+		Details::NumericColumn m_age;
+		
+		Details::NumericColumn m_score;
+		
+		Q_DISABLE_COPY(FaceIndex)
+	};
+	
+	static FaceIndex* g_faceIndex = FaceIndex::getFaceIndex();
+}
\ No newline at end of file
@@ -0,0 +1,496 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "FolderWatcher.hpp"
+#include "FaceDetector.hpp"
+#include "ResultsStore.hpp"
+#include "DirectoryScanner.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+
+namespace Tevian
+{
+	namespace
+	{
+		//! Milliseconds changes of directory are collected
+		//! before it's listed
+		const int ListDelay = 100;
+		
+		//! Listing may take this part of time at most
+		const int ListThrottle = 10;
+	}
+	
+	FolderWatcher::FolderWatcher(const Options& options, QObject* parent)
+			: QObject(parent),
+			  m_options { options },
+			  m_detector { options.detector },
+			  m_watcher { },
+			  m_notify { -1 },
+			  m_notifier { nullptr },
+			  m_watches { },
+			  m_listings { },
+			  m_changed { },
+			  m_candidates { },
+			  m_ready { },
+			  m_listTimer { },
+			  m_settleTimer { },
+			  m_flushTimer { },
+			  m_clock { },
+			  m_finishes { },
+			  m_submitted { 0 },
+			  m_detected { 0 },
+			  m_failed { 0 },
+			  m_stopped { false }
+	{
+		m_options.detector.concurrency = qMax(1, m_options.detector.concurrency);
+		
+		m_listTimer.setSingleShot(true);
+		m_listTimer.setInterval(ListDelay);
+		m_settleTimer.setInterval(qMax(ListDelay, m_options.settle / 4));
+		m_flushTimer.setInterval(m_options.flush);
+		
+		connect(&m_watcher, SIGNAL(directoryChanged(
+				                           const QString&)),
+		        this, SLOT(directoryChanged(
+				                   const QString&)));
+		connect(&m_listTimer, SIGNAL(timeout()), this, SLOT(listChanged()));
+		connect(&m_settleTimer, SIGNAL(timeout()), this, SLOT(checkSettling()));
+		connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+		
+		connect(&m_detector, SIGNAL(detected(
+				                            const QString&, const QJsonDocument&, qint64)),
+		        this, SLOT(storeResult(
+				                   const QString&, const QJsonDocument&, qint64)));
+		connect(&m_detector, SIGNAL(failed(
+				                            const QString&, const QString&, qint64)),
+		        this, SLOT(rejectFile(
+				                   const QString&, const QString&, qint64)));
+		connect(&m_detector, SIGNAL(finished()), this, SLOT(detectorFinished()));
+
+#ifdef Q_OS_LINUX
+		m_notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_notify >= 0)
+		{
+			m_notifier = new QSocketNotifier(m_notify, QSocketNotifier::Read, this);
+			connect(m_notifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+		}
+#endif
+	}
+	
+	FolderWatcher::~FolderWatcher()
+	{
+		flush();
+
+#ifdef Q_OS_LINUX
+		if (m_notify >= 0)
+		{
+			delete m_notifier;
+			::close(m_notify);
+		}
+#endif
+	}
+	
+	int FolderWatcher::watch(const QStringList& directories)
+	{
+		if (m_stopped)
+		{
+			return 0;
+		}
+		
+		if (!m_clock.isValid())
+		{
+			m_clock.start();
+		}
+		
+		int watched = 0;
+		for (const auto& directory : directories)
+		{
+			const auto path = QFileInfo(directory).absoluteFilePath();
+			
+			if (m_listings.contains(path) || !QFileInfo(path).isDir() || !addWatch(path))
+			{
+				continue;
+			}
+			
+			m_listings.insert(path, QSet<QString>());
+			const auto names = update(path);
+			++watched;
+			
+			if (!m_options.existing)
+			{
+				continue;
+			}
+			
+			// Files dropped while nothing watched
+			const auto store = ResultsStore::forDataset(path);
+			for (const auto& name : names)
+			{
+				const QFileInfo info(QDir(path).filePath(name));
+				if (!store->isProcessed(info.filePath(), info.lastModified().toMSecsSinceEpoch(), info.size()))
+				{
+					addCandidate(info.filePath());
+				}
+			}
+		}
+		
+		if (watched > 0 && !m_detector.isRunning())
+		{
+			m_detector.start();
+			m_flushTimer.start();
+		}
+		return watched;
+	}
+	
+	void FolderWatcher::stop()
+	{
+		if (m_stopped)
+		{
+			return;
+		}
+		m_stopped = true;
+		
+		if (!m_watcher.directories().isEmpty())
+		{
+			m_watcher.removePaths(m_watcher.directories());
+		}
+
+#ifdef Q_OS_LINUX
+		for (auto watch = m_watches.cbegin(); watch != m_watches.cend(); ++watch)
+		{
+			inotify_rm_watch(m_notify, watch.key());
+		}
+#endif
+		m_watches.clear();
+		m_listTimer.stop();
+		m_settleTimer.stop();
+		m_changed.clear();
+		m_candidates.clear();
+		m_ready.clear();
+		
+		if (m_detector.isRunning())
+		{
+			m_detector.close();
+		} else
+		{
+			QMetaObject::invokeMethod(this, "detectorFinished", Qt::QueuedConnection);
+		}
+	}
+	
+	int FolderWatcher::queueDepth() const
+	{
+		return m_candidates.size() + m_ready.size() + m_submitted - m_detected - m_failed;
+	}
+	
+	qreal FolderWatcher::throughput() const
+	{
+		if (!m_clock.isValid())
+		{
+			return 0.0;
+		}
+		
+		const auto now = m_clock.elapsed();
+		const auto span = qMin<qint64>(m_options.window, now);
+		int count = 0;
+		
+		for (auto finish = m_finishes.crbegin(); finish != m_finishes.crend() && *finish >= now - span; ++finish)
+		{
+			++count;
+		}
+		return span > 0 ? count * 1000.0 / span : 0.0;
+	}
+	
+	int FolderWatcher::detectedCount() const
+	{
+		return m_detected;
+	}
+	
+	int FolderWatcher::failedCount() const
+	{
+		return m_failed;
+	}
+	
+	void FolderWatcher::directoryChanged(const QString& directory)
+	{
+		if (m_stopped)
+		{
+			return;
+		}
+		
+		// Copying many files changes directory for
+		// each one, list it once for all
+		m_changed.insert(directory);
+		if (!m_listTimer.isActive())
+		{
+			m_listTimer.start();
+		}
+	}
+	
+	void FolderWatcher::readEvents()
+	{
+#ifdef Q_OS_LINUX
+		alignas(inotify_event) char buffer[64 * 1024];
+		
+		for (;;)
+		{
+			const auto length = ::read(m_notify, buffer, sizeof(buffer));
+			if (length <= 0)
+			{
+				break;
+			}
+			
+			for (ssize_t offset = 0; offset < length;)
+			{
+				const auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += ssize_t(sizeof(inotify_event) + event->len);
+				
+				// Events were dropped, listing finds missed files
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					for (auto listing = m_listings.cbegin(); listing != m_listings.cend(); ++listing)
+					{
+						directoryChanged(listing.key());
+					}
+					continue;
+				}
+				
+				// Watched directory was removed
+				if (event->mask & IN_IGNORED)
+				{
+					m_listings.remove(m_watches.take(event->wd));
+					continue;
+				}
+				
+				const auto directory = m_watches.value(event->wd);
+				if (directory.isEmpty() || event->len == 0 || (event->mask & IN_ISDIR))
+				{
+					continue;
+				}
+				
+				// Listing is kept for the case events are dropped
+				const auto name = QFile::decodeName(event->name);
+				auto& listing = m_listings[directory];
+				
+				if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+				{
+					listing.remove(name);
+				} else
+				{
+					listing.insert(name);
+					if (!m_stopped)
+					{
+						addCandidate(QDir(directory).filePath(name));
+					}
+				}
+			}
+		}
+#endif
+	}
+	
+	void FolderWatcher::listChanged()
+	{
+		QElapsedTimer timer { };
+		timer.start();
+		
+		for (const auto& directory : m_changed)
+		{
+			for (const auto& name : update(directory))
+			{
+				addCandidate(QDir(directory).filePath(name));
+			}
+		}
+		m_changed.clear();
+		
+		// Large directory isn't listed for every
+		// file copied into it
+		m_listTimer.setInterval(int(qMax<qint64>(ListDelay, ListThrottle * timer.elapsed())));
+	}
+	
+	void FolderWatcher::checkSettling()
+	{
+		const auto now = m_clock.elapsed();
+		
+		for (auto candidate = m_candidates.begin(); candidate != m_candidates.end();)
+		{
+			const QFileInfo info(candidate.key());
+			
+			if (!info.exists())
+			{
+				candidate = m_candidates.erase(candidate);
+				continue;
+			}
+			
+			const auto size = info.size();
+			const auto modified = info.lastModified().toMSecsSinceEpoch();
+			
+			if (size != candidate->size || modified != candidate->modified)
+			{
+				candidate->size = size;
+				candidate->modified = modified;
+				candidate->changed = now;
+				++candidate;
+				continue;
+			}
+			
+			if (size == 0 || now - candidate->changed < m_options.settle)
+			{
+				++candidate;
+				continue;
+			}
+			
+			// Written files that aren't images are dropped
+			if (!DirectoryScanner::sniff(candidate.key()).isEmpty())
+			{
+				m_ready.enqueue(candidate.key());
+			}
+			candidate = m_candidates.erase(candidate);
+		}
+		
+		if (m_candidates.isEmpty())
+		{
+			m_settleTimer.stop();
+		}
+		feed();
+	}
+	
+	void FolderWatcher::storeResult(const QString& file, const QJsonDocument& document, qint64 latency)
+	{
+		const QFileInfo info(file);
+		ResultsStore::Image image { };
+		
+		image.path = file;
+		image.modified = info.lastModified().toMSecsSinceEpoch();
+		image.size = info.size();
+		image.facets = m_options.detector.facets;
+		image.threshold = m_options.detector.threshold;
+		image.minSize = m_options.detector.minSize;
+		image.maxSize = m_options.detector.maxSize;
+		image.faces = FaceDetector::readFaces(document, image.facets);
+		
+		ResultsStore::forImage(file)->insert(image);
+		
+		finish(true);
+		emit detected(file, document, latency);
+	}
+	
+	void FolderWatcher::rejectFile(const QString& file, const QString& error, qint64 latency)
+	{
+		finish(false);
+		emit failed(file, error, latency);
+	}
+	
+	void FolderWatcher::flush()
+	{
+		ResultsStore::flushAll();
+	}
+	
+	void FolderWatcher::detectorFinished()
+	{
+		m_flushTimer.stop();
+		flush();
+		emit finished();
+	}
+	
+	QStringList FolderWatcher::update(const QString& directory)
+	{
+		const auto names = QDir(directory).entryList(QDir::Files, QDir::NoSort);
+		auto& listing = m_listings[directory];
+		
+		QStringList added { };
+		QSet<QString> current { };
+		current.reserve(names.size());
+		
+		for (const auto& name : names)
+		{
+			current.insert(name);
+			if (!listing.contains(name))
+			{
+				added.push_back(name);
+			}
+		}
+		
+		// Removed names are forgotten, so file
+		// written again under the name is detected
+		listing.swap(current);
+		return added;
+	}
+	
+	bool FolderWatcher::addWatch(const QString& directory)
+	{
+#ifdef Q_OS_LINUX
+		if (m_notify >= 0)
+		{
+			const int watch = inotify_add_watch(m_notify, QFile::encodeName(directory).constData(),
+			                                    IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE
+			                                    | IN_MOVED_FROM | IN_ONLYDIR);
+			if (watch >= 0)
+			{
+				m_watches.insert(watch, directory);
+				return true;
+			}
+		}
+#endif
+		return m_watcher.addPath(directory);
+	}
+	
+	void FolderWatcher::addCandidate(const QString& file)
+	{
+		const QFileInfo info(file);
+		m_candidates.insert(file, { info.size(), info.lastModified().toMSecsSinceEpoch(), m_clock.elapsed() });
+		
+		if (!m_settleTimer.isActive())
+		{
+			m_settleTimer.start();
+		}
+	}
+	
+	void FolderWatcher::feed()
+	{
+		// Short detector queue keeps depth visible here
+		// and lets stop drop files not sent yet
+		const int limit = 2 * m_options.detector.concurrency;
+		QStringList files { };
+		
+		while (!m_ready.isEmpty() && m_detector.pending() + files.size() < limit)
+		{
+			files.push_back(m_ready.dequeue());
+		}
+		
+		if (!files.isEmpty())
+		{
+			m_submitted += files.size();
+			m_detector.add(files);
+		}
+	}
+	
+	void FolderWatcher::finish(bool ok)
+	{
+		const auto now = m_clock.elapsed();
+		
+		if (ok)
+		{
+			++m_detected;
+		} else
+		{
+			++m_failed;
+		}
+		
+		m_finishes.enqueue(now);
+		while (!m_finishes.isEmpty() && m_finishes.head() < now - m_options.window)
+		{
+			m_finishes.dequeue();
+		}
+		feed();
+	}
+}// namespace Tevian
\ No newline at end of file
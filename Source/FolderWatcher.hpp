@@ -0,0 +1,208 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "BatchDetector.hpp"
+
+#include <QHash>
+#include <QSet>
+#include <QQueue>
+#include <QTimer>
+#include <QObject>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+
+class QSocketNotifier;
+
+namespace Tevian
+{
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Detects images dropped into watched directories.
+	 *
+	 * \details On Linux files written or moved into directory
+	 * are reported by inotify one by one, directory is listed
+	 * only when watching starts or events were dropped. Other
+	 * systems report only that directory changed, changes are
+	 * coalesced, then directory is listed and names missing
+	 * from previous listing are looked at; listing of large
+	 * directory is throttled to a tenth of time. New
+	 * file is taken as written when its size and modification
+	 * time didn't change for \c Options::settle milliseconds,
+	 * and its format is sniffed then. Written files are sent
+	 * through \c BatchDetector, whose queue is kept short, and
+	 * results are saved to \c ResultsStore of file's directory.
+	 * Throughput and queue depth are kept for sizing backend.
+	 * */
+	class TEVIAN_API FolderWatcher : public QObject
+	{
+	Q_OBJECT
+	public:
+		struct Options
+		{
+			BatchDetector::Options detector;
+			
+			//! Milliseconds file must stay unchanged
+			int settle = 1000;
+			
+			//! Milliseconds throughput is averaged over
+			int window = 60000;
+			
+			//! Milliseconds between saves of results
+			int flush = 5000;
+			
+			//! Detect files found on start having
+			//! no current results
+			bool existing = true;
+		};
+		
+		explicit FolderWatcher(const Options& options, QObject* parent = nullptr);
+		
+		~FolderWatcher() Q_DECL_OVERRIDE;
+		
+		/**
+		 * \brief Starts watching directories.
+		 *
+		 * \returns Count of directories being watched.
+		 * */
+		int watch(const QStringList& directories);
+		
+		/**
+		 * \brief Stops watching, files already sent are
+		 * finished and \c finished is emitted then.
+		 * */
+		void stop();
+		
+		/**
+		 * \returns Files found but not finished yet: settling,
+		 * waiting for detector or in flight.
+		 * */
+		int queueDepth() const;
+		
+		//! Images per second finished within window
+		qreal throughput() const;
+		
+		int detectedCount() const;
+		
+		int failedCount() const;
+	
+	signals:
+		
+		void detected(const QString& file, const QJsonDocument& document, qint64 latency);
+		
+		void failed(const QString& file, const QString& error, qint64 latency);
+		
+		void finished();
+	
+	private slots:
+		
+		void directoryChanged(const QString& directory);
+		
+		/**
+		 * \brief Reads inotify events, written and moved
+		 * in files start settling.
+		 * */
+		void readEvents();
+		
+		/**
+		 * \brief Lists changed directories, new files
+		 * start settling.
+		 * */
+		void listChanged();
+		
+		void checkSettling();
+		
+		void storeResult(const QString& file, const QJsonDocument& document, qint64 latency);
+		
+		void rejectFile(const QString& file, const QString& error, qint64 latency);
+		
+		void flush();
+		
+		void detectorFinished();
+	
+	private:
+		struct Candidate
+		{
+			qint64 size;
+			
+			qint64 modified;
+			
+			//! Clock time of last seen change
+			qint64 changed;
+		};
+		
+		/**
+		 * \brief Lists directory and returns names
+		 * missing from previous listing.
+		 * */
+		QStringList update(const QString& directory);
+		
+		/**
+		 * \brief Watches directory by inotify if it's
+		 * available, otherwise by \c QFileSystemWatcher.
+		 * */
+		bool addWatch(const QString& directory);
+		
+		void addCandidate(const QString& file);
+		
+		/**
+		 * \brief Moves ready files to detector while
+		 * its queue is short.
+		 * */
+		void feed();
+		
+		void finish(bool ok);
+	
+	private:
+		Options m_options;
+		
+		BatchDetector m_detector;
+		
+		QFileSystemWatcher m_watcher;
+		
+		//! inotify descriptor, -1 if it isn't available
+		int m_notify;
+		
+		QSocketNotifier* m_notifier;
+		
+		//! Directory of every inotify watch
+		QHash<int, QString> m_watches;
+		
+		//! Names of every watched directory
+		QHash<QString, QSet<QString>> m_listings;
+		
+		//! Directories changed since last listing
+		QSet<QString> m_changed;
+		
+		QHash<QString, Candidate> m_candidates;
+		
+		//! Written files waiting for detector
+		QQueue<QString> m_ready;
+		
+		//! Coalesces directory changes
+		QTimer m_listTimer;
+		
+		QTimer m_settleTimer;
+		
+		QTimer m_flushTimer;
+		
+		QElapsedTimer m_clock;
+		
+		//! Clock times of finished files within window
+		QQueue<qint64> m_finishes;
+		
+		int m_submitted;
+		
+		int m_detected;
+		
+		int m_failed;
+		
+		bool m_stopped;
+	};
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,324 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "ResultsStore.hpp"
+#include "Gui/BatchExporter.hpp"
+#include "Gui/FacePainter.hpp"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QSet>
+#include <QMutex>
+#include <QPainter>
+#include <QRunnable>
+#include <QFileInfo>
+#include <QPolygonF>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		struct BatchExporter::Job
+		{
+			QMutex mutex;
+			
+			//! Reset when exporter is destroyed
+			BatchExporter* target;
+			
+			bool cancelled;
+			
+			//! Output names taken by tasks, without extension
+			QSet<QString> names;
+		};
+		
+		namespace
+		{
+			enum Result
+			{
+				Written, Failed, Cancelled
+			};
+			
+			class ExportTask : public QRunnable
+			{
+			public:
+				ExportTask(const QString& file, const QVector<Details::Face>& faces,
+				           const BatchExporter::Options& options,
+				           const std::shared_ptr<BatchExporter::Job>& job)
+						: m_file { file },
+						  m_faces { faces },
+						  m_options { options },
+						  m_job { job }
+				{ }
+				
+				void run() Q_DECL_OVERRIDE
+				{
+					{
+						QMutexLocker locker(&m_job->mutex);
+						if (m_job->cancelled)
+						{
+							post(Cancelled);
+							return;
+						}
+					}
+					
+					// Oriented like in viewer, faces were shown on it
+					QImageReader reader(m_file);
+					reader.setAutoTransform(true);
+					auto image = reader.read();
+					
+					if (image.isNull())
+					{
+						post(Failed);
+						return;
+					}
+					
+					// Premultiplied 32-bit formats are painted on
+					// by raster engine without conversion
+					image = image.convertToFormat(image.hasAlphaChannel()
+					                              ? QImage::Format_ARGB32_Premultiplied
+					                              : QImage::Format_RGB32);
+					
+					const auto name = claimName();
+					bool written = true;
+					
+					// Crops are taken before annotation is drawn
+					if (m_options.crops)
+					{
+						for (int face = 0; face < m_faces.size(); ++face)
+						{
+							const auto rect = cropRect(m_faces.at(face), image.rect());
+							
+							if (!rect.isEmpty())
+							{
+								written &= write(image.copy(rect), QString("%1_%2").arg(name).arg(face));
+							}
+						}
+					}
+					
+					if (m_options.annotate)
+					{
+						// Pixmap sprite can't be used off GUI thread
+						FacePainter faces(FacePainter::Image);
+						faces.setCurve(m_options.curve);
+						faces.setPenWidth(m_options.penWidth);
+						faces.setFaces(m_faces);
+						
+						QPainter painter(&image);
+						painter.setRenderHint(QPainter::Antialiasing);
+						for (int face = 0; face < faces.size(); ++face)
+						{
+							faces.paint(&painter, face, Qt::blue);
+						}
+						painter.end();
+						
+						written &= write(image, name);
+					}
+					
+					post(written ? Written : Failed);
+				}
+			
+			private:
+				QRect cropRect(const Details::Face& face, const QRect& image) const
+				{
+					QRectF box = face.landmarks.empty()
+					             ? QRectF(face.bounds[0], face.bounds[1], face.bounds[2], face.bounds[3])
+					             : QPolygonF(face.landmarks).boundingRect();
+					
+					const qreal dx = box.width() * m_options.cropMargin;
+					const qreal dy = box.height() * m_options.cropMargin;
+					return box.adjusted(-dx, -dy, dx, dy).toAlignedRect().intersected(image);
+				}
+				
+				/**
+				 * \returns Output name free for annotated image and
+				 * crops of every face, \c -N is appended to name of
+				 * file if it's taken by other image or existing file.
+				 * */
+				QString claimName() const
+				{
+					const auto base = QDir(m_options.directory).filePath(QFileInfo(m_file).completeBaseName());
+					
+					QMutexLocker locker(&m_job->mutex);
+					for (int n = 1;; ++n)
+					{
+						const auto name = n == 1 ? base : QString("%1-%2").arg(base).arg(n);
+						
+						QStringList outputs { };
+						if (m_options.annotate)
+						{
+							outputs.push_back(name);
+						}
+						if (m_options.crops)
+						{
+							for (int face = 0; face < m_faces.size(); ++face)
+							{
+								outputs.push_back(QString("%1_%2").arg(name).arg(face));
+							}
+						}
+						
+						const bool taken = std::any_of(outputs.cbegin(), outputs.cend(), [ this ](const QString& output)
+						{
+							return m_job->names.contains(output) || QFileInfo::exists(path(output));
+						});
+						
+						if (!taken)
+						{
+							for (const auto& output : outputs)
+							{
+								m_job->names.insert(output);
+							}
+							return name;
+						}
+					}
+				}
+				
+				QString path(const QString& name) const
+				{
+					return name + '.' + QString::fromLatin1(m_options.format);
+				}
+				
+				bool write(const QImage& image, const QString& name) const
+				{
+					QImageWriter writer(path(name), m_options.format);
+					writer.setQuality(m_options.quality);
+					return writer.write(image);
+				}
+				
+				void post(int result)
+				{
+					QMutexLocker locker(&m_job->mutex);
+					if (m_job->target)
+					{
+						QMetaObject::invokeMethod(m_job->target, "finishImage", Qt::QueuedConnection,
+						                          Q_ARG(int, result));
+					}
+				}
+			
+			private:
+				QString m_file;
+				
+				QVector<Details::Face> m_faces;
+				
+				BatchExporter::Options m_options;
+				
+				std::shared_ptr<BatchExporter::Job> m_job;
+			};
+		}
+		
+		BatchExporter::BatchExporter(QObject* parent)
+				: QObject(parent),
+				  m_options { },
+				  m_pool { },
+				  m_job { },
+				  m_timer { },
+				  m_total { 0 },
+				  m_done { 0 },
+				  m_written { 0 },
+				  m_failed { 0 }
+		{ }
+		
+		BatchExporter::~BatchExporter()
+		{
+			if (m_job)
+			{
+				QMutexLocker locker(&m_job->mutex);
+				m_job->target = nullptr;
+				m_job->cancelled = true;
+			}
+			m_pool.waitForDone();
+		}
+		
+		void BatchExporter::setOptions(const Options& options)
+		{
+			m_options = options;
+		}
+		
+		const BatchExporter::Options&
+		BatchExporter::options() const
+		{
+			return m_options;
+		}
+		
+		void BatchExporter::setThreadCount(int count)
+		{
+			m_pool.setMaxThreadCount(qMax(1, count));
+		}
+		
+		int BatchExporter::start(const QStringList& files)
+		{
+			if (isRunning() || !QDir().mkpath(m_options.directory))
+			{
+				return 0;
+			}
+			
+			m_job = std::make_shared<Job>();
+			m_job->target = this;
+			m_job->cancelled = false;
+			m_total = m_done = m_written = m_failed = 0;
+			m_timer.start();
+			
+			// Stores are looked up here, tasks get faces only
+			for (const auto& file : files)
+			{
+				ResultsStore::Image image;
+				
+				if (!ResultsStore::forImage(file)->find(file, image)
+				    || !ResultsStore::isCurrent(image))
+				{
+					continue;
+				}
+				
+				m_pool.start(new ExportTask(file, image.faces, m_options, m_job));
+				++m_total;
+			}
+			
+			if (m_total == 0)
+			{
+				emit finished(0, 0);
+			}
+			return m_total;
+		}
+		
+		void BatchExporter::cancel()
+		{
+			if (m_job)
+			{
+				QMutexLocker locker(&m_job->mutex);
+				m_job->cancelled = true;
+			}
+		}
+		
+		bool BatchExporter::isRunning() const
+		{
+			return m_done < m_total;
+		}
+		
+		void BatchExporter::finishImage(int result)
+		{
+			++m_done;
+			
+			if (result == Written)
+			{
+				++m_written;
+			} else if (result == Failed)
+			{
+				++m_failed;
+			}
+			
+			const qreal seconds = qMax<qint64>(1, m_timer.elapsed()) / 1000.0;
+			emit progress(m_done, m_total, m_done / seconds);
+			
+			if (m_done == m_total)
+			{
+				emit finished(m_written, m_failed);
+			}
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
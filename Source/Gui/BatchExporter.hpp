@@ -0,0 +1,133 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "Defines.hpp"
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Writes annotated images and face crops of
+		 * processed images without showing them.
+		 *
+		 * \details Faces are taken from \c ResultsStore, images
+		 * without current results are skipped. Every image is
+		 * decoded, cropped, annotated by \c FacePainter and encoded
+		 * by a task of exporter's own pool, so export doesn't hold
+		 * up decoding of viewers.
+		 * Annotated image is written as <name>.<format>, crop of
+		 * face N as <name>_N.<format> into output directory.
+		 * Name is base name of image, with -2, -3 and so on
+		 * appended if image of other directory or format or an
+		 * existing file has it, so no file is overwritten.
+		 * */
+		class TEVIAN_API BatchExporter : public QObject
+		{
+		Q_OBJECT
+		public:
+			struct Options
+			{
+				//! Output directory, created if missing
+				QString directory;
+				
+				//! Format known to QImageWriter
+				QByteArray format = "jpg";
+				
+				//! Writer quality 0-100, -1 for format default
+				int quality = -1;
+				
+				bool annotate = true;
+				
+				bool crops = false;
+				
+				//! Room around face box of crop, in box sizes
+				qreal cropMargin = 0.25;
+				
+				qreal penWidth = 5;
+				
+				bool curve = false;
+			};
+			
+			//! State shared with export tasks
+			struct Job;
+			
+			explicit BatchExporter(QObject* parent = nullptr);
+			
+			~BatchExporter() Q_DECL_OVERRIDE;
+			
+			void setOptions(const Options& options);
+			
+			const Options& options() const;
+			
+			/**
+			 * \brief Sets count of images exported at once,
+			 * ideal thread count by default.
+			 * */
+			void setThreadCount(int count);
+			
+			/**
+			 * \brief Queues export of files having stored results.
+			 *
+			 * \returns Count of queued images, 0 if exporter is
+			 * running or output directory can't be created.
+			 * */
+			int start(const QStringList& files);
+			
+			/**
+			 * \brief Drops images not started yet, \c finished
+			 * follows when running ones are written.
+			 * */
+			void cancel();
+			
+			bool isRunning() const;
+		
+		signals:
+			
+			/**
+			 * \param imagesPerSecond Throughput since start
+			 * */
+			void progress(int done, int total, qreal imagesPerSecond);
+			
+			void finished(int written, int failed);
+		
+		private slots:
+			
+			void finishImage(int result);
+		
+		private:
+			Options m_options;
+			
+			QThreadPool m_pool;
+			
+			//! Shared with queued tasks, which post
+			//! results while job has target
+			std::shared_ptr<Job> m_job;
+			
+			QElapsedTimer m_timer;
+			
+			int m_total;
+			
+			int m_done;
+			
+			int m_written;
+			
+			int m_failed;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
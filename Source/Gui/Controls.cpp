@@ -5,6 +5,7 @@
 
 #include "Defines.hpp"
 #include "Gui/Controls.hpp"
+#include "FaceApi.hpp"
 #include "FaceDetector.hpp"
 #include "Gui/DetectionRenderer.hpp"
 
@@ -43,6 +44,45 @@ namespace Tevian
 			return m_color;
 		}
 		
+		bool Controls::isAdjusting() const
+		{
+			return m_thresholdSlider->isSliderDown();
+		}
+		
+		void Controls::setParameters(const DetectData& data, Facets facets)
+		{
+			m_controlData._min_size = data._min_size;
+			m_controlData._max_size = data._max_size;
+			m_controlData._threshold = data._threshold;
+			
+			m_minEdit->setText(data._min_size > 0 ? QString::number(data._min_size) : QString());
+			m_maxEdit->setText(data._max_size > 0 ? QString::number(data._max_size) : QString());
+			
+			// Zero threshold is server's default
+			const auto threshold = data._threshold > 0 ? data._threshold : Client::FaceApi::DefaultThreshold;
+			m_thresholdEdit->setText(data._threshold > 0 ? QString::number(data._threshold) : QString());
+			m_thresholdSlider->blockSignals(true);
+			m_thresholdSlider->setValue(qRound(threshold * 100));
+			m_thresholdSlider->blockSignals(false);
+			
+			// Toggled slots only update control data
+			m_landmarksCheck->setChecked(facets & LandmarksFacet);
+			m_attributesCheck->setChecked(facets & AttributesFacet);
+			m_demographicsCheck->setChecked(facets & DemographicsFacet);
+		}
+		
+		void Controls::setFace(const FaceData::face_array& face, bool second)
+		{
+			if (second)
+			{
+				m_controlData._face2 = face;
+				return;
+			}
+			
+			m_controlData._face = face;
+			m_face1Edit->setText(QString("%1, %2, %3, %4").arg(face[0]).arg(face[1]).arg(face[2]).arg(face[3]));
+		}
+		
 		void Controls::initControls(DetectionRenderer* renderer)
 		{
 			auto mainGroup = new QGroupBox(this);
@@ -87,6 +127,7 @@ namespace Tevian
 			auto minEdit = new QLineEdit(m_dataGroup);
 			auto maxEdit = new QLineEdit(m_dataGroup);
 			auto thresholdEdit = new QLineEdit(m_dataGroup);
+			auto thresholdSlider = new QSlider(Qt::Horizontal, m_dataGroup);
 			auto facebox1Edit = new QLineEdit(m_dataGroup);
 			minEdit->setPlaceholderText("Minimal size");
 			maxEdit->setPlaceholderText("Maximal size");
@@ -95,15 +136,31 @@ namespace Tevian
 			auto demographicsCheck = new QCheckBox(tr("Demographics"), m_dataGroup);
 			auto attributesCheck = new QCheckBox(tr("Attributes"), m_dataGroup);
 			auto landmarksCheck = new QCheckBox(tr("Landmarks"), m_dataGroup);
+			auto supersetCheck = new QCheckBox(tr("Filter locally"), m_dataGroup);
+			supersetCheck->setToolTip(tr("Fetch all candidate faces once and apply "
+			                             "threshold and sizes without request"));
+			// Zero threshold is server's default, not the loosest one
+			thresholdSlider->setRange(1, 100);
+			thresholdSlider->setValue(qRound(Client::FaceApi::DefaultThreshold * 100));
+			m_minEdit = minEdit;
+			m_maxEdit = maxEdit;
+			m_thresholdEdit = thresholdEdit;
+			m_thresholdSlider = thresholdSlider;
+			m_demographicsCheck = demographicsCheck;
+			m_attributesCheck = attributesCheck;
+			m_landmarksCheck = landmarksCheck;
+			m_face1Edit = facebox1Edit;
 			
 			auto dataGroupLayout = new QFormLayout(m_dataGroup);
 			dataGroupLayout->addRow(minEdit);
 			dataGroupLayout->addRow(maxEdit);
 			dataGroupLayout->addWidget(thresholdEdit);
+			dataGroupLayout->addWidget(thresholdSlider);
 			dataGroupLayout->addWidget(facebox1Edit);
 			dataGroupLayout->addWidget(demographicsCheck);
 			dataGroupLayout->addWidget(attributesCheck);
 			dataGroupLayout->addWidget(landmarksCheck);
+			dataGroupLayout->addWidget(supersetCheck);
 			
 			// Default:
 			connect(minEdit, SIGNAL(textEdited(
@@ -121,6 +178,12 @@ namespace Tevian
 			        this, SLOT(thresholdEdited(
 					                   const QString&)));
 			
+			connect(thresholdSlider, SIGNAL(valueChanged(int)),
+			        this, SLOT(thresholdMoved(int)));
+			
+			connect(thresholdSlider, SIGNAL(sliderReleased()),
+			        this, SLOT(thresholdReleased()));
+			
 			connect(facebox1Edit, SIGNAL(textEdited(
 					                             const QString&)),
 			        this, SLOT(face1Edited(
@@ -138,6 +201,9 @@ namespace Tevian
 			connect(landmarksCheck, SIGNAL(toggled(bool)),
 			        this, SLOT(landmarksToggled(bool)));
 			
+			connect(supersetCheck, SIGNAL(toggled(bool)),
+			        this, SLOT(supersetToggled(bool)));
+			
 			landmarksCheck->setChecked(true);
 			demographicsCheck->setChecked(true);
 		}
@@ -246,16 +312,36 @@ namespace Tevian
 		void Controls::minSizeEdited(const QString& text)
 		{
 			m_controlData._min_size = text.toInt();
+			emit filterData(m_controlData);
 		}
 		
 		void Controls::maxSizeEdited(const QString& text)
 		{
 			m_controlData._max_size = text.toInt();
+			emit filterData(m_controlData);
 		}
 		
 		void Controls::thresholdEdited(const QString& text)
 		{
 			m_controlData._threshold = text.toFloat();
+			
+			// Keep slider in sync without emitting its change back
+			m_thresholdSlider->blockSignals(true);
+			m_thresholdSlider->setValue(qRound(m_controlData._threshold * 100));
+			m_thresholdSlider->blockSignals(false);
+			emit filterData(m_controlData);
+		}
+		
+		void Controls::thresholdMoved(int value)
+		{
+			m_controlData._threshold = value / 100.0f;
+			m_thresholdEdit->setText(QString::number(m_controlData._threshold));
+			emit filterData(m_controlData);
+		}
+		
+		void Controls::thresholdReleased()
+		{
+			emit filterData(m_controlData);
 		}
 		
 		void Controls::face1Edited(const QString& text)
@@ -265,7 +351,7 @@ namespace Tevian
 			{
 				for (int i = 0; i < chunks.size(); ++i)
 				{
-					m_controlData._face[i] = chunks[i].toInt();
+					m_controlData._face[i] = chunks[i].trimmed().toInt();
 				}
 			}
 		}
@@ -285,5 +371,10 @@ namespace Tevian
 			m_controlData._landmarks = b;
 		}
 		
+		void Controls::supersetToggled(bool b)
+		{
+			m_controlData._superset = b;
+		}
+		
 	}// namespace Gui
 }// namespace Tevian
\ No newline at end of file
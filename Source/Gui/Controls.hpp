@@ -14,10 +14,16 @@
 
 class QRadioButton;
 
+class QLineEdit;
+
+class QSlider;
+
 class QWidget;
 
 class QGroupBox;
 
+class QCheckBox;
+
 namespace Tevian
 {
 	namespace Client
@@ -36,6 +42,27 @@ namespace Tevian
 			Controls(QWidget* parent, DetectionRenderer* renderer);
 			
 			QColor currentColor() const;
+			
+			/**
+			 * \brief Shows parameters restored by detector,
+			 * neither \c filterData nor \c submitData is
+			 * emitted.
+			 * */
+			void setParameters(const DetectData& data, Facets facets);
+			
+			/**
+			 * \brief Sets face box picked on image, sent with
+			 * the next \c submitData.
+			 *
+			 * \param second Sets the second face of match
+			 * */
+			void setFace(const FaceData::face_array& face, bool second);
+			
+			/**
+			 * \returns true while threshold slider is dragged,
+			 * \c filterData is emitted again on release.
+			 * */
+			bool isAdjusting() const;
 		
 		signals:
 			
@@ -47,6 +74,15 @@ namespace Tevian
 			 * */
 			void submitData(const ControlData& data);
 			
+			/**
+			 * \brief Signal emitted when threshold or face
+			 * size limits change.
+			 *
+			 * \details Data is used to filter already
+			 * fetched faces without request.
+			 * */
+			void filterData(const ControlData& data);
+			
 			void clearData(bool);
 		
 		private:
@@ -79,6 +115,10 @@ namespace Tevian
 			
 			void thresholdEdited(const QString&);
 			
+			void thresholdMoved(int);
+			
+			void thresholdReleased();
+			
 			void face1Edited(const QString&);
 			
 			void demographicsToggled(bool);
@@ -86,6 +126,8 @@ namespace Tevian
 			void attributesToggled(bool);
 			
 			void landmarksToggled(bool);
+			
+			void supersetToggled(bool);
 		
 		private:
 			bool m_drag;
@@ -100,6 +142,22 @@ namespace Tevian
 			
 			QPushButton* m_okButton;
 			
+			QLineEdit* m_minEdit;
+			
+			QLineEdit* m_maxEdit;
+			
+			QLineEdit* m_thresholdEdit;
+			
+			QSlider* m_thresholdSlider;
+			
+			QCheckBox* m_demographicsCheck;
+			
+			QCheckBox* m_attributesCheck;
+			
+			QCheckBox* m_landmarksCheck;
+			
+			QLineEdit* m_face1Edit;
+			
 			DetectData m_detectData;
 			
 			MatchData m_matchData;
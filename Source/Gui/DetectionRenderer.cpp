@@ -5,135 +5,60 @@
 
 
 #include "Gui/DetectionRenderer.hpp"
+#include "Gui/FaceItem.hpp"
+#include "Gui/OverlayLayer.hpp"
 
 #include <QPainter>
-#include <QMouseEvent>
+#include <QGraphicsSceneMouseEvent>
 
 namespace Tevian
 {
 	namespace Gui
 	{
-		DetectionRenderer::DetectionRenderer(QImage* image, QWidget* parent, Qt::WindowFlags flags)
-				: RenderWidget(image, parent),
+		DetectionRenderer::DetectionRenderer(QImage* image, QGraphicsItem* parent)
+				: RenderItem(image, parent),
+				  m_painter { },
+				  m_pathMode { LineMode },
+				  m_selected { -1 },
 				  m_clear { false }
 		{
-			setWindowFlags(flags);
-		}
-		
-		void DetectionRenderer::drawBox(QPainter* painter)
-		{
-			if (m_bounds.size() >= 3)
-			{
-				QPainterPath path;
-				painter->setPen(Qt::NoPen);
-				path.moveTo(m_bounds.at(0));
-				
-				for (int i = 1; i < m_bounds.size(); ++i)
-				{
-					path.lineTo(m_bounds.at(i));
-				}
-				
-				
-				// Draw the getPath
-				QColor lineColor = Qt::blue;
-				
-				// The "custom" pen
-				if (m_penStyle == Qt::NoPen)
-				{
-					QPainterPathStroker stroker;
-					stroker.setWidth(m_penWidth);
-					stroker.setJoinStyle(m_joinStyle);
-					stroker.setCapStyle(Qt::PenCapStyle::SquareCap);
-					
-					QVector<qreal> dashes;
-					qreal space = 4;
-					dashes << 1 << space << 3 << space
-					       << 9 << space << 27 << space
-					       << 9 << space << 3 << space;
-					stroker.setDashPattern(dashes);
-					QPainterPath stroke = stroker.createStroke(path);
-					painter->fillPath(stroke, lineColor);
-					
-				} else
-				{
-					QPen pen(lineColor, m_penWidth, m_penStyle, Qt::SquareCap, m_joinStyle);
-					painter->strokePath(path, pen);
-				}
-			}
-		}
-		
-		void DetectionRenderer::drawLandmarks(QPainter* painter)
-		{
-			if (!m_points.empty())
-			{
-				QColor pencolor = QColor(50, 100, 120, 200);
-				QColor brushcolor = QColor(100, 100, 100, 120);
-				painter->setPen(pencolor);
-				painter->setBrush(brushcolor);
-				painter->drawPoints(m_points);
-				for (int i = 0; i < m_points.size(); ++i)
-				{
-					QPointF pos = m_points.at(i);
-					painter->drawEllipse(pos.x(), pos.y(),
-					                     m_pointSize, m_pointSize);
-				}
-				painter->setPen(Qt::NoPen);
-				painter->setBrush(Qt::NoBrush);
-			}
-		}
-		
-		QSize DetectionRenderer::sizeHint() const
-		{
-			return image()->size();
+			m_overlay = new OverlayLayer(this);
 		}
 		
 		QPoint DetectionRenderer::center() const
 		{
-			return QPoint(sizeHint().width() / 2, sizeHint().height() / 2);
+			return QPoint(imageSize().width() / 2, imageSize().height() / 2);
 		}
 		
 		qreal DetectionRenderer::area()
 		{
-			return sizeHint().width() * sizeHint().height();
+			return imageSize().width() * imageSize().height();
 		}
 		
 		qreal DetectionRenderer::realPenWidth() const
 		{
-			return m_penWidth;
+			return m_painter.penWidth();
 		}
 		
 		void DetectionRenderer::setRealPenWidth(qreal penWidth)
 		{
-			m_penWidth = penWidth;
+			m_painter.setPenWidth(penWidth);
+			refreshItems();
 		}
 		
-		void DetectionRenderer::setPoints(const QVector<QPointF>& points)
+		void DetectionRenderer::setFaces(const QVector<Details::Face>& faces)
 		{
-			if (!points.empty())
+			m_sources = m_painter.setFaces(faces);
+			m_selected = -1;
+			m_clear = false;
+			
+			qDeleteAll(m_items);
+			m_items.clear();
+			for (int face = 0; face < m_painter.size(); ++face)
 			{
-				m_points = points;
-				m_bounds = Math::minmax4D(m_points);        // Identify face box limits
-				m_pointSize = 5;
-				m_pointCount = points.size();
-				m_currentPoint = -1;
-				m_pathMode = LineMode;
-				m_penWidth = 5;
-				m_penStyle = Qt::SolidLine;
-				m_clear = false;
-				update();
+				m_items.push_back(new FaceItem(this, face));
 			}
-		}
-		
-		void DetectionRenderer::setBox(const std::array<int, 4>& bbox)
-		{
-			m_bbox1 = bbox;
-		}
-		
-		void DetectionRenderer::setBox(const QRect& bbox)
-		{
-			m_bbox1 = {
-					bbox.x(), bbox.y(), bbox.width(), bbox.height()
-			};
+			updateGrid();
 		}
 		
 		bool DetectionRenderer::cleared()
@@ -144,66 +69,173 @@ namespace Tevian
 		void DetectionRenderer::setCurveMode()
 		{
 			m_pathMode = CurveMode;
-			update();
+			m_painter.setCurve(true);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::setLineMode()
 		{
 			m_pathMode = LineMode;
-			update();
+			m_painter.setCurve(false);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::setSolidLine()
 		{
-			m_penStyle = Qt::SolidLine;
-			update();
+			m_painter.setPenStyle(Qt::SolidLine);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::setDashLine()
 		{
-			m_penStyle = Qt::DashLine;
-			update();
+			m_painter.setPenStyle(Qt::DashLine);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::setDotLine()
 		{
-			m_penStyle = Qt::DotLine;
-			update();
+			m_painter.setPenStyle(Qt::DotLine);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::setDashDotLine()
 		{
-			m_penStyle = Qt::DashDotLine;
-			update();
+			m_painter.setPenStyle(Qt::DashDotLine);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::setDashDotDotLine()
 		{
-			m_penStyle = Qt::DashDotDotLine;
-			update();
+			m_painter.setPenStyle(Qt::DashDotDotLine);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::setCustomDashLine()
 		{
-			m_penStyle = Qt::NoPen;
-			update();
+			m_painter.setPenStyle(Qt::NoPen);
+			refreshItems();
 		}
 		
 		void DetectionRenderer::clear(bool c)
 		{
 			m_clear = c;
-			m_points.clear();
-			m_bounds.clear();
-			update();
+			qDeleteAll(m_items);
+			m_items.clear();
+			m_painter.clear();
+			m_sources.clear();
+			m_grid.clear();
+			m_selected = -1;
+		}
+		
+		QRectF DetectionRenderer::faceBounds(int face) const
+		{
+			return m_painter.faceBounds(face);
+		}
+		
+		void DetectionRenderer::paintFace(QPainter* painter, int face)
+		{
+			if (m_clear)
+			{
+				return;
+			}
+			
+			const QColor color = face == m_selected ? Qt::red : Qt::blue;
+			
+			if (isInteractive())
+			{
+				m_painter.paintPlain(painter, face, color);
+			} else
+			{
+				m_painter.paint(painter, face, color);
+			}
+		}
+		
+		void DetectionRenderer::setInteractive(bool interactive)
+		{
+			if (interactive == isInteractive())
+			{
+				return;
+			}
+			RenderItem::setInteractive(interactive);
+			
+			// Cached item would keep its full quality pixmap
+			for (auto item : m_items)
+			{
+				if (interactive)
+				{
+					item->setCacheMode(QGraphicsItem::NoCache);
+				} else
+				{
+					OverlayLayer::cache(item);
+				}
+				item->update();
+			}
+		}
+		
+		QGraphicsItem* DetectionRenderer::overlay() const
+		{
+			return m_overlay;
+		}
+		
+		void DetectionRenderer::refreshItems()
+		{
+			for (auto item : m_items)
+			{
+				item->refresh();
+			}
+			updateGrid();
+		}
+		
+		void DetectionRenderer::updateGrid()
+		{
+			QVector<QRectF> bounds { };
+			bounds.reserve(m_painter.size());
+			
+			for (int face = 0; face < m_painter.size(); ++face)
+			{
+				bounds.push_back(faceBounds(face));
+			}
+			m_grid.build(bounds);
+		}
+		
+		int DetectionRenderer::faceAt(const QPointF& point) const
+		{
+			const auto face = m_grid.faceAt(point);
+			return face < 0 ? -1 : m_sources.at(face);
+		}
+		
+		void DetectionRenderer::setSelectedFace(int face)
+		{
+			const auto selected = m_sources.indexOf(face);
+			
+			if (selected == m_selected)
+			{
+				return;
+			}
+			
+			for (auto changed : { m_selected, selected })
+			{
+				if (changed >= 0)
+				{
+					m_items.at(changed)->update();
+				}
+			}
+			m_selected = selected;
 		}
 		
-		void DetectionRenderer::paint(QPainter* painter)
+		void DetectionRenderer::mousePressEvent(QGraphicsSceneMouseEvent* event)
 		{
-			if (!m_clear)
+			const auto face = faceAt(event->pos());
+			
+			// Dragging view goes on out of faces
+			if (face < 0 || m_clear)
 			{
-				drawLandmarks(painter);
-				drawBox(painter);
+				event->ignore();
+				return;
 			}
+			
+			setSelectedFace(face);
+			emit facePicked(face, event->modifiers());
 		}
 	}
 }
\ No newline at end of file
@@ -9,12 +9,15 @@
 #include <unordered_map>
 
 #include "Commons.hpp"
-#include "Gui/RenderWidget.hpp"
+#include "Gui/RenderItem.hpp"
 #include "FaceDetector.hpp"
+#include "Gui/FacePainter.hpp"
+#include "Gui/FaceGrid.hpp"
 
 #include <QBrush>
 #include <QLabel>
 #include <QPixmap>
+#include <QPainter>
 #include <QtGui/QStaticText>
 
 
@@ -24,6 +27,10 @@ namespace Tevian
 {
 	namespace Gui
 	{
+		class FaceItem;
+		
+		class OverlayLayer;
+		
 		/**
 		 * \author Alvin Ahmadov
 		 * \namespace Tevian::Gui
@@ -35,8 +42,9 @@ namespace Tevian
  		 * finishing on bottom-right point pair.
  		 * All point calculation process made in \class Annotator, after finishing
  		 * the class sends signal to this class to draw and render image.
+ 		 * Every face is separate \c FaceItem in overlay layer over image.
 		 * */
-		class TEVIAN_API DetectionRenderer : public RenderWidget
+		class TEVIAN_API DetectionRenderer : public RenderItem
 		{
 		Q_OBJECT
 		public:
@@ -52,10 +60,7 @@ namespace Tevian
 			
 		public:
 			///ctor.
-			DetectionRenderer(QImage* image, QWidget* paernt = nullptr,
-			                  Qt::WindowFlags wFlags = Qt::WindowFlags());
-			
-			QSize sizeHint() const Q_DECL_OVERRIDE;
+			DetectionRenderer(QImage* image, QGraphicsItem* parent = nullptr);
 			
 			QPoint center() const;
 			
@@ -65,20 +70,65 @@ namespace Tevian
 			
 			void setRealPenWidth(qreal penWidth);
 			
-			void setPoints(const QVector<QPointF>& points);
+			/**
+			 * \brief Sets faces to draw. Face box is built
+			 * from landmarks if there are any, otherwise from
+			 * face bounding rectangle.
+			 * */
+			void setFaces(const QVector<Details::Face>& faces);
 			
-			void setBox(const std::array<int, 4>& bbox);
+			bool cleared();
 			
-			void setBox(const QRect& bbox);
+			/**
+			 * \returns Bounds of face outline and landmarks
+			 * with room for pen and points.
+			 * */
+			QRectF faceBounds(int face) const;
 			
-			bool cleared();
+			/**
+			 * \brief Draws outline and landmarks of face,
+			 * only plain box while interactive.
+			 * */
+			void paintFace(QPainter* painter, int face);
+			
+			/**
+			 * \returns Cached layer of annotation items,
+			 * parent of face items and labels.
+			 * */
+			QGraphicsItem* overlay() const;
+			
+			/**
+			 * \returns Index in faces passed to \c setFaces
+			 * of face under \c point, -1 if there's none.
+			 * */
+			int faceAt(const QPointF& point) const;
+			
+			/**
+			 * \brief Highlights face, -1 clears selection.
+			 *
+			 * \param face Index in faces passed to \c setFaces
+			 * */
+			void setSelectedFace(int face);
 		
 		signals:
 			
 			void clicked();
+			
+			/**
+			 * \brief Emitted when user clicks on face.
+			 *
+			 * \param face Index in faces passed to \c setFaces
+			 * */
+			void facePicked(int face, Qt::KeyboardModifiers modifiers);
 		
 		public slots:
 			
+			/**
+			 * \brief Face items aren't cached while view is
+			 * interactive, so simplified boxes follow zoom.
+			 * */
+			void setInteractive(bool interactive) Q_DECL_OVERRIDE;
+			
 			/// Slots to change line type
 			void setCurveMode();
 			
@@ -98,57 +148,46 @@ namespace Tevian
 			
 			void clear(bool c);
 		
-		private slots:
-			
-			/**
-			 * \brief Paints line
-			 *
-			 * \details The method is inherited from the base
-			 * class. In base class it's pure virtual, only
-			 * called on paint event of FacelineRenderer to
-			 * draw points and lines on background image
-			 * */
-			void paint(QPainter*) Q_DECL_OVERRIDE;
+		protected:
+			void mousePressEvent(QGraphicsSceneMouseEvent* event) Q_DECL_OVERRIDE;
 		
 		private:
 			/**
-			 * \details It listens for finish signal sent from \c Annotator to start drawing
-			 * and called repeatedly if paint event runs.
-			 * Draws face bounding box according to landmark points
+			 * \brief Updates face items after drawing
+			 * style changed.
 			 * */
-			void drawBox(QPainter* painter);
+			void refreshItems();
 			
 			/**
-			 * \brief Draws ponts
+			 * \brief Indexes bounds of drawn faces.
 			 * */
-			void drawLandmarks(QPainter* painter);
+			void updateGrid();
 		
 		private:
 			
-			QVector<QPointF> m_bounds;
+			//! Draws faces, holds their geometry and style
+			FacePainter m_painter;
 			
 			PathMode m_pathMode;
 			
-			qreal m_penWidth;
+			//! Layer of face items
+			OverlayLayer* m_overlay;
 			
-			int m_pointCount;
+			//! Scene item of every face
+			QVector<FaceItem*> m_items;
 			
-			int m_pointSize;
+			//! Index of every drawn face in faces given
+			//! to \c setFaces, faces without box are skipped
+			QVector<int> m_sources;
 			
-			std::array<int, 4> m_bbox1;
+			//! Spatial index of face bounds
+			FaceGrid m_grid;
 			
-			std::array<int, 4> m_bbox2;
-			
-			int m_currentPoint;
-			
-			QVector<QPointF> m_points;
+			//! Highlighted drawn face or -1
+			int m_selected;
 			
 			QRect m_boundingBox;
 			
-			Qt::PenJoinStyle m_joinStyle;
-			
-			Qt::PenStyle m_penStyle;
-			
 			bool m_clear;
 		};
 	}   // namespace Gui
@@ -0,0 +1,262 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/FaceGeometry.hpp"
+
+#include <cmath>
+
+#include <QPainterPathStroker>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		namespace
+		{
+			const int MinBucket = -3;
+			
+			const int MaxBucket = 3;
+			
+			/**
+			 * \brief Contour of 68-point landmark layout.
+			 * */
+			struct LandmarkGroup
+			{
+				int first;
+				
+				int last;
+				
+				bool closed;
+			};
+			
+			const int LandmarkCount = 68;
+			
+			const LandmarkGroup LandmarkGroups[] = {
+					{ 0,  16, false },  // jaw
+					{ 17, 21, false },  // right brow
+					{ 22, 26, false },  // left brow
+					{ 27, 30, false },  // nose bridge
+					{ 31, 35, false },  // nostrils
+					{ 36, 41, true },   // right eye
+					{ 42, 47, true },   // left eye
+					{ 48, 59, true },   // outer lips
+					{ 60, 67, true }    // inner lips
+			};
+			
+			/**
+			 * \returns Points without consecutive duplicates,
+			 * they make zero length spans.
+			 * */
+			QVector<QPointF> distinct(const QVector<QPointF>& points, bool closed)
+			{
+				QVector<QPointF> result { };
+				result.reserve(points.size());
+				
+				for (const auto& point : points)
+				{
+					if (result.isEmpty() || result.last() != point)
+					{
+						result.push_back(point);
+					}
+				}
+				
+				if (closed && result.size() > 1 && result.first() == result.last())
+				{
+					result.removeLast();
+				}
+				return result;
+			}
+			
+			int samples(int bucket)
+			{
+				return qBound(2, int(4 * std::pow(2.0, bucket)), 32);
+			}
+		}
+		
+		void FaceGeometry::setFaces(const QVector<QVector<QPointF>>& bounds,
+		                            const QVector<QVector<QPointF>>& landmarks)
+		{
+			m_faces.clear();
+			m_faces.reserve(bounds.size());
+			
+			for (int i = 0; i < bounds.size(); ++i)
+			{
+				Entry entry;
+				entry.bounds = bounds.at(i);
+				entry.landmarks = landmarks.value(i);
+				m_faces.push_back(entry);
+			}
+		}
+		
+		void FaceGeometry::clear()
+		{
+			m_faces.clear();
+		}
+		
+		int FaceGeometry::size() const
+		{
+			return m_faces.size();
+		}
+		
+		const QPainterPath&
+		FaceGeometry::outline(int face, bool curve, int bucket) const
+		{
+			const auto& entry = m_faces.at(face);
+			auto found = entry.paths.constFind(key(curve, bucket));
+			
+			if (found == entry.paths.constEnd())
+			{
+				found = entry.paths.insert(key(curve, bucket), build(entry, curve, bucket));
+			}
+			return found.value();
+		}
+		
+		void FaceGeometry::setStroke(qreal width, Qt::PenJoinStyle joinStyle,
+		                             const QVector<qreal>& dashes)
+		{
+			if (qFuzzyCompare(width, m_strokeWidth) && joinStyle == m_joinStyle && dashes == m_dashes)
+			{
+				return;
+			}
+			
+			m_strokeWidth = width;
+			m_joinStyle = joinStyle;
+			m_dashes = dashes;
+			
+			for (auto& entry : m_faces)
+			{
+				entry.strokes.clear();
+			}
+		}
+		
+		const QPainterPath&
+		FaceGeometry::stroke(int face, bool curve, int bucket) const
+		{
+			const auto& entry = m_faces.at(face);
+			auto found = entry.strokes.constFind(key(curve, bucket));
+			
+			if (found == entry.strokes.constEnd())
+			{
+				QPainterPathStroker stroker;
+				stroker.setWidth(m_strokeWidth);
+				stroker.setJoinStyle(m_joinStyle);
+				stroker.setCapStyle(Qt::PenCapStyle::SquareCap);
+				stroker.setDashPattern(m_dashes);
+				
+				found = entry.strokes.insert(key(curve, bucket),
+				                             stroker.createStroke(outline(face, curve, bucket)));
+			}
+			return found.value();
+		}
+		
+		int FaceGeometry::key(bool curve, int bucket)
+		{
+			// Straight lines don't depend on zoom
+			return curve ? bucket * 2 + 1 : 0;
+		}
+		
+		int FaceGeometry::zoomBucket(const QTransform& transform)
+		{
+			const auto scale = std::sqrt(std::abs(transform.determinant()));
+			
+			if (scale <= 0)
+			{
+				return 0;
+			}
+			return qBound(MinBucket, int(std::lround(std::log2(scale))), MaxBucket);
+		}
+		
+		QPainterPath
+		FaceGeometry::catmullRom(const QVector<QPointF>& input, bool closed, int samples)
+		{
+			QPainterPath path;
+			const auto points = distinct(input, closed);
+			const int count = points.size();
+			
+			if (count < 3)
+			{
+				// Nothing to smooth
+				for (int i = 0; i < count; ++i)
+				{
+					i == 0 ? path.moveTo(points.at(i)) : path.lineTo(points.at(i));
+				}
+				return path;
+			}
+			
+			// Open curve repeats its end points
+			auto at = [ & ](int i) -> const QPointF&
+			{
+				return closed
+				       ? points.at((i + count) % count)
+				       : points.at(qBound(0, i, count - 1));
+			};
+			
+			const int spans = closed ? count : count - 1;
+			path.moveTo(points.first());
+			
+			for (int i = 0; i < spans; ++i)
+			{
+				const auto& p0 = at(i - 1);
+				const auto& p1 = at(i);
+				const auto& p2 = at(i + 1);
+				const auto& p3 = at(i + 2);
+				
+				for (int s = 1; s <= samples; ++s)
+				{
+					const qreal t = qreal(s) / samples;
+					const qreal t2 = t * t;
+					const qreal t3 = t2 * t;
+					
+					path.lineTo(0.5 * ((2 * p1)
+					                   + (p2 - p0) * t
+					                   + (2 * p0 - 5 * p1 + 4 * p2 - p3) * t2
+					                   + (3 * p1 - p0 - 3 * p2 + p3) * t3));
+				}
+			}
+			
+			if (closed)
+			{
+				path.closeSubpath();
+			}
+			return path;
+		}
+		
+		QPainterPath
+		FaceGeometry::build(const Entry& entry, bool curve, int bucket)
+		{
+			QPainterPath path;
+			
+			if (!curve)
+			{
+				if (entry.bounds.size() >= 3)
+				{
+					path.moveTo(entry.bounds.at(0));
+					for (int i = 1; i < entry.bounds.size(); ++i)
+					{
+						path.lineTo(entry.bounds.at(i));
+					}
+				}
+				return path;
+			}
+			
+			if (entry.landmarks.size() == LandmarkCount)
+			{
+				for (const auto& group : LandmarkGroups)
+				{
+					path.addPath(catmullRom(entry.landmarks.mid(group.first, group.last - group.first + 1),
+					                        group.closed, samples(bucket)));
+				}
+				return path;
+			}
+			
+			if (entry.bounds.size() >= 3)
+			{
+				path = catmullRom(entry.bounds, true, samples(bucket));
+			}
+			return path;
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
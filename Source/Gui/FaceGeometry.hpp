@@ -0,0 +1,124 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+#include <QTransform>
+#include <QPainterPath>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Builds outline paths of detected faces
+		 * and caches them.
+		 *
+		 * \details Line outline joins box points. Curve outline
+		 * is Catmull-Rom spline through landmark groups (jaw,
+		 * brows, nose, eyes and lips of 68-point layout) or
+		 * through box points if there are no such landmarks.
+		 * Splines are flattened with more segments on higher
+		 * zoom, so paths are cached per face and zoom bucket
+		 * and repaint only replays them. Overlay items are cached
+		 * in device coordinates and repainted on every zoom step,
+		 * each repaint within a bucket reuses its paths. Custom
+		 * dash strokes are cached the same way until stroke
+		 * parameters change.
+		 * */
+		class TEVIAN_API FaceGeometry
+		{
+		public:
+			/**
+			 * \brief Replaces faces and drops cached paths.
+			 *
+			 * \param bounds Box outline of every face
+			 * \param landmarks Landmarks of every face,
+			 * may be shorter than \c bounds
+			 * */
+			void setFaces(const QVector<QVector<QPointF>>& bounds,
+			              const QVector<QVector<QPointF>>& landmarks);
+			
+			void clear();
+			
+			int size() const;
+			
+			/**
+			 * \returns Outline of face, built on first
+			 * request for the mode and zoom bucket.
+			 * */
+			const QPainterPath&
+			outline(int face, bool curve, int bucket) const;
+			
+			/**
+			 * \brief Sets stroke parameters of \c stroke.
+			 * Cached strokes are dropped only if parameters
+			 * differ from current ones.
+			 * */
+			void setStroke(qreal width, Qt::PenJoinStyle joinStyle,
+			               const QVector<qreal>& dashes);
+			
+			/**
+			 * \returns Outline stroked with current stroke
+			 * parameters, ready to be filled.
+			 * */
+			const QPainterPath&
+			stroke(int face, bool curve, int bucket) const;
+			
+			/**
+			 * \returns Zoom bucket of painter transform,
+			 * binary logarithm of scale.
+			 * */
+			static int
+			zoomBucket(const QTransform& transform);
+			
+			/**
+			 * \brief Flattened Catmull-Rom spline through points.
+			 *
+			 * \param samples Line segments per span.
+			 * */
+			static QPainterPath
+			catmullRom(const QVector<QPointF>& points, bool closed, int samples);
+		
+		private:
+			struct Entry
+			{
+				QVector<QPointF> bounds;
+				
+				QVector<QPointF> landmarks;
+				
+				//! Built paths by mode and zoom bucket
+				mutable QHash<int, QPainterPath> paths;
+				
+				//! Stroked paths, same keys as \c paths
+				mutable QHash<int, QPainterPath> strokes;
+			};
+			
+			static int
+			key(bool curve, int bucket);
+			
+			static QPainterPath
+			build(const Entry& entry, bool curve, int bucket);
+		
+		private:
+			QVector<Entry> m_faces;
+			
+			qreal m_strokeWidth = 0;
+			
+			Qt::PenJoinStyle m_joinStyle = Qt::MiterJoin;
+			
+			QVector<qreal> m_dashes;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
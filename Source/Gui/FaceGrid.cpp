@@ -0,0 +1,125 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/FaceGrid.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		FaceGrid::FaceGrid()
+				: m_bounds { },
+				  m_extent { },
+				  m_cellWidth { 1 },
+				  m_cellHeight { 1 },
+				  m_columns { 0 },
+				  m_rows { 0 },
+				  m_cells { }
+		{ }
+		
+		void FaceGrid::build(const QVector<QRectF>& bounds)
+		{
+			clear();
+			m_bounds = bounds;
+			
+			if (m_bounds.isEmpty())
+			{
+				return;
+			}
+			
+			QVector<qreal> sides { };
+			sides.reserve(m_bounds.size());
+			
+			// Union ignores empty rectangles, degenerated
+			// faces must be indexed too
+			qreal left = m_bounds.first().left(), top = m_bounds.first().top();
+			qreal right = m_bounds.first().right(), bottom = m_bounds.first().bottom();
+			
+			for (const auto& rect : m_bounds)
+			{
+				left = qMin(left, rect.left());
+				top = qMin(top, rect.top());
+				right = qMax(right, rect.right());
+				bottom = qMax(bottom, rect.bottom());
+				sides.push_back(qMax(rect.width(), rect.height()));
+			}
+			m_extent = QRectF(QPointF(left, top), QPointF(right, bottom));
+			
+			std::nth_element(sides.begin(), sides.begin() + sides.size() / 2, sides.end());
+			const qreal side = qMax(qreal(1), sides.at(sides.size() / 2));
+			
+			m_columns = qBound(1, int(std::ceil(m_extent.width() / side)), MaxCells);
+			m_rows = qBound(1, int(std::ceil(m_extent.height() / side)), MaxCells);
+			m_cellWidth = qMax(qreal(1), m_extent.width() / m_columns);
+			m_cellHeight = qMax(qreal(1), m_extent.height() / m_rows);
+			m_cells.resize(m_columns * m_rows);
+			
+			for (int face = 0; face < m_bounds.size(); ++face)
+			{
+				const auto& rect = m_bounds.at(face);
+				
+				for (int y = row(rect.top()); y <= row(rect.bottom()); ++y)
+				{
+					for (int x = column(rect.left()); x <= column(rect.right()); ++x)
+					{
+						m_cells[y * m_columns + x].push_back(face);
+					}
+				}
+			}
+		}
+		
+		void FaceGrid::clear()
+		{
+			m_bounds.clear();
+			m_extent = QRectF();
+			m_columns = m_rows = 0;
+			m_cells.clear();
+		}
+		
+		int FaceGrid::size() const
+		{
+			return m_bounds.size();
+		}
+		
+		int FaceGrid::faceAt(const QPointF& point) const
+		{
+			if (m_cells.isEmpty() || !m_extent.contains(point))
+			{
+				return -1;
+			}
+			
+			int found = -1;
+			qreal foundArea = 0;
+			
+			// Nested faces, smaller one is picked
+			for (auto face : m_cells.at(row(point.y()) * m_columns + column(point.x())))
+			{
+				const auto& rect = m_bounds.at(face);
+				const qreal area = rect.width() * rect.height();
+				
+				if (rect.contains(point) && (found < 0 || area < foundArea))
+				{
+					found = face;
+					foundArea = area;
+				}
+			}
+			return found;
+		}
+		
+		int FaceGrid::column(qreal x) const
+		{
+			return qBound(0, int((x - m_extent.left()) / m_cellWidth), m_columns - 1);
+		}
+		
+		int FaceGrid::row(qreal y) const
+		{
+			return qBound(0, int((y - m_extent.top()) / m_cellHeight), m_rows - 1);
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
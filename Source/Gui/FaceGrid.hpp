@@ -0,0 +1,76 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QRectF>
+#include <QVector>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Uniform grid over face bounds of one image.
+		 *
+		 * \details Cell side is about median face size, so
+		 * every face lies in a few cells and point query
+		 * visits one cell instead of all faces. Bounds should
+		 * include landmarks. Painting needs no such index,
+		 * scene culls face items by its own one.
+		 * */
+		class TEVIAN_API FaceGrid
+		{
+		public:
+			//! Upper limit of cells along one axis
+			static constexpr int MaxCells = 256;
+			
+			FaceGrid();
+			
+			/**
+			 * \brief Rebuilds grid, face index is position
+			 * in \c bounds.
+			 * */
+			void build(const QVector<QRectF>& bounds);
+			
+			void clear();
+			
+			int size() const;
+			
+			/**
+			 * \returns Smallest face containing \c point,
+			 * -1 if there's no such face.
+			 * */
+			int faceAt(const QPointF& point) const;
+		
+		private:
+			int column(qreal x) const;
+			
+			int row(qreal y) const;
+		
+		private:
+			QVector<QRectF> m_bounds;
+			
+			QRectF m_extent;
+			
+			qreal m_cellWidth;
+			
+			qreal m_cellHeight;
+			
+			int m_columns;
+			
+			int m_rows;
+			
+			//! Faces of every cell, row major
+			QVector<QVector<int>> m_cells;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,47 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/FaceItem.hpp"
+#include "Gui/DetectionRenderer.hpp"
+#include "Gui/OverlayLayer.hpp"
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		FaceItem::FaceItem(DetectionRenderer* renderer, int face)
+				: QGraphicsItem(renderer->overlay()),
+				  m_renderer { renderer },
+				  m_face { face },
+				  m_bounds { renderer->faceBounds(face) }
+		{
+			OverlayLayer::cache(this);
+		}
+		
+		int FaceItem::face() const
+		{
+			return m_face;
+		}
+		
+		void FaceItem::refresh()
+		{
+			prepareGeometryChange();
+			m_bounds = m_renderer->faceBounds(m_face);
+			OverlayLayer::cache(this);
+			update();
+		}
+		
+		QRectF FaceItem::boundingRect() const
+		{
+			return m_bounds;
+		}
+		
+		void FaceItem::paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*)
+		{
+			m_renderer->paintFace(painter, m_face);
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
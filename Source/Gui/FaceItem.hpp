@@ -0,0 +1,56 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QGraphicsItem>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		class DetectionRenderer;
+		
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Scene item of one detected face.
+		 *
+		 * \details Belongs to overlay layer of \c DetectionRenderer,
+		 * which computes its bounds and paints outline and
+		 * landmarks. Scene culls faces out of view and repaints
+		 * cache only of faces which changed.
+		 * */
+		class TEVIAN_API FaceItem : public QGraphicsItem
+		{
+		public:
+			FaceItem(DetectionRenderer* renderer, int face);
+			
+			int face() const;
+			
+			/**
+			 * \brief Updates bounds and cache after face
+			 * or drawing style changed.
+			 * */
+			void refresh();
+			
+			QRectF boundingRect() const Q_DECL_OVERRIDE;
+			
+			void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+			           QWidget* widget = nullptr) Q_DECL_OVERRIDE;
+		
+		private:
+			DetectionRenderer* m_renderer;
+			
+			int m_face;
+			
+			QRectF m_bounds;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,295 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Commons.hpp"
+#include "Gui/FacePainter.hpp"
+
+#include <cmath>
+
+#include <QPolygonF>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		FacePainter::FacePainter(Target target)
+				: m_geometry { },
+				  m_points { },
+				  m_curve { false },
+				  m_penWidth { 5 },
+				  m_pointSize { 5 },
+				  m_joinStyle { Qt::MiterJoin },
+				  m_penStyle { Qt::SolidLine },
+				  m_target { target },
+				  m_sprite { },
+				  m_spriteBucket { 0 },
+				  m_spritePixelRatio { 1 },
+				  m_spriteScale { 1 },
+				  m_fragments { },
+				  m_paths { },
+				  m_landmarksDirty { true }
+		{ }
+		
+		QVector<int> FacePainter::setFaces(const QVector<Details::Face>& faces)
+		{
+			QVector<QVector<QPointF>> bounds { };
+			QVector<QVector<QPointF>> landmarks { };
+			QVector<int> sources { };
+			
+			for (int i = 0; i < faces.size(); ++i)
+			{
+				const auto& face = faces.at(i);
+				
+				if (!face.landmarks.empty())
+				{
+					bounds.push_back(Math::minmax4D(face.landmarks));          // Identify face box limits
+					landmarks.push_back(face.landmarks);
+					sources.push_back(i);
+				} else if (!FaceData::isFaceEmpty(face.bounds))
+				{
+					sources.push_back(i);
+					QRectF box(face.bounds[0], face.bounds[1], face.bounds[2], face.bounds[3]);
+					bounds.push_back({ box.topLeft(), box.topRight(),
+					                   box.bottomRight(), box.bottomLeft(),
+					                   box.topLeft() });
+					landmarks.push_back(QVector<QPointF>());
+				}
+			}
+			
+			m_geometry.setFaces(bounds, landmarks);
+			m_points = landmarks;
+			m_landmarksDirty = true;
+			return sources;
+		}
+		
+		void FacePainter::clear()
+		{
+			m_points.clear();
+			m_geometry.clear();
+			m_landmarksDirty = true;
+		}
+		
+		int FacePainter::size() const
+		{
+			return m_geometry.size();
+		}
+		
+		bool FacePainter::isCurve() const
+		{
+			return m_curve;
+		}
+		
+		void FacePainter::setCurve(bool curve)
+		{
+			m_curve = curve;
+		}
+		
+		qreal FacePainter::penWidth() const
+		{
+			return m_penWidth;
+		}
+		
+		void FacePainter::setPenWidth(qreal penWidth)
+		{
+			m_penWidth = penWidth;
+		}
+		
+		Qt::PenStyle FacePainter::penStyle() const
+		{
+			return m_penStyle;
+		}
+		
+		void FacePainter::setPenStyle(Qt::PenStyle penStyle)
+		{
+			m_penStyle = penStyle;
+		}
+		
+		int FacePainter::pointSize() const
+		{
+			return m_pointSize;
+		}
+		
+		QRectF FacePainter::faceBounds(int face) const
+		{
+			// Spline may go slightly out of box points
+			QRectF bounds = m_geometry.outline(face, m_curve, 0).boundingRect();
+			
+			if (!m_points.at(face).isEmpty())
+			{
+				bounds |= QPolygonF(m_points.at(face)).boundingRect();
+			}
+			
+			const qreal margin = m_penWidth + m_pointSize;
+			return bounds.adjusted(-margin, -margin, margin, margin);
+		}
+		
+		void FacePainter::paint(QPainter* painter, int face, const QColor& color)
+		{
+			drawLandmarks(painter, face);
+			drawBox(painter, face, color);
+		}
+		
+		void FacePainter::paintLandmarks(QPainter* painter, int face)
+		{
+			drawLandmarks(painter, face);
+		}
+		
+		void FacePainter::paintPlain(QPainter* painter, int face, const QColor& color)
+		{
+			const auto& path = m_geometry.outline(face, false, FaceGeometry::zoomBucket(painter->worldTransform()));
+			
+			if (!path.isEmpty())
+			{
+				painter->setRenderHint(QPainter::Antialiasing, false);
+				painter->strokePath(path, QPen(color, 0));
+			}
+		}
+		
+		void FacePainter::drawBox(QPainter* painter, int face, const QColor& color)
+		{
+			const int bucket = FaceGeometry::zoomBucket(painter->worldTransform());
+			
+			if (m_penStyle == Qt::NoPen)
+			{
+				static const qreal space = 4;
+				static const QVector<qreal> dashes { 1, space, 3, space,
+				                                     9, space, 27, space,
+				                                     9, space, 3, space };
+				
+				// Drops cached strokes only if something changed
+				m_geometry.setStroke(m_penWidth, m_joinStyle, dashes);
+			}
+			
+			const auto& path = m_geometry.outline(face, m_curve, bucket);
+			
+			if (path.isEmpty())
+			{
+				return;
+			}
+			
+			painter->setPen(Qt::NoPen);
+			
+			// The "custom" pen
+			if (m_penStyle == Qt::NoPen)
+			{
+				painter->fillPath(m_geometry.stroke(face, m_curve, bucket), color);
+			} else
+			{
+				QPen pen(color, m_penWidth, m_penStyle, Qt::SquareCap, m_joinStyle);
+				painter->strokePath(path, pen);
+			}
+		}
+		
+		void FacePainter::drawLandmarks(QPainter* painter, int face)
+		{
+			if (m_points.value(face).isEmpty())
+			{
+				return;
+			}
+			
+			// Pixmaps may be used only in GUI thread
+			if (m_target == Image)
+			{
+				if (m_landmarksDirty)
+				{
+					updatePaths();
+				}
+				
+				painter->setPen(QPen(QColor(50, 100, 120, 200), 1));
+				painter->setBrush(QColor(100, 100, 100, 120));
+				painter->drawPath(m_paths.at(face));
+				painter->setBrush(Qt::NoBrush);
+				return;
+			}
+			
+			// Sprite is rendered at device resolution of
+			// zoom bucket, so points stay sharp when zoomed
+			// and when window moves to other screen
+			const int bucket = FaceGeometry::zoomBucket(painter->worldTransform());
+			const qreal pixelRatio = painter->device()->devicePixelRatioF();
+			
+			if (m_sprite.isNull() || bucket != m_spriteBucket || !qFuzzyCompare(pixelRatio, m_spritePixelRatio))
+			{
+				updateSprite(bucket, pixelRatio);
+			}
+			
+			if (m_landmarksDirty)
+			{
+				updateFragments();
+			}
+			
+			// All points of face in one call
+			const auto& fragments = m_fragments.at(face);
+			painter->drawPixmapFragments(fragments.constData(), fragments.size(), m_sprite);
+		}
+		
+		void FacePainter::updateSprite(int bucket, qreal pixelRatio)
+		{
+			const qreal scale = std::pow(2.0, bucket) * pixelRatio;
+			const qreal size = m_pointSize * scale;
+			const int extent = int(std::ceil(size + 2 * scale));
+			
+			QColor pencolor = QColor(50, 100, 120, 200);
+			QColor brushcolor = QColor(100, 100, 100, 120);
+			
+			QPixmap sprite(extent, extent);
+			sprite.fill(Qt::transparent);
+			
+			QPainter painter(&sprite);
+			painter.setRenderHint(QPainter::Antialiasing);
+			painter.setPen(QPen(pencolor, scale));
+			painter.setBrush(brushcolor);
+			painter.drawEllipse(QRectF((extent - size) / 2, (extent - size) / 2, size, size));
+			painter.end();
+			
+			m_sprite = sprite;
+			m_spriteBucket = bucket;
+			m_spritePixelRatio = pixelRatio;
+			m_spriteScale = scale;
+			m_landmarksDirty = true;
+		}
+		
+		void FacePainter::updateFragments()
+		{
+			const QRectF source(m_sprite.rect());
+			const qreal scale = 1 / m_spriteScale;
+			
+			m_fragments.clear();
+			for (const auto& points : m_points)
+			{
+				QVector<QPainter::PixmapFragment> fragments { };
+				fragments.reserve(points.size());
+				
+				for (const auto& point : points)
+				{
+					fragments.push_back(QPainter::PixmapFragment::create(point, source, scale, scale));
+				}
+				m_fragments.push_back(fragments);
+			}
+			m_landmarksDirty = false;
+		}
+		
+		void FacePainter::updatePaths()
+		{
+			const qreal size = m_pointSize;
+			
+			m_paths.clear();
+			for (const auto& points : m_points)
+			{
+				// Overlapping points are filled, not cut out
+				QPainterPath path { };
+				path.setFillRule(Qt::WindingFill);
+				
+				for (const auto& point : points)
+				{
+					path.addEllipse(QRectF(point.x() - size / 2, point.y() - size / 2, size, size));
+				}
+				m_paths.push_back(path);
+			}
+			m_landmarksDirty = false;
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,170 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "FaceDetector.hpp"
+#include "Gui/FaceGeometry.hpp"
+
+#include <QColor>
+#include <QPixmap>
+#include <QPainter>
+#include <QPainterPath>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Draws face outlines and landmarks of one image.
+		 *
+		 * \details Holds drawing style and cached geometry, knows
+		 * nothing about scene, so the same drawing is used by
+		 * \c DetectionRenderer on screen and by \c BatchExporter
+		 * on offscreen images. One instance mustn't be shared
+		 * between threads.
+		 * */
+		class TEVIAN_API FacePainter
+		{
+		public:
+			/**
+			 * \brief Device landmarks are drawn on.
+			 * */
+			enum Target
+			{
+				//! Landmarks are drawn by pixmap sprite,
+				//! only in GUI thread
+				Screen,
+				
+				//! Landmarks are drawn by cached ellipse path
+				//! of face, usable in any thread
+				Image
+			};
+			
+			explicit FacePainter(Target target = Screen);
+			
+			/**
+			 * \brief Sets faces to draw. Face box is built
+			 * from landmarks if there are any, otherwise from
+			 * face bounding rectangle.
+			 *
+			 * \returns Index in \c faces of every drawn face,
+			 * faces without box are skipped.
+			 * */
+			QVector<int> setFaces(const QVector<Details::Face>& faces);
+			
+			void clear();
+			
+			//! Count of drawn faces
+			int size() const;
+			
+			bool isCurve() const;
+			
+			void setCurve(bool curve);
+			
+			qreal penWidth() const;
+			
+			void setPenWidth(qreal penWidth);
+			
+			Qt::PenStyle penStyle() const;
+			
+			/**
+			 * \param penStyle Qt::NoPen selects custom dash pattern.
+			 * */
+			void setPenStyle(Qt::PenStyle penStyle);
+			
+			int pointSize() const;
+			
+			/**
+			 * \returns Bounds of face outline and landmarks
+			 * with room for pen and points.
+			 * */
+			QRectF faceBounds(int face) const;
+			
+			/**
+			 * \brief Draws landmarks and outline of face.
+			 * */
+			void paint(QPainter* painter, int face, const QColor& color);
+			
+			/**
+			 * \brief Draws landmarks of face only.
+			 * */
+			void paintLandmarks(QPainter* painter, int face);
+			
+			/**
+			 * \brief Draws box outline by hairline pen.
+			 * */
+			void paintPlain(QPainter* painter, int face, const QColor& color);
+		
+		private:
+			void drawBox(QPainter* painter, int face, const QColor& color);
+			
+			void drawLandmarks(QPainter* painter, int face);
+			
+			/**
+			 * \brief Renders landmark point sprite for
+			 * zoom bucket and device pixel ratio.
+			 * */
+			void updateSprite(int bucket, qreal pixelRatio);
+			
+			/**
+			 * \brief Places sprite on every landmark
+			 * of every face.
+			 * */
+			void updateFragments();
+			
+			/**
+			 * \brief Builds ellipse path of landmarks
+			 * of every face.
+			 * */
+			void updatePaths();
+		
+		private:
+			//! Outline paths of every face
+			FaceGeometry m_geometry;
+			
+			//! Landmarks of every face, empty for
+			//! faces known only by box
+			QVector<QVector<QPointF>> m_points;
+			
+			bool m_curve;
+			
+			qreal m_penWidth;
+			
+			int m_pointSize;
+			
+			Qt::PenJoinStyle m_joinStyle;
+			
+			Qt::PenStyle m_penStyle;
+			
+			Target m_target;
+			
+			//! Landmark point, drawn in bulk
+			QPixmap m_sprite;
+			
+			int m_spriteBucket;
+			
+			//! Device pixel ratio sprite is rendered for
+			qreal m_spritePixelRatio;
+			
+			//! Sprite pixels per scene unit
+			qreal m_spriteScale;
+			
+			QVector<QVector<QPainter::PixmapFragment>> m_fragments;
+			
+			//! Landmark ellipses of every face, drawn
+			//! in place of sprite on images
+			QVector<QPainterPath> m_paths;
+			
+			//! Set if fragments or paths miss
+			//! landmarks of faces
+			bool m_landmarksDirty;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
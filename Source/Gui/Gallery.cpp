@@ -0,0 +1,176 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/Gallery.hpp"
+#include "Gui/GalleryModel.hpp"
+#include "Gui/ThumbnailCache.hpp"
+
+#include <QDir>
+#include <QPainter>
+#include <QFileInfo>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		namespace
+		{
+			//! Rows laid out per batch
+			const int LayoutBatch = 512;
+			
+			/**
+			 * \brief Draws face count badge over thumbnail.
+			 * */
+			class GalleryDelegate : public QStyledItemDelegate
+			{
+			public:
+				using QStyledItemDelegate::QStyledItemDelegate;
+				
+				void paint(QPainter* painter, const QStyleOptionViewItem& option,
+				           const QModelIndex& index) const Q_DECL_OVERRIDE
+				{
+					QStyledItemDelegate::paint(painter, option, index);
+					
+					const auto faces = index.data(GalleryModel::FaceCountRole).toLongLong();
+					
+					if (faces < 0)
+					{
+						return;
+					}
+					
+					const auto text = QString::number(faces);
+					const auto metrics = option.fontMetrics;
+					const QRect badge(option.rect.right() - metrics.width(text) - 14,
+					                  option.rect.top() + 4,
+					                  metrics.width(text) + 10, metrics.height() + 4);
+					
+					painter->save();
+					painter->setRenderHint(QPainter::Antialiasing);
+					painter->setPen(Qt::NoPen);
+					painter->setBrush(faces > 0 ? QColor(40, 120, 200, 220) : QColor(120, 120, 120, 200));
+					painter->drawRoundedRect(badge, 4, 4);
+					painter->setPen(Qt::white);
+					painter->drawText(badge, Qt::AlignCenter, text);
+					painter->restore();
+				}
+			};
+		}
+		
+		Gallery::Gallery(QWidget* parent)
+				: QListView(parent),
+				  m_model { new GalleryModel(this) },
+				  m_filter { },
+				  m_filtered { false }
+		{
+			setModel(m_model);
+			setItemDelegate(new GalleryDelegate(this));
+			
+			setViewMode(QListView::IconMode);
+			setMovement(QListView::Static);
+			setResizeMode(QListView::Adjust);
+			setSelectionMode(QAbstractItemView::SingleSelection);
+			setIconSize(QSize(ThumbnailCache::Extent, ThumbnailCache::Extent));
+			setGridSize(QSize(ThumbnailCache::Extent + 24, ThumbnailCache::Extent + 40));
+			setUniformItemSizes(true);
+			setLayoutMode(QListView::Batched);
+			setBatchSize(LayoutBatch);
+			setWordWrap(false);
+			setTextElideMode(Qt::ElideMiddle);
+			
+			connect(this, SIGNAL(activated(
+					                     const QModelIndex&)),
+			        this, SLOT(activate(
+					                   const QModelIndex&)));
+			connect(m_model, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+			        this, SLOT(rowsAdded(const QModelIndex&, int, int)));
+			
+			m_cancelTimer.setSingleShot(true);
+			m_cancelTimer.setInterval(100);
+			connect(&m_cancelTimer, SIGNAL(timeout()), this, SLOT(cancelHidden()));
+			connect(verticalScrollBar(), SIGNAL(valueChanged(int)), &m_cancelTimer, SLOT(start()));
+		}
+		
+		void Gallery::setFiles(const QStringList& files)
+		{
+			m_model->setFiles(files);
+			m_cancelTimer.start();
+			if (m_filtered)
+			{
+				applyFilter(0, m_model->rowCount() - 1);
+			}
+			scrollToTop();
+		}
+		
+		GalleryModel* Gallery::galleryModel() const
+		{
+			return m_model;
+		}
+		
+		void Gallery::setFilter(const QSet<QString>& images)
+		{
+			m_filter = images;
+			m_filtered = true;
+			applyFilter(0, m_model->rowCount() - 1);
+			scrollToTop();
+			m_cancelTimer.start();
+		}
+		
+		void Gallery::clearFilter()
+		{
+			m_filter.clear();
+			m_filtered = false;
+			applyFilter(0, m_model->rowCount() - 1);
+		}
+		
+		void Gallery::rowsAdded(const QModelIndex& parent, int first, int last)
+		{
+			Q_UNUSED(parent)
+			
+			if (m_filtered)
+			{
+				applyFilter(first, last);
+			}
+		}
+		
+		void Gallery::cancelHidden()
+		{
+			const auto visible = viewport()->rect();
+			QStringList hidden { };
+			
+			for (const auto& path : g_thumbnailCache->cancelable())
+			{
+				const int row = m_model->row(path);
+				
+				if (row < 0 || isRowHidden(row) || !visualRect(m_model->index(row)).intersects(visible))
+				{
+					hidden.push_back(path);
+				}
+			}
+			g_thumbnailCache->cancel(hidden);
+		}
+		
+		void Gallery::applyFilter(int first, int last)
+		{
+			const auto& files = m_model->files();
+			
+			for (int row = first; row <= last; ++row)
+			{
+				const auto path = QDir::cleanPath(QFileInfo(files.at(row)).absoluteFilePath());
+				setRowHidden(row, m_filtered && !m_filter.contains(path));
+			}
+		}
+		
+		void Gallery::activate(const QModelIndex& index)
+		{
+			if (index.isValid())
+			{
+				emit imageActivated(index.data(GalleryModel::PathRole).toString());
+			}
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,86 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QSet>
+#include <QTimer>
+#include <QListView>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		class GalleryModel;
+		
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Thumbnail grid of image files.
+		 *
+		 * \details Cells have uniform size, so view lays
+		 * out any number of files without asking model
+		 * and requests thumbnails only of visible cells.
+		 * Face count is shown over thumbnail of images
+		 * with results.
+		 * */
+		class TEVIAN_API Gallery : public QListView
+		{
+		Q_OBJECT
+		public:
+			explicit Gallery(QWidget* parent = nullptr);
+			
+			void setFiles(const QStringList& files);
+			
+			GalleryModel* galleryModel() const;
+			
+			/**
+			 * \brief Shows only given images, files added
+			 * later are filtered too.
+			 * */
+			void setFilter(const QSet<QString>& images);
+			
+			void clearFilter();
+		
+		signals:
+			
+			/**
+			 * \brief Emitted when user opens image.
+			 * */
+			void imageActivated(const QString& path);
+		
+		private slots:
+			
+			void activate(const QModelIndex& index);
+			
+			void rowsAdded(const QModelIndex& parent, int first, int last);
+			
+			/**
+			 * \brief Cancels thumbnail requests of cells
+			 * out of viewport.
+			 * */
+			void cancelHidden();
+		
+		private:
+			void applyFilter(int first, int last);
+		
+		private:
+			GalleryModel* m_model;
+			
+			//! Shown images, cleaned absolute paths
+			QSet<QString> m_filter;
+			
+			bool m_filtered;
+			
+			//! Started by scrolling, cancels requests
+			//! once view settles
+			QTimer m_cancelTimer;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
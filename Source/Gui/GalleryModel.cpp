@@ -0,0 +1,122 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Statistics.hpp"
+#include "Gui/GalleryModel.hpp"
+#include "Gui/ThumbnailCache.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		GalleryModel::GalleryModel(QObject* parent)
+				: QAbstractListModel(parent),
+				  m_files { },
+				  m_rows { }
+		{
+			connect(g_thumbnailCache, SIGNAL(thumbnailReady(
+					                                 const QString&)),
+			        this, SLOT(thumbnailReady(
+					                   const QString&)));
+			
+			// Updates may come from detection threads
+			connect(g_statistics, SIGNAL(updated()), this, SLOT(statisticsUpdated()), Qt::QueuedConnection);
+		}
+		
+		void GalleryModel::setFiles(const QStringList& files)
+		{
+			beginResetModel();
+			m_files = files;
+			m_rows.clear();
+			m_rows.reserve(files.size());
+			
+			for (int i = 0; i < m_files.size(); ++i)
+			{
+				m_rows.insert(m_files.at(i), i);
+			}
+			endResetModel();
+		}
+		
+		void GalleryModel::addFiles(const QStringList& files)
+		{
+			QStringList added { };
+			for (const auto& file : files)
+			{
+				if (!m_rows.contains(file))
+				{
+					m_rows.insert(file, m_files.size() + added.size());
+					added.push_back(file);
+				}
+			}
+			
+			if (added.isEmpty())
+			{
+				return;
+			}
+			
+			beginInsertRows(QModelIndex(), m_files.size(), m_files.size() + added.size() - 1);
+			m_files += added;
+			endInsertRows();
+		}
+		
+		const QStringList& GalleryModel::files() const
+		{
+			return m_files;
+		}
+		
+		int GalleryModel::row(const QString& path) const
+		{
+			return m_rows.value(path, -1);
+		}
+		
+		int GalleryModel::rowCount(const QModelIndex& parent) const
+		{
+			return parent.isValid() ? 0 : m_files.size();
+		}
+		
+		QVariant GalleryModel::data(const QModelIndex& index, int role) const
+		{
+			if (!index.isValid() || index.row() >= m_files.size())
+			{
+				return QVariant();
+			}
+			
+			const auto& path = m_files.at(index.row());
+			
+			switch (role)
+			{
+				case Qt::DisplayRole    : return QFileInfo(path).fileName();
+				case Qt::ToolTipRole    : return QDir::toNativeSeparators(path);
+				case Qt::DecorationRole : return g_thumbnailCache->thumbnail(path, true);
+				case PathRole           : return path;
+				case FaceCountRole      : return g_statistics->faces(path);
+				default: return QVariant();
+			}
+		}
+		
+		void GalleryModel::thumbnailReady(const QString& path)
+		{
+			const auto row = m_rows.constFind(path);
+			
+			if (row != m_rows.constEnd())
+			{
+				emit dataChanged(index(*row), index(*row), { Qt::DecorationRole });
+			}
+		}
+		
+		void GalleryModel::statisticsUpdated()
+		{
+			// View repaints only visible rows
+			if (!m_files.isEmpty())
+			{
+				emit dataChanged(index(0), index(m_files.size() - 1), { FaceCountRole });
+			}
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,77 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QHash>
+#include <QStringList>
+#include <QAbstractListModel>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief List of image files for gallery.
+		 *
+		 * \details Model holds only paths. Thumbnails and face
+		 * counts are looked up when view asks for them, and view
+		 * asks only for visible rows, so gallery cost doesn't
+		 * depend on number of files.
+		 * */
+		class TEVIAN_API GalleryModel : public QAbstractListModel
+		{
+		Q_OBJECT
+		public:
+			enum Role
+			{
+				//! Absolute image path
+				PathRole = Qt::UserRole,
+				
+				//! Number of found faces, -1 if not detected
+				FaceCountRole
+			};
+			
+			explicit GalleryModel(QObject* parent = nullptr);
+			
+			void setFiles(const QStringList& files);
+			
+			/**
+			 * \brief Appends files to end of list, files
+			 * already in model are skipped.
+			 * */
+			void addFiles(const QStringList& files);
+			
+			const QStringList& files() const;
+			
+			/**
+			 * \returns Row of path, -1 if it isn't in model.
+			 * */
+			int row(const QString& path) const;
+			
+			int rowCount(const QModelIndex& parent = QModelIndex()) const Q_DECL_OVERRIDE;
+			
+			QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+		
+		private slots:
+			
+			void thumbnailReady(const QString& path);
+			
+			void statisticsUpdated();
+		
+		private:
+			QStringList m_files;
+			
+			//! Row of every path
+			QHash<QString, int> m_rows;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -18,14 +18,15 @@ namespace Tevian
 	{
 		//Tab holder
 		ImageBook::ImageBook(QWidget* parent)
-				: QTabWidget(parent)
+				: QTabWidget(parent),
+				  m_current { nullptr }
 		{
 			init();
 		}
 		
 		bool ImageBook::loadImage(const QString& file)
 		{
-			auto tab = new ImageViewTab(file, this);
+			auto tab = new LazyImageTab(file, this);
 			
 			auto current = addTab(tab, file.split(QDir::separator()).back());
 			tabBar()->setCurrentIndex(current);
@@ -36,7 +37,19 @@ namespace Tevian
 		{
 			try
 			{
+				auto tab = widget(tabBar()->currentIndex());
+				
+				if (!tab)
+				{
+					return false;
+				}
 				removeTab(tabBar()->currentIndex());
+				
+				if (tab == m_current)
+				{
+					m_current = nullptr;
+				}
+				tab->deleteLater();
 				return true;
 			} catch (...)
 			{
@@ -59,6 +72,46 @@ namespace Tevian
 			
 			connect(closeAct, SIGNAL(triggered(bool)), this, SLOT(closeTab()));
 			connect(tabBar(), &QTabBar::tabCloseRequested, this, &ImageBook::closeTab);
+			connect(this, SIGNAL(currentChanged(int)), SLOT(switchTab(int)));
+			
+			m_activateTimer.setSingleShot(true);
+			m_activateTimer.setInterval(0);
+			connect(&m_activateTimer, SIGNAL(timeout()), SLOT(activateCurrent()));
+			
+			m_compactTimer.setInterval(LazyImageTab::IdleTimeout / 4);
+			connect(&m_compactTimer, SIGNAL(timeout()), SLOT(compactTabs()));
+			m_compactTimer.start();
+		}
+		
+		void ImageBook::switchTab(int)
+		{
+			if (m_current)
+			{
+				m_current->deactivate();
+				m_current = nullptr;
+			}
+			m_activateTimer.start();
+		}
+		
+		void ImageBook::activateCurrent()
+		{
+			m_current = qobject_cast<LazyImageTab*>(currentWidget());
+			
+			if (m_current)
+			{
+				m_current->activate();
+			}
+		}
+		
+		void ImageBook::compactTabs()
+		{
+			for (int i = 0; i < count(); ++i)
+			{
+				if (auto tab = qobject_cast<LazyImageTab*>(widget(i)))
+				{
+					tab->compact();
+				}
+			}
 		}
 		
 		void ImageBook::showWidgets()
@@ -6,7 +6,9 @@
 
 
 #include "Gui/ImageViewTab.hpp"
+#include "Gui/LazyImageTab.hpp"
 
+#include <QTimer>
 #include <QTabWidget>
 
 
@@ -27,7 +29,9 @@ namespace Tevian
 		 *
 		 * Shows image widgets as tabbed items.
 		 *
-		 * Contains a pointer list to loaded images
+		 * Tabs are \c LazyImageTab pages, only current one
+		 * builds image viewer. Viewers of pages inactive for
+		 * long time are destroyed periodically.
 		 * */
 		class TEVIAN_API ImageBook : public QTabWidget
 		{
@@ -48,10 +52,31 @@ namespace Tevian
 		private slots:
 			
 			bool closeTab();
+			
+			void switchTab(int index);
+			
+			/**
+			 * \brief Builds viewer of current page.
+			 * */
+			void activateCurrent();
+			
+			/**
+			 * \brief Destroys viewers of idle pages.
+			 * */
+			void compactTabs();
 		
 		private:
 			void init();
 		
+		private:
+			//! Page shown last
+			LazyImageTab* m_current;
+			
+			//! Defers activation, so opening many files
+			//! builds viewer only of last one
+			QTimer m_activateTimer;
+			
+			QTimer m_compactTimer;
 		};
 	}// namespace Gui
 }// namespace Tevian
\ No newline at end of file
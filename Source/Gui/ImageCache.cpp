@@ -0,0 +1,144 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/ImageCache.hpp"
+#include "Gui/RenderItem.hpp"
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		ImageCache::ImageCache()
+				: QObject(nullptr),
+				  m_entries { },
+				  m_budget { DefaultBudget },
+				  m_usage { 0 },
+				  m_stamp { 0 }
+		{ }
+		
+		ImageCache*
+		ImageCache::getImageCache()
+		{
+			static ImageCache instance;
+			return &instance;
+		}
+		
+		void ImageCache::setBudget(qint64 bytes)
+		{
+			m_budget = qMax<qint64>(0, bytes);
+			evict();
+			emit usageChanged(m_usage, m_budget);
+		}
+		
+		qint64 ImageCache::budget() const
+		{
+			return m_budget;
+		}
+		
+		qint64 ImageCache::usage() const
+		{
+			return m_usage;
+		}
+		
+		void ImageCache::insert(RenderItem* owner)
+		{
+			auto index = find(owner);
+			
+			if (index < 0)
+			{
+				m_entries.push_back({ owner, 0, 0, false, false });
+				index = m_entries.size() - 1;
+			}
+			
+			auto& entry = m_entries[index];
+			m_usage += owner->memoryUsage() - entry.bytes;
+			entry.bytes = owner->memoryUsage();
+			entry.stamp = ++m_stamp;
+			entry.evicted = false;
+			
+			// Owner may be painting its new pixmap now
+			evict(owner);
+			emit usageChanged(m_usage, m_budget);
+		}
+		
+		void ImageCache::remove(RenderItem* owner)
+		{
+			const auto index = find(owner);
+			
+			if (index < 0)
+			{
+				return;
+			}
+			
+			m_usage -= m_entries.at(index).bytes;
+			m_entries.remove(index);
+			emit usageChanged(m_usage, m_budget);
+		}
+		
+		void ImageCache::setPinned(RenderItem* owner, bool pinned)
+		{
+			auto index = find(owner);
+			
+			if (index < 0)
+			{
+				m_entries.push_back({ owner, owner->memoryUsage(), 0, false, false });
+				m_usage += owner->memoryUsage();
+				index = m_entries.size() - 1;
+			}
+			
+			m_entries[index].pinned = pinned;
+			m_entries[index].stamp = ++m_stamp;
+			
+			evict(owner);
+			emit usageChanged(m_usage, m_budget);
+		}
+		
+		int ImageCache::find(RenderItem* owner) const
+		{
+			for (int i = 0; i < m_entries.size(); ++i)
+			{
+				if (m_entries.at(i).owner == owner)
+				{
+					return i;
+				}
+			}
+			return -1;
+		}
+		
+		void ImageCache::evict(RenderItem* keep)
+		{
+			while (m_usage > m_budget)
+			{
+				int oldest = -1;
+				
+				for (int i = 0; i < m_entries.size(); ++i)
+				{
+					const auto& entry = m_entries.at(i);
+					
+					if (!entry.pinned && !entry.evicted && entry.owner != keep
+					    && (oldest < 0 || entry.stamp < m_entries.at(oldest).stamp))
+					{
+						oldest = i;
+					}
+				}
+				
+				// Only visible and evicted images are left
+				if (oldest < 0)
+				{
+					return;
+				}
+				
+				// Preview left by owner still counts, it's
+				// counted again in full when owner reloads
+				auto& entry = m_entries[oldest];
+				entry.owner->evict();
+				entry.evicted = true;
+				m_usage += entry.owner->memoryUsage() - entry.bytes;
+				entry.bytes = entry.owner->memoryUsage();
+			}
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
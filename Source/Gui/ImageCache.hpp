@@ -0,0 +1,111 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QObject>
+#include <QVector>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		class RenderItem;
+		
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Accounts memory of decoded images of all
+		 * tabs against one budget.
+		 *
+		 * \details When usage exceeds budget, least recently
+		 * used images which aren't pinned are evicted: their
+		 * owner keeps only preview and decodes image again
+		 * when it's shown. Evicted owners stay accounted with
+		 * what they still hold. Tabs pin images while they're
+		 * visible.
+		 *
+		 * \note Methods must be called from GUI thread.
+		 * */
+		class TEVIAN_API ImageCache : public QObject
+		{
+		Q_OBJECT
+		public:
+			//! Budget if it isn't set in settings, bytes
+			static constexpr qint64 DefaultBudget = qint64(1024) * 1024 * 1024;
+			
+			static ImageCache*
+			getImageCache();
+			
+			void setBudget(qint64 bytes);
+			
+			qint64 budget() const;
+			
+			qint64 usage() const;
+			
+			/**
+			 * \brief Adds or updates memory usage of owner
+			 * and marks it most recently used.
+			 * */
+			void insert(RenderItem* owner);
+			
+			void remove(RenderItem* owner);
+			
+			/**
+			 * \brief Pinned images are never evicted.
+			 * Owner is added if it isn't known yet.
+			 * */
+			void setPinned(RenderItem* owner, bool pinned);
+		
+		signals:
+			
+			void usageChanged(qint64 usage, qint64 budget);
+		
+		private:
+			struct Entry
+			{
+				RenderItem* owner;
+				
+				qint64 bytes;
+				
+				//! Use order, larger is more recent
+				quint64 stamp;
+				
+				bool pinned;
+				
+				//! Set while owner holds only what's left
+				//! after eviction
+				bool evicted;
+			};
+			
+			ImageCache();
+			
+			int find(RenderItem* owner) const;
+			
+			/**
+			 * \brief Evicts least recently used images
+			 * until usage fits into budget.
+			 *
+			 * \param keep Owner which isn't evicted
+			 * */
+			void evict(RenderItem* keep = nullptr);
+		
+		private:
+			QVector<Entry> m_entries;
+			
+			qint64 m_budget;
+			
+			qint64 m_usage;
+			
+			quint64 m_stamp;
+		};
+		
+		static ImageCache* g_imageCache = ImageCache::getImageCache();
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
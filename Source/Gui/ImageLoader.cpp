@@ -0,0 +1,142 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/ImageLoader.hpp"
+
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QImageReader>
+#include <QMutexLocker>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		struct ImageLoader::Job
+		{
+			QMutex mutex;
+			
+			//! Reset when loader is destroyed
+			ImageLoader* target;
+		};
+		
+		namespace
+		{
+			class LoadTask : public QRunnable
+			{
+			public:
+				LoadTask(const QString& file, const std::shared_ptr<ImageLoader::Job>& job)
+						: m_file { file },
+						  m_job { job }
+				{ }
+				
+				void run() Q_DECL_OVERRIDE
+				{
+					QImageReader reader(m_file);
+					reader.setAutoTransform(true);
+					
+					auto size = reader.size();
+					
+					// Size is of stored image, before orientation
+					if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+					{
+						size.transpose();
+					}
+					
+					const bool preview = size.isValid()
+					                     && qMax(size.width(), size.height()) > ImageLoader::PreviewExtent;
+					
+					if (preview)
+					{
+						const auto scaled = reader.size().scaled(ImageLoader::PreviewExtent,
+						                                         ImageLoader::PreviewExtent,
+						                                         Qt::KeepAspectRatio);
+						reader.setScaledSize(scaled);
+						
+						if (!post(reader.read(), size, false))
+						{
+							return;
+						}
+						
+						// Reader can't rewind after reading
+						reader.setFileName(m_file);
+						reader.setScaledSize(QSize());
+					}
+					
+					const auto image = reader.read();
+					
+					if (image.isNull())
+					{
+						QMutexLocker locker(&m_job->mutex);
+						if (m_job->target)
+						{
+							QMetaObject::invokeMethod(m_job->target, "failed", Qt::QueuedConnection,
+							                          Q_ARG(QString, m_file));
+						}
+						return;
+					}
+					post(image, image.size(), true);
+				}
+			
+			private:
+				/**
+				 * \returns false if loader is gone.
+				 * */
+				bool post(const QImage& image, const QSize& size, bool final)
+				{
+					QMutexLocker locker(&m_job->mutex);
+					
+					if (!m_job->target)
+					{
+						return false;
+					}
+					
+					if (!image.isNull())
+					{
+						QMetaObject::invokeMethod(m_job->target, "loaded", Qt::QueuedConnection,
+						                          Q_ARG(QImage, image), Q_ARG(QSize, size),
+						                          Q_ARG(bool, final));
+					}
+					return true;
+				}
+			
+			private:
+				QString m_file;
+				
+				std::shared_ptr<ImageLoader::Job> m_job;
+			};
+		}
+		
+		ImageLoader::ImageLoader(const QString& file, QObject* parent)
+				: QObject(parent),
+				  m_file { file },
+				  m_job { std::make_shared<Job>() }
+		{
+			m_job->target = this;
+		}
+		
+		ImageLoader::~ImageLoader()
+		{
+			// Posted results are dropped with this object
+			QMutexLocker locker(&m_job->mutex);
+			m_job->target = nullptr;
+		}
+		
+		void ImageLoader::start()
+		{
+			pool()->start(new LoadTask(m_file, m_job));
+		}
+		
+		QThreadPool*
+		ImageLoader::pool()
+		{
+			// Default thread count is number of cores
+			static QThreadPool instance;
+			return &instance;
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,82 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <memory>
+
+#include <QSize>
+#include <QImage>
+#include <QObject>
+#include <QString>
+
+
+class QThreadPool;
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Decodes image file in background.
+		 *
+		 * \details Scaled preview is decoded first, for JPEG
+		 * it's done by reader in DCT domain and costs a fraction
+		 * of full decoding. Full resolution image follows.
+		 * All loaders share one pool, so opening many files
+		 * doesn't start more decoding threads than cores.
+		 * */
+		class TEVIAN_API ImageLoader : public QObject
+		{
+		Q_OBJECT
+		public:
+			//! Longest side of preview image
+			static constexpr int PreviewExtent = 1024;
+			
+			//! State shared with decoding task
+			struct Job;
+			
+			explicit ImageLoader(const QString& file, QObject* parent = nullptr);
+			
+			~ImageLoader() Q_DECL_OVERRIDE;
+			
+			/**
+			 * \brief Queues decoding, \c loaded is emitted
+			 * for preview and for full image.
+			 * */
+			void start();
+			
+			/**
+			 * \returns Pool shared by all loaders.
+			 * */
+			static QThreadPool*
+			pool();
+		
+		signals:
+			
+			/**
+			 * \param image Decoded image, may be smaller
+			 * than full image
+			 * \param size Full size of oriented image
+			 * \param final True if image is full resolution
+			 * */
+			void loaded(const QImage& image, const QSize& size, bool final);
+			
+			void failed(const QString& file);
+		
+		private:
+			QString m_file;
+			
+			//! Shared with running task, which posts
+			//! results while job has target
+			std::shared_ptr<Job> m_job;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,482 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/ImagePyramid.hpp"
+
+#include <QMutex>
+#include <QThread>
+#include <QPainter>
+#include <QRunnable>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QImageIOHandler>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		namespace
+		{
+			//! Images with more pixels are shown through pyramid
+			const qint64 LargeArea = qint64(8192) * 8192;
+			
+			//! Smaller levels are decoded at once and split
+			const qint64 WholeLevelArea = qint64(2048) * 2048;
+			
+			//! Finest level of images decoded whole, 64 MB at 32-bit
+			const qint64 UntiledLevelArea = qint64(4096) * 4096;
+			
+			//! Whole decodes of untiled images run one at a time,
+			//! each holds full resolution image while decoding
+			QMutex untiledMutex;
+			
+			QImage displayFormat(const QImage& image)
+			{
+				// Premultiplied 32-bit formats are blitted
+				// by raster engine without conversion
+				return image.convertToFormat(image.hasAlphaChannel()
+				                             ? QImage::Format_ARGB32_Premultiplied
+				                             : QImage::Format_RGB32);
+			}
+			
+			/**
+			 * \brief Task posting decoded tiles to pyramid.
+			 * */
+			class TileTask : public QRunnable
+			{
+			public:
+				TileTask(ImagePyramid* target, int level, const QSize& levelSize,
+				         const QPoint& tile, const QRect& rect)
+						: m_target { target },
+						  m_level { level },
+						  m_levelSize { levelSize },
+						  m_tile { tile },
+						  m_rect { rect }
+				{ }
+			
+			protected:
+				void post(int x, int y, const QImage& tile)
+				{
+					QMetaObject::invokeMethod(m_target, "insertTile", Qt::QueuedConnection,
+					                          Q_ARG(int, m_level), Q_ARG(int, x), Q_ARG(int, y),
+					                          Q_ARG(QImage, tile));
+				}
+				
+				/**
+				 * \brief Splits image of whole level into tiles.
+				 * */
+				void postLevel(const QImage& image)
+				{
+					for (int y = 0; y * ImagePyramid::TileSize < m_levelSize.height(); ++y)
+					{
+						for (int x = 0; x * ImagePyramid::TileSize < m_levelSize.width(); ++x)
+						{
+							post(x, y, image.copy(QRect(x * ImagePyramid::TileSize,
+							                            y * ImagePyramid::TileSize,
+							                            ImagePyramid::TileSize,
+							                            ImagePyramid::TileSize)
+									                      .intersected(image.rect())));
+						}
+					}
+					QMetaObject::invokeMethod(m_target, "finishLevel", Qt::QueuedConnection,
+					                          Q_ARG(int, m_level));
+				}
+			
+			protected:
+				//! Outlives task, its pool waits for tasks
+				ImagePyramid* m_target;
+				
+				int m_level;
+				
+				QSize m_levelSize;
+				
+				QPoint m_tile;
+				
+				//! Tile rectangle in level coordinates,
+				//! null for whole level
+				QRect m_rect;
+			};
+			
+			/**
+			 * \brief Decodes one tile, or all tiles of level
+			 * if \c rect is null, of image which reader clips
+			 * and scales while decoding.
+			 * */
+			class DecodeTask : public TileTask
+			{
+			public:
+				DecodeTask(ImagePyramid* target, const QString& file, int level,
+				           const QSize& levelSize, const QPoint& tile, const QRect& rect)
+						: TileTask(target, level, levelSize, tile, rect),
+						  m_file { file }
+				{ }
+				
+				void run() Q_DECL_OVERRIDE
+				{
+					QImageReader reader(m_file);
+					
+					if (m_rect.isNull())
+					{
+						reader.setScaledSize(m_levelSize);
+						postLevel(displayFormat(reader.read()));
+						return;
+					}
+					
+					// Source rectangle in full resolution,
+					// only this part is decoded
+					const QRect source(m_rect.x() << m_level, m_rect.y() << m_level,
+					                   m_rect.width() << m_level, m_rect.height() << m_level);
+					reader.setClipRect(source.intersected(QRect(QPoint(0, 0), reader.size())));
+					reader.setScaledSize(m_rect.size());
+					post(m_tile.x(), m_tile.y(), displayFormat(reader.read()));
+				}
+			
+			private:
+				QString m_file;
+			};
+			
+			/**
+			 * \brief Cuts tile, or all tiles of level, from
+			 * base image of untiled pyramid, nothing is decoded.
+			 * */
+			class CutTask : public TileTask
+			{
+			public:
+				CutTask(ImagePyramid* target, const QImage& base, int level,
+				        const QSize& levelSize, const QPoint& tile, const QRect& rect)
+						: TileTask(target, level, levelSize, tile, rect),
+						  m_base { base }
+				{ }
+				
+				void run() Q_DECL_OVERRIDE
+				{
+					if (!m_rect.isNull())
+					{
+						post(m_tile.x(), m_tile.y(), m_base.copy(m_rect));
+						return;
+					}
+					
+					postLevel(m_base.size() == m_levelSize
+					          ? m_base
+					          : m_base.scaled(m_levelSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+				}
+			
+			private:
+				//! Shared with pyramid, read only
+				QImage m_base;
+			};
+			
+			/**
+			 * \brief Decodes untiled image once at size of
+			 * its finest pyramid level.
+			 * */
+			class BaseTask : public QRunnable
+			{
+			public:
+				BaseTask(ImagePyramid* target, const QString& file, const QSize& size)
+						: m_target { target },
+						  m_file { file },
+						  m_size { size }
+				{ }
+				
+				void run() Q_DECL_OVERRIDE
+				{
+					QImage base;
+					{
+						QMutexLocker locker(&untiledMutex);
+						QImageReader reader(m_file);
+						reader.setScaledSize(m_size);
+						base = displayFormat(reader.read());
+					}
+					QMetaObject::invokeMethod(m_target, "setBase", Qt::QueuedConnection,
+					                          Q_ARG(QImage, base));
+				}
+			
+			private:
+				ImagePyramid* m_target;
+				
+				QString m_file;
+				
+				QSize m_size;
+			};
+		}
+		
+		ImagePyramid::ImagePyramid(const QString& file, QObject* parent)
+				: QObject(parent),
+				  m_file { file },
+				  m_size { },
+				  m_levelCount { 1 },
+				  m_tiled { false },
+				  m_firstLevel { 0 },
+				  m_base { },
+				  m_loadingBase { false },
+				  m_tiles { },
+				  m_pending { },
+				  m_pendingLevels { }
+		{
+			QImageReader reader(file);
+			m_size = reader.size();
+			
+			// Readers of PNG, TIFF, BMP and others decode whole
+			// image and crop or scale it afterwards
+			m_tiled = reader.supportsOption(QImageIOHandler::ClipRect)
+			          && reader.supportsOption(QImageIOHandler::ScaledSize);
+			
+			while (qMax(levelSize(m_levelCount - 1).width(),
+			            levelSize(m_levelCount - 1).height()) > TileSize)
+			{
+				++m_levelCount;
+			}
+			
+			while (!m_tiled && m_firstLevel < m_levelCount - 1
+			       && qint64(levelSize(m_firstLevel).width()) * levelSize(m_firstLevel).height() > UntiledLevelArea)
+			{
+				++m_firstLevel;
+			}
+			
+			m_tiles.setMaxCost(int(DefaultBudget / 1024));
+			m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+		}
+		
+		ImagePyramid::~ImagePyramid()
+		{
+			// Decoded tiles of running tasks are dropped
+			// with posted events of this object
+			m_pool.clear();
+			m_pool.waitForDone();
+		}
+		
+		bool ImagePyramid::isLarge(const QSize& size)
+		{
+			return qint64(size.width()) * size.height() > LargeArea;
+		}
+		
+		bool ImagePyramid::isTiled() const
+		{
+			return m_tiled;
+		}
+		
+		QSize ImagePyramid::size() const
+		{
+			return m_size;
+		}
+		
+		int ImagePyramid::levelCount() const
+		{
+			return m_levelCount;
+		}
+		
+		QSize ImagePyramid::levelSize(int level) const
+		{
+			const int divisor = 1 << level;
+			return QSize(qMax(1, (m_size.width() + divisor - 1) / divisor),
+			             qMax(1, (m_size.height() + divisor - 1) / divisor));
+		}
+		
+		int ImagePyramid::level(qreal scale) const
+		{
+			// Untiled images have no finer levels
+			int level = m_firstLevel;
+			scale *= 1 << m_firstLevel;
+			
+			while (level < m_levelCount - 1 && scale * 2 <= 1)
+			{
+				scale *= 2;
+				++level;
+			}
+			return level;
+		}
+		
+		void ImagePyramid::setBudget(qint64 bytes)
+		{
+			m_tiles.setMaxCost(int(qMax<qint64>(1, bytes / 1024)));
+		}
+		
+		qint64 ImagePyramid::memoryUsage() const
+		{
+			return qint64(m_tiles.totalCost()) * 1024
+			       + qint64(m_base.bytesPerLine()) * m_base.height();
+		}
+		
+		void ImagePyramid::evict()
+		{
+			m_tiles.clear();
+			m_base = QImage();
+		}
+		
+		void ImagePyramid::paint(QPainter* painter, const QRectF& exposed, qreal scale, bool fast)
+		{
+			const int level = this->level(scale);
+			const qreal factor = 1 << level;
+			
+			const QRect area = QRectF(exposed.x() / factor, exposed.y() / factor,
+			                          exposed.width() / factor, exposed.height() / factor)
+					.toAlignedRect()
+					.intersected(QRect(QPoint(0, 0), levelSize(level)));
+			
+			if (area.isEmpty())
+			{
+				return;
+			}
+			
+			painter->save();
+			painter->setRenderHint(QPainter::SmoothPixmapTransform, !fast);
+			
+			for (int y = area.top() / TileSize; y <= area.bottom() / TileSize; ++y)
+			{
+				for (int x = area.left() / TileSize; x <= area.right() / TileSize; ++x)
+				{
+					const auto tile = m_tiles.object(tileKey(level, x, y));
+					
+					if (tile)
+					{
+						const auto rect = tileRect(level, x, y);
+						painter->drawImage(QRectF(rect.x() * factor, rect.y() * factor,
+						                          rect.width() * factor, rect.height() * factor),
+						                   *tile);
+						continue;
+					}
+					
+					const bool covered = paintFallback(painter, level, x, y);
+					
+					// Levels passed while zooming aren't decoded,
+					// exact tiles are requested once view is idle
+					if (!fast || !covered)
+					{
+						request(level, x, y);
+					}
+					
+					// Blank until coarsest level is loaded
+					if (!covered)
+					{
+						request(m_levelCount - 1, 0, 0);
+					}
+				}
+			}
+			painter->restore();
+		}
+		
+		void ImagePyramid::insertTile(int level, int x, int y, const QImage& tile)
+		{
+			const auto key = tileKey(level, x, y);
+			m_pending.remove(key);
+			
+			if (tile.isNull())
+			{
+				return;
+			}
+			
+			m_tiles.insert(key, new QImage(tile), qMax(1, tile.bytesPerLine() * tile.height() / 1024));
+			emit tileLoaded();
+		}
+		
+		void ImagePyramid::finishLevel(int level)
+		{
+			m_pendingLevels.remove(level);
+		}
+		
+		void ImagePyramid::setBase(const QImage& base)
+		{
+			m_loadingBase = false;
+			m_base = base;
+			
+			// Missing tiles are requested on repaint
+			if (!m_base.isNull())
+			{
+				emit tileLoaded();
+			}
+		}
+		
+		quint64
+		ImagePyramid::tileKey(int level, int x, int y)
+		{
+			return (quint64(level) << 48) | (quint64(quint32(y)) << 24) | quint64(quint32(x));
+		}
+		
+		QRect ImagePyramid::tileRect(int level, int x, int y) const
+		{
+			return QRect(x * TileSize, y * TileSize, TileSize, TileSize)
+					.intersected(QRect(QPoint(0, 0), levelSize(level)));
+		}
+		
+		void ImagePyramid::request(int level, int x, int y)
+		{
+			const auto key = tileKey(level, x, y);
+			
+			if (m_tiles.contains(key) || m_pending.contains(key) || m_pendingLevels.contains(level))
+			{
+				return;
+			}
+			
+			const auto size = levelSize(level);
+			const bool whole = qint64(size.width()) * size.height() <= WholeLevelArea;
+			
+			if (m_tiled)
+			{
+				if (whole)
+				{
+					m_pendingLevels.insert(level);
+					m_pool.start(new DecodeTask(this, m_file, level, size, QPoint(), QRect()));
+					return;
+				}
+				
+				m_pending.insert(key);
+				m_pool.start(new DecodeTask(this, m_file, level, size, QPoint(x, y), tileRect(level, x, y)));
+				return;
+			}
+			
+			// Untiled image is decoded once, tiles are cut
+			// from its finest level
+			if (m_base.isNull())
+			{
+				if (!m_loadingBase)
+				{
+					m_loadingBase = true;
+					m_pool.start(new BaseTask(this, m_file, levelSize(m_firstLevel)));
+				}
+				return;
+			}
+			
+			if (whole || level > m_firstLevel)
+			{
+				m_pendingLevels.insert(level);
+				m_pool.start(new CutTask(this, m_base, level, size, QPoint(), QRect()));
+				return;
+			}
+			
+			m_pending.insert(key);
+			m_pool.start(new CutTask(this, m_base, level, size, QPoint(x, y), tileRect(level, x, y)));
+		}
+		
+		bool ImagePyramid::paintFallback(QPainter* painter, int level, int x, int y)
+		{
+			const auto rect = tileRect(level, x, y);
+			const qreal factor = 1 << level;
+			const QRectF target(rect.x() * factor, rect.y() * factor,
+			                    rect.width() * factor, rect.height() * factor);
+			
+			// Tile lies inside one tile of every coarser level
+			for (int coarser = level + 1; coarser < m_levelCount; ++coarser)
+			{
+				const int shift = coarser - level;
+				const auto tile = m_tiles.object(tileKey(coarser, x >> shift, y >> shift));
+				
+				if (!tile)
+				{
+					continue;
+				}
+				
+				const qreal divisor = 1 << shift;
+				painter->drawImage(target, *tile,
+				                   QRectF(rect.x() / divisor - (x >> shift) * TileSize,
+				                          rect.y() / divisor - (y >> shift) * TileSize,
+				                          rect.width() / divisor, rect.height() / divisor));
+				return true;
+			}
+			return false;
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,183 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QSet>
+#include <QSize>
+#include <QRect>
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+
+class QPainter;
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Tiled multi-resolution copy of large image.
+		 *
+		 * \details Level 0 is full resolution, every next level
+		 * halves it until whole level fits into one tile. Tiles
+		 * are decoded on demand in background pool: coarse
+		 * levels are decoded whole at scaled size and split,
+		 * fine ones tile by tile with clip rectangle. Decoded
+		 * tiles are kept in cache limited by memory budget.
+		 *
+		 * Only readers clipping and scaling while decoding, like
+		 * JPEG one, keep full resolution image out of memory.
+		 * Other formats are decoded once, one image at a time,
+		 * at size of the first level not larger than 4096x4096,
+		 * and tiles of it and coarser levels are cut from that
+		 * base image. Finer levels aren't shown.
+		 *
+		 * \note Image orientation tag isn't applied.
+		 * */
+		class TEVIAN_API ImagePyramid : public QObject
+		{
+		Q_OBJECT
+		public:
+			//! Tile side in pixels of its level
+			static constexpr int TileSize = 512;
+			
+			//! Default tile cache budget in bytes
+			static constexpr qint64 DefaultBudget = 256 * 1024 * 1024;
+			
+			explicit ImagePyramid(const QString& file, QObject* parent = nullptr);
+			
+			~ImagePyramid() Q_DECL_OVERRIDE;
+			
+			/**
+			 * \returns true if image of \c size is worth
+			 * showing through pyramid.
+			 * */
+			static bool isLarge(const QSize& size);
+			
+			/**
+			 * \returns true if tiles are decoded from file,
+			 * otherwise from base image decoded once.
+			 * */
+			bool isTiled() const;
+			
+			QSize size() const;
+			
+			int levelCount() const;
+			
+			QSize levelSize(int level) const;
+			
+			/**
+			 * \returns Coarsest level having at least
+			 * \c scale device pixels per image pixel.
+			 * */
+			int level(qreal scale) const;
+			
+			void setBudget(qint64 bytes);
+			
+			/**
+			 * \returns Bytes held by cached tiles and
+			 * base image of untiled pyramid.
+			 * */
+			qint64 memoryUsage() const;
+			
+			/**
+			 * \brief Drops cached tiles and base image,
+			 * they are decoded again when painted.
+			 * */
+			void evict();
+			
+			/**
+			 * \brief Paints tiles intersecting \c exposed.
+			 *
+			 * \details Missing tiles are requested and
+			 * replaced by cached tiles of coarser levels
+			 * until they are loaded.
+			 *
+			 * \param exposed Rectangle in image coordinates
+			 * \param scale Device pixels per image pixel
+			 * \param fast Tiles aren't filtered, and missing ones
+			 * covered by coarser tiles aren't requested
+			 * */
+			void paint(QPainter* painter, const QRectF& exposed, qreal scale, bool fast = false);
+		
+		signals:
+			
+			/**
+			 * \brief Emitted when requested tile is
+			 * decoded and can be painted.
+			 * */
+			void tileLoaded();
+		
+		private slots:
+			
+			void insertTile(int level, int x, int y, const QImage& tile);
+			
+			void finishLevel(int level);
+			
+			void setBase(const QImage& base);
+		
+		private:
+			static quint64
+			tileKey(int level, int x, int y);
+			
+			/**
+			 * \returns Rectangle of tile in its level coordinates.
+			 * */
+			QRect tileRect(int level, int x, int y) const;
+			
+			/**
+			 * \brief Starts decoding of tile, or of whole level
+			 * if level is small.
+			 * */
+			void request(int level, int x, int y);
+			
+			/**
+			 * \brief Draws part of coarser cached tile in
+			 * place of missing one.
+			 *
+			 * \returns false if there's no such tile.
+			 * */
+			bool paintFallback(QPainter* painter, int level, int x, int y);
+		
+		private:
+			QString m_file;
+			
+			QSize m_size;
+			
+			int m_levelCount;
+			
+			//! Reader clips and scales while decoding
+			bool m_tiled;
+			
+			//! Finest shown level, 0 if image is tiled
+			int m_firstLevel;
+			
+			//! Finest level of untiled image
+			QImage m_base;
+			
+			bool m_loadingBase;
+			
+			//! Decoded tiles, cost in kilobytes
+			QCache<quint64, QImage> m_tiles;
+			
+			//! Tiles being decoded
+			QSet<quint64> m_pending;
+			
+			//! Levels being decoded whole
+			QSet<int> m_pendingLevels;
+			
+			QThreadPool m_pool;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
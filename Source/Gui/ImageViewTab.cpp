@@ -6,6 +6,11 @@
 #include "FaceApi.hpp"
 #include "Gui/ImageViewTab.hpp"
 #include "Gui/DetectionRenderer.hpp"
+#include "Gui/ImagePyramid.hpp"
+#include "Gui/ImageLoader.hpp"
+#include "Gui/ImageCache.hpp"
+#include "Gui/OverlayLayer.hpp"
+#include "Gui/ViewPort.hpp"
 
 #include <QLabel>
 #include <QMenu>
@@ -37,18 +42,37 @@ namespace Tevian
 				  m_file { imagefile },
 				  m_scaling { new Scaling(1.5, { "50", { 0.6, 1.5 } }) },
 				  m_view { new ViewPort(this) },
-				  m_scene { new QGraphicsScene(this) }
+				  m_scene { new QGraphicsScene(this) },
+				  m_loader { nullptr }
 		{
 			setVisible(false);
-			auto faceApi = new Client::FaceApi(g_settingsManager->url(), g_settingsManager->path());
-			m_faceDetector = new FaceDetector(m_file, faceApi);
-			QImageReader reader(m_file);
-			reader.setAutoTransform(true);
-			auto image = new QImage(reader.read());
+			m_faceApi = new Client::FaceApi(g_settingsManager->url(), g_settingsManager->path());
+			m_faceDetector = new FaceDetector(m_file, m_faceApi);
 			m_faceDetector->setParent(this);
-			m_renderer = new DetectionRenderer(image);
+			QImageReader reader(m_file);
+			
+			// Large images aren't decoded at full resolution
+			if (ImagePyramid::isLarge(reader.size()))
+			{
+				m_renderer = new DetectionRenderer(new QImage());
+				m_renderer->setPyramid(new ImagePyramid(m_file));
+			}
+			else
+			{
+				// Image is shown when preview is decoded
+				m_renderer = new DetectionRenderer(new QImage());
+				loadImage();
+			}
 			m_controls = new Controls(this, m_renderer);
 			init();
+			
+			// Show results of previous session without request
+			if (m_faceDetector->restore())
+			{
+				// Next request uses restored parameters
+				m_controls->setParameters(m_faceDetector->getFilter(), m_faceDetector->getFacets());
+				display();
+			}
 		}
 		
 		ImageViewTab::~ImageViewTab()
@@ -57,7 +81,6 @@ namespace Tevian
 			delete m_renderer;
 			delete m_controls;
 			delete m_topLayout;
-			delete m_demographicsText;
 		}
 		
 		void ImageViewTab::zoomImage(float factor)
@@ -72,9 +95,8 @@ namespace Tevian
 		{
 			m_topLayout = new QGridLayout(this);
 			m_widgetLayout = new QHBoxLayout();
-			m_demographicsText = new QGraphicsSimpleTextItem();
-			m_scene->addWidget(m_renderer);
-			m_scene->addItem(m_demographicsText);
+			m_scene->addItem(m_renderer);
+			m_scene->setSceneRect(m_renderer->boundingRect());
 			m_view->fitInView(m_scene->sceneRect(), Qt::KeepAspectRatioByExpanding);
 			m_view->setBackgroundRole(QPalette::ColorRole::Dark);
 			m_view->setScene(m_scene);
@@ -88,6 +110,10 @@ namespace Tevian
 			m_topLayout->addItem(m_widgetLayout, 1, 0);
 			m_scaling->action(Scaling::Fit)->setEnabled(true);
 			setLayout(m_topLayout);
+			
+			m_fetchTimer.setSingleShot(true);
+			m_fetchTimer.setInterval(400);
+			connect(&m_fetchTimer, SIGNAL(timeout()), SLOT(fetchFiltered()));
 			updateActions();
 		}
 		
@@ -138,8 +164,16 @@ namespace Tevian
 					                           const ControlData&)),
 			        this, SLOT(start(
 					                   const ControlData&)));
+			connect(m_controls, SIGNAL(filterData(
+					                           const ControlData&)),
+			        this, SLOT(filter(
+					                   const ControlData&)));
 			connect(m_controls, SIGNAL(clearData(bool)),
 			        this, SLOT(reset(bool)));
+			connect(m_renderer, SIGNAL(facePicked(int, Qt::KeyboardModifiers)),
+			        this, SLOT(pickFace(int, Qt::KeyboardModifiers)));
+			connect(m_view, SIGNAL(interactionChanged(bool)),
+			        m_renderer, SLOT(setInteractive(bool)));
 			
 			layout->addWidget(toolBar);
 		}
@@ -191,42 +225,154 @@ namespace Tevian
 		
 		void ImageViewTab::start(const ControlData& data)
 		{
+			m_fetchTimer.stop();
 			m_faceDetector->refetch(true, data);
 			
 			if (m_faceDetector->fetch())
 			{
 				m_faceDetector->run();
-				m_renderer->setPoints(m_faceDetector->getLandmarks());
-				m_renderer->setBox(m_faceDetector->getBox());
-				m_demographicsText->setText(m_faceDetector->getDemographics().getAsText());
-				
-				if (!m_faceDetector->getLandmarks().isEmpty())
+				display();
+			} else
+			{
+				m_renderer->update();
+			}
+		}
+		
+		void ImageViewTab::pickFace(int face, Qt::KeyboardModifiers modifiers)
+		{
+			const auto faces = m_faceDetector->getFaces();
+			
+			if (face < 0 || face >= faces.size() || FaceData::isFaceEmpty(faces.at(face).bounds))
+			{
+				return;
+			}
+			
+			// Box goes with the next request, so detector
+			// knows results are of picked face only
+			m_controls->setFace(faces.at(face).bounds, modifiers & Qt::ShiftModifier);
+		}
+		
+		void ImageViewTab::display()
+		{
+			// Show only facets requested by controls, detector
+			// may hold more of them
+			const auto facets = m_faceDetector->getFacets();
+			auto faces = m_faceDetector->getFaces();
+			
+			if (!(facets & LandmarksFacet))
+			{
+				for (auto& face : faces)
+				{
+					face.landmarks.clear();
+				}
+			}
+			m_renderer->setFaces(faces);
+			
+			clearLabels();
+			if (!(facets & DemographicsFacet))
+			{
+				return;
+			}
+			
+			if (faces.isEmpty())
+			{
+				auto label = new QGraphicsSimpleTextItem("Undefined", m_renderer->overlay());
+				label->setScale(2);
+				label->setPos(m_renderer->center());
+				OverlayLayer::cache(label);
+				m_labels.push_back(label);
+				return;
+			}
+			
+			for (const auto& face : faces)
+			{
+				auto label = new QGraphicsSimpleTextItem(face.demographics.getAsText(), m_renderer->overlay());
+				label->setScale(0.5);
+				label->setPen(QPen(m_controls->currentColor()));
+				label->setPos(face.bounds[0], face.bounds[1] - 50);
+				OverlayLayer::cache(label);
+				m_labels.push_back(label);
+			}
+		}
+		
+		void ImageViewTab::clearLabels()
+		{
+			qDeleteAll(m_labels);
+			m_labels.clear();
+		}
+		
+		void ImageViewTab::filter(const ControlData& data)
+		{
+			if (m_faceDetector->setFilter(data))
+			{
+				m_fetchTimer.stop();
+				display();
+			} else if (data._superset && m_faceDetector->hasResults())
+			{
+				// Filter goes beyond fetched superset, request
+				// is sent once slider is released and edits stop
+				m_fetchData = data;
+				m_fetchTimer.stop();
+				if (!m_controls->isAdjusting())
 				{
-					auto coordinates = Math::minmax4D(m_faceDetector->getLandmarks());
-					m_demographicsText->setScale(0.5);
-					m_demographicsText->setPen(QPen(m_controls->currentColor()));
-					m_demographicsText->setPos(
-							coordinates.first().x(),
-							coordinates.first().y() - 50
-					);
-				} else
+					m_fetchTimer.start();
+				}
+			}
+		}
+		
+		void ImageViewTab::fetchFiltered()
+		{
+			start(m_fetchData);
+		}
+		
+		void ImageViewTab::loadImage()
+		{
+			m_loader = new ImageLoader(m_file, this);
+			connect(m_loader, SIGNAL(loaded(
+					                         const QImage&, const QSize&, bool)),
+			        this, SLOT(imageLoaded(
+					                   const QImage&, const QSize&, bool)));
+			m_loader->start();
+		}
+		
+		void ImageViewTab::setActive(bool active)
+		{
+			g_imageCache->setPinned(m_renderer, active);
+			
+			if (active && m_renderer->isEvicted() && !m_loader)
+			{
+				loadImage();
+			}
+		}
+		
+		void ImageViewTab::imageLoaded(const QImage& image, const QSize& size, bool final)
+		{
+			const bool first = m_renderer->imageSize().isEmpty();
+			m_renderer->setImage(new QImage(image), size);
+			
+			if (first)
+			{
+				m_scene->setSceneRect(m_renderer->boundingRect());
+				m_view->fitInView(m_scene->sceneRect(), Qt::KeepAspectRatioByExpanding);
+				
+				// Labels of restored results are centered on image
+				if (m_faceDetector->hasResults())
 				{
-					m_demographicsText->setScale(2);
-					m_demographicsText->setText("Undefined");
-					m_demographicsText->setPos(m_renderer->center());
+					display();
 				}
-				m_demographicsText->show();
-			} else
+			}
+			
+			if (final)
 			{
-				m_renderer->update();
+				m_loader->deleteLater();
+				m_loader = nullptr;
 			}
 		}
 		
 		void ImageViewTab::reset(bool reset)
 		{
 			m_renderer->clear(reset);
-			m_demographicsText->setPen(Qt::NoPen);
-			m_demographicsText->hide();
+			clearLabels();
 		}
 		
 	}// namespace Gui
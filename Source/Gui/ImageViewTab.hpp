@@ -9,6 +9,7 @@
 #include "Gui/Scaling.hpp"
 #include "Gui/Controls.hpp"
 
+#include <QTimer>
 #include <QWidget>
 
 
@@ -37,6 +38,8 @@ namespace Tevian
 		
 		class DetectionRenderer;
 		
+		class ImageLoader;
+		
 		/**
 		 * \author Alvin Ahmadov
 		 * \namespace Tevian::Gui
@@ -67,6 +70,12 @@ namespace Tevian
 				setVisible(render);
 			};
 			
+			/**
+			 * \brief Pins image of visible tab in \c ImageCache
+			 * and decodes it again if it was evicted.
+			 * */
+			void setActive(bool active);
+			
 		private:
 			void init();
 			
@@ -75,6 +84,22 @@ namespace Tevian
 			void zoomImage(float factor);
 			
 			void updateActions();
+			
+			/**
+			 * \brief Starts background decoding of image.
+			 * */
+			void loadImage();
+			
+			/**
+			 * \brief Passes detector results to renderer
+			 * and demographics label.
+			 * */
+			void display();
+			
+			/**
+			 * \brief Removes demographics labels from scene.
+			 * */
+			void clearLabels();
 		
 		private slots:
 			/**
@@ -84,6 +109,24 @@ namespace Tevian
 			
 			void reset(bool);
 			
+			/**
+			 * \brief Shows preview or full image decoded
+			 * by loader.
+			 * */
+			void imageLoaded(const QImage& image, const QSize& size, bool final);
+			
+			/**
+			 * \brief Filters held faces by threshold and
+			 * face size without request if possible.
+			 * */
+			void filter(const ControlData& data);
+			
+			/**
+			 * \brief Requests faces of the last filter
+			 * out of fetched superset.
+			 * */
+			void fetchFiltered();
+			
 			void zoomIn();
 			
 			void zoomOut();
@@ -92,6 +135,12 @@ namespace Tevian
 			
 			void zoomFit();
 			
+			/**
+			 * \brief Sets face clicked in renderer as first
+			 * face of match request, second one with Shift.
+			 * */
+			void pickFace(int face, Qt::KeyboardModifiers modifiers);
+			
 			void wheelEvent(QWheelEvent* e) Q_DECL_OVERRIDE;
 		
 		private:
@@ -102,12 +151,18 @@ namespace Tevian
 			
 			FaceDetector* m_faceDetector;
 			
+			//! Api of detector, picked faces are set to it
+			Client::FaceApi* m_faceApi;
+			
 			ViewPort* m_view;
 			
 			QGraphicsScene* m_scene;
 			
 			DetectionRenderer* m_renderer;
 			
+			//! Decodes image until full one is shown
+			ImageLoader* m_loader;
+			
 			QToolButton* m_annotateButton;
 			
 			QGridLayout* m_topLayout;
@@ -118,7 +173,15 @@ namespace Tevian
 			
 			Controls* m_controls;
 			
-			QGraphicsSimpleTextItem* m_demographicsText;
+			//! Demographics label of every shown face
+			QList<QGraphicsSimpleTextItem*> m_labels;
+			
+			//! Delays request of filter out of superset
+			//! until controls settle
+			QTimer m_fetchTimer;
+			
+			ControlData m_fetchData;
+			
 			bool draw;
 		};
 	}// namespace Gui
@@ -0,0 +1,107 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/LazyImageTab.hpp"
+#include "Gui/ImageViewTab.hpp"
+#include "Gui/ThumbnailCache.hpp"
+
+#include <QLabel>
+#include <QPixmap>
+#include <QVBoxLayout>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		LazyImageTab::LazyImageTab(const QString& file, QWidget* parent)
+				: QWidget(parent),
+				  m_file { file },
+				  m_layout { new QVBoxLayout(this) },
+				  m_thumbnail { new QLabel(this) },
+				  m_tab { nullptr },
+				  m_active { false }
+		{
+			m_layout->setContentsMargins(0, 0, 0, 0);
+			m_layout->addWidget(m_thumbnail);
+			m_thumbnail->setAlignment(Qt::AlignCenter);
+			
+			connect(g_thumbnailCache, SIGNAL(thumbnailReady(
+					                                 const QString&)),
+			        this, SLOT(thumbnailReady(
+					                   const QString&)));
+			showThumbnail();
+		}
+		
+		const QString& LazyImageTab::file() const
+		{
+			return m_file;
+		}
+		
+		bool LazyImageTab::isLoaded() const
+		{
+			return m_tab != nullptr;
+		}
+		
+		void LazyImageTab::activate()
+		{
+			m_active = true;
+			
+			if (!m_tab)
+			{
+				m_tab = new ImageViewTab(m_file, this);
+				m_layout->addWidget(m_tab);
+				m_thumbnail->hide();
+				m_tab->render(true);
+			}
+			m_tab->setActive(true);
+		}
+		
+		void LazyImageTab::deactivate()
+		{
+			m_active = false;
+			m_inactive.start();
+			
+			if (m_tab)
+			{
+				m_tab->setActive(false);
+			}
+		}
+		
+		bool LazyImageTab::compact()
+		{
+			if (!m_tab || m_active || !m_inactive.isValid() || m_inactive.elapsed() < IdleTimeout)
+			{
+				return false;
+			}
+			
+			delete m_tab;
+			m_tab = nullptr;
+			m_thumbnail->show();
+			showThumbnail();
+			return true;
+		}
+		
+		void LazyImageTab::thumbnailReady(const QString& path)
+		{
+			if (path == m_file && !m_tab)
+			{
+				showThumbnail();
+			}
+		}
+		
+		void LazyImageTab::showThumbnail()
+		{
+			const auto thumbnail = g_thumbnailCache->thumbnail(m_file);
+			
+			if (thumbnail.isNull())
+			{
+				m_thumbnail->setText(tr("Loading %1...").arg(m_file));
+				return;
+			}
+			m_thumbnail->setPixmap(QPixmap::fromImage(thumbnail));
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QWidget>
+#include <QElapsedTimer>
+
+
+class QLabel;
+
+class QVBoxLayout;
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		class ImageViewTab;
+		
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Tab page which builds image viewer on demand.
+		 *
+		 * \details Page starts with path and thumbnail only.
+		 * \c ImageViewTab with its face api, detector, decoded
+		 * image and scene is created when page is activated
+		 * first time and destroyed again by \c compact after
+		 * page stays inactive for \c IdleTimeout. Results are
+		 * restored from results store on next activation.
+		 * */
+		class TEVIAN_API LazyImageTab : public QWidget
+		{
+		Q_OBJECT
+		public:
+			//! Inactive time in ms after which viewer is destroyed
+			static constexpr qint64 IdleTimeout = 2 * 60 * 1000;
+			
+			explicit LazyImageTab(const QString& file, QWidget* parent = nullptr);
+			
+			const QString& file() const;
+			
+			bool isLoaded() const;
+			
+			/**
+			 * \brief Builds viewer if it isn't built yet.
+			 * */
+			void activate();
+			
+			/**
+			 * \brief Starts inactivity time.
+			 * */
+			void deactivate();
+			
+			/**
+			 * \brief Destroys viewer of page inactive
+			 * longer than \c IdleTimeout.
+			 *
+			 * \returns true if viewer was destroyed.
+			 * */
+			bool compact();
+		
+		private slots:
+			
+			void thumbnailReady(const QString& path);
+		
+		private:
+			void showThumbnail();
+		
+		private:
+			QString m_file;
+			
+			QVBoxLayout* m_layout;
+			
+			QLabel* m_thumbnail;
+			
+			ImageViewTab* m_tab;
+			
+			bool m_active;
+			
+			QElapsedTimer m_inactive;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
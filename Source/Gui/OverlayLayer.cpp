@@ -0,0 +1,36 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Gui/OverlayLayer.hpp"
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		OverlayLayer::OverlayLayer(QGraphicsItem* parent)
+				: QGraphicsItem(parent)
+		{
+			setFlag(QGraphicsItem::ItemHasNoContents);
+		}
+		
+		void OverlayLayer::cache(QGraphicsItem* item)
+		{
+			// Item coordinate cache of fixed resolution blurs
+			// when zoomed past it, device cache is rendered
+			// for current zoom and exposes only visible part
+			item->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+		}
+		
+		QRectF OverlayLayer::boundingRect() const
+		{
+			return parentItem() ? parentItem()->boundingRect() : QRectF();
+		}
+		
+		void OverlayLayer::paint(QPainter*, const QStyleOptionGraphicsItem*, QWidget*)
+		{
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
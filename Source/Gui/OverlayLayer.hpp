@@ -0,0 +1,46 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QGraphicsItem>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Parent of annotation items drawn over image.
+		 *
+		 * \details Layer paints nothing itself. Its items
+		 * are cached in device coordinates, so pan and scrolling
+		 * only composite cached pixmaps over image and outlines
+		 * stay sharp at any zoom. Item is repainted into its
+		 * cache when zoom changes, or when it's updated after
+		 * results or style change.
+		 * */
+		class TEVIAN_API OverlayLayer : public QGraphicsItem
+		{
+		public:
+			explicit OverlayLayer(QGraphicsItem* parent);
+			
+			/**
+			 * \brief Sets device coordinate cache of item.
+			 * */
+			static void cache(QGraphicsItem* item);
+			
+			QRectF boundingRect() const Q_DECL_OVERRIDE;
+			
+			void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+			           QWidget* widget = nullptr) Q_DECL_OVERRIDE;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
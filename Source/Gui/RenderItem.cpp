@@ -0,0 +1,185 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+
+#include "Gui/RenderItem.hpp"
+#include "Gui/ImagePyramid.hpp"
+#include "Gui/ImageCache.hpp"
+#include "Gui/ImageLoader.hpp"
+
+#include <cmath>
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		RenderItem::RenderItem(QImage* image, QGraphicsItem* parent)
+				: QGraphicsObject(parent),
+				  m_image(image),
+				  m_pixmap { },
+				  m_size { image->size() },
+				  m_evicted { false },
+				  m_interactive { false },
+				  m_pyramid { nullptr }
+		{
+			// Pixmap is cache itself, exposed rectangle
+			// limits copying to visible part
+			setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+		}
+		
+		RenderItem::~RenderItem()
+		{
+			g_imageCache->remove(this);
+		}
+		
+		void RenderItem::setPyramid(ImagePyramid* pyramid)
+		{
+			prepareGeometryChange();
+			delete m_pyramid;
+			m_pyramid = pyramid;
+			m_pyramid->setParent(this);
+			m_pixmap = QPixmap();
+			
+			connect(m_pyramid, SIGNAL(tileLoaded()), this, SLOT(updateImage()));
+		}
+		
+		void RenderItem::setImage(QImage* image, const QSize& size)
+		{
+			prepareGeometryChange();
+			m_image.reset(image);
+			m_size = size;
+			m_pixmap = QPixmap();
+			m_evicted = false;
+			g_imageCache->insert(this);
+			update();
+		}
+		
+		void RenderItem::evict()
+		{
+			// Pyramid decodes evicted tiles again when painted,
+			// image is reloaded only without pyramid
+			if (m_pyramid)
+			{
+				m_pyramid->evict();
+				update();
+				return;
+			}
+			
+			if (m_image->width() > ImageLoader::PreviewExtent || m_image->height() > ImageLoader::PreviewExtent)
+			{
+				m_image.reset(new QImage(m_image->scaled(ImageLoader::PreviewExtent, ImageLoader::PreviewExtent,
+				                                         Qt::KeepAspectRatio, Qt::SmoothTransformation)));
+			}
+			m_pixmap = QPixmap();
+			m_evicted = true;
+			update();
+		}
+		
+		bool RenderItem::isEvicted() const
+		{
+			return m_evicted;
+		}
+		
+		qint64 RenderItem::memoryUsage() const
+		{
+			return qint64(m_image->bytesPerLine()) * m_image->height()
+			       + qint64(m_pixmap.width()) * m_pixmap.height() * m_pixmap.depth() / 8
+			       + (m_pyramid ? m_pyramid->memoryUsage() : 0);
+		}
+		
+		QSize RenderItem::imageSize() const
+		{
+			return m_pyramid ? m_pyramid->size() : m_size;
+		}
+		
+		const std::unique_ptr<QImage>&
+		RenderItem::image() const
+		{ return m_image; }
+		
+		QRectF RenderItem::boundingRect() const
+		{
+			return QRectF(QPointF(0, 0), imageSize());
+		}
+		
+		bool RenderItem::isInteractive() const
+		{
+			return m_interactive;
+		}
+		
+		void RenderItem::setInteractive(bool interactive)
+		{
+			if (m_interactive != interactive)
+			{
+				m_interactive = interactive;
+				update();
+			}
+		}
+		
+		const QPixmap&
+		RenderItem::pixmap()
+		{
+			if (m_pixmap.isNull())
+			{
+				// Premultiplied 32-bit formats are blitted
+				// by raster engine without conversion
+				const auto format = m_image->hasAlphaChannel()
+				                    ? QImage::Format_ARGB32_Premultiplied
+				                    : QImage::Format_RGB32;
+				m_pixmap = QPixmap::fromImage(m_image->convertToFormat(format));
+				g_imageCache->insert(this);
+			}
+			return m_pixmap;
+		}
+		
+		void RenderItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*)
+		{
+			const QRectF exposed = option->exposedRect.intersected(boundingRect());
+			
+			if (exposed.isEmpty())
+			{
+				return;
+			}
+			
+			if (m_pyramid)
+			{
+				// Tiles are picked for device pixels per image pixel
+				m_pyramid->paint(painter, exposed,
+				                 std::sqrt(std::abs(painter->deviceTransform().determinant())),
+				                 m_interactive);
+				return;
+			}
+			
+			const auto& cached = pixmap();
+			const qreal sx = qreal(cached.width()) / qMax(1, m_size.width());
+			const qreal sy = qreal(cached.height()) / qMax(1, m_size.height());
+			
+			// Preview is stretched until full image is loaded
+			if (!qFuzzyCompare(sx, qreal(1)) && !m_interactive)
+			{
+				painter->setRenderHint(QPainter::SmoothPixmapTransform);
+			}
+			
+			// Only exposed part of image is copied
+			painter->drawPixmap(exposed, cached,
+			                    QRectF(exposed.x() * sx, exposed.y() * sy,
+			                           exposed.width() * sx, exposed.height() * sy));
+		}
+		
+		void RenderItem::updateImage()
+		{
+			// Loaded tile changes usage of pyramid
+			if (m_pyramid)
+			{
+				g_imageCache->insert(this);
+			}
+			update();
+		}
+	
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
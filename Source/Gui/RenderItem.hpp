@@ -0,0 +1,138 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "Defines.hpp"
+
+#include <QImage>
+#include <QPixmap>
+#include <QGraphicsObject>
+
+
+class QPainter;
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		class ImagePyramid;
+		
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 * \inherit DetectionRenderer
+		 *
+		 * \brief Base class for DetectionRenderer.
+		 *
+		 * \details
+		 * Scene item drawing actual image, annotations
+		 * are added as child items by derived class.
+		 * Only exposed part of image is painted.
+		 * Holds QImage pointer and deletes it automatically.
+		 * Large images are painted from \c ImagePyramid
+		 * tiles instead, see \c setPyramid.
+		 * */
+		class TEVIAN_API RenderItem : public QGraphicsObject
+		{
+		Q_OBJECT
+		public:
+			//ctor
+			RenderItem(QImage* image, QGraphicsItem* parent = nullptr);
+			
+			//dtor
+			~RenderItem() Q_DECL_OVERRIDE;
+			
+			/**
+			 * \brief Paints image from tiles of \c pyramid,
+			 * containing image is left empty then.
+			 *
+			 * \details Item takes ownership of pyramid
+			 * and repaints when new tiles are loaded.
+			 * */
+			void setPyramid(ImagePyramid* pyramid);
+			
+			/**
+			 * \brief Replaces containing image.
+			 *
+			 * \param size Painted size, image is scaled
+			 * to it if it's preview of smaller size
+			 * */
+			void setImage(QImage* image, const QSize& size);
+			
+			/**
+			 * \brief Replaces image by preview or drops pyramid
+			 * tiles to free memory, called by \c ImageCache.
+			 * */
+			void evict();
+			
+			/**
+			 * \returns true if image was evicted and must
+			 * be decoded again.
+			 * */
+			bool isEvicted() const;
+			
+			/**
+			 * \returns Bytes held by image, its pixmap and
+			 * pyramid tiles.
+			 * */
+			qint64 memoryUsage() const;
+			
+			/**
+			 * \return Size of painted image.
+			 * */
+			QSize imageSize() const;
+			
+			/**
+			 * \return Containing image readonly.
+			 * */
+			const std::unique_ptr<QImage>&
+			image() const;
+			
+			QRectF boundingRect() const Q_DECL_OVERRIDE;
+			
+			void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+			           QWidget* widget = nullptr) Q_DECL_OVERRIDE;
+			
+			bool isInteractive() const;
+		
+		public slots:
+			
+			/**
+			 * \brief Paints fast while view is zoomed
+			 * or dragged, see \c ViewPort.
+			 * */
+			virtual void setInteractive(bool interactive);
+		
+		protected:
+			/**
+			 * \returns Image converted to display format.
+			 * */
+			const QPixmap&
+			pixmap();
+		
+		private slots:
+			
+			void updateImage();
+		
+		private:
+			
+			std::unique_ptr<QImage> m_image;
+			
+			QPixmap m_pixmap;
+			
+			//! Painted size of image
+			QSize m_size;
+			
+			bool m_evicted;
+			
+			bool m_interactive;
+			
+			ImagePyramid* m_pyramid;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
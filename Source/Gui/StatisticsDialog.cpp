@@ -0,0 +1,181 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#include "StatisticsDialog.hpp"
+#include "Statistics.hpp"
+
+#include <algorithm>
+
+#include <QFile>
+#include <QPair>
+#include <QVector>
+#include <QTextStream>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QFileDialog>
+#include <QGridLayout>
+#include <QMessageBox>
+#include <QDialogButtonBox>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		namespace
+		{
+			QString share(qint64 count, qint64 total)
+			{
+				return total > 0
+				       ? QString("%1 %").arg(100.0 * count / total, 0, 'f', 1)
+				       : QString();
+			}
+			
+			/**
+			 * \brief Adds counts to section, most frequent first.
+			 * */
+			void addCounts(QTreeWidgetItem* section, QVector<QPair<QString, qint64>> counts, qint64 total)
+			{
+				std::sort(counts.begin(), counts.end(),
+				          [ ](const QPair<QString, qint64>& a, const QPair<QString, qint64>& b)
+				          {
+					          return a.second > b.second;
+				          });
+				
+				for (const auto& count : counts)
+				{
+					new QTreeWidgetItem(section, { count.first.isEmpty() ? QString("Undefined") : count.first,
+					                               QString::number(count.second),
+					                               share(count.second, total) });
+				}
+			}
+			
+			QVector<QPair<QString, qint64>>
+			namedCounts(const QHash<StringCode, qint64>& counts)
+			{
+				QVector<QPair<QString, qint64>> named { };
+				
+				for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+				{
+					named.push_back({ g_stringTable->string(it.key()), it.value() });
+				}
+				return named;
+			}
+		}
+		
+		StatisticsDialog::StatisticsDialog(QWidget* parent, const QString& title)
+				: QDialog(parent),
+				  m_tree { new QTreeWidget(this) }
+		{
+			init();
+			setWindowTitle(title);
+		}
+		
+		void StatisticsDialog::init()
+		{
+			resize(QSize(600, 800));
+			m_tree->setColumnCount(3);
+			m_tree->setHeaderLabels({ tr("Value"), tr("Count"), tr("Share") });
+			m_tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+			
+			m_dialogButtonBox = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Close,
+			                                         Qt::Horizontal, this);
+			m_dialogButtonBox->button(QDialogButtonBox::Save)->setText(tr("Export"));
+			
+			connect(m_dialogButtonBox, SIGNAL(accepted()), SLOT(exportSummary()));
+			connect(m_dialogButtonBox, SIGNAL(rejected()), SLOT(reject()));
+			
+			// Updates may come from detection threads
+			connect(g_statistics, SIGNAL(updated()), this, SLOT(refresh()), Qt::QueuedConnection);
+			
+			setLayout(new QGridLayout(this));
+			layout()->addWidget(m_tree);
+			layout()->addWidget(m_dialogButtonBox);
+		}
+		
+		void StatisticsDialog::refresh()
+		{
+			if (!isVisible())
+			{
+				return;
+			}
+			
+			const auto summary = g_statistics->summary();
+			m_tree->clear();
+			
+			auto total = addSection(tr("Total"));
+			new QTreeWidgetItem(total, { tr("Images"), QString::number(summary.images) });
+			new QTreeWidgetItem(total, { tr("Faces"), QString::number(summary.faces) });
+			new QTreeWidgetItem(total, { tr("Mean score"), QString::number(summary.scores.mean(), 'f', 3) });
+			
+			auto age = addSection(tr("Age"));
+			new QTreeWidgetItem(age, { tr("Mean"), QString::number(summary.ageMeans.mean(), 'f', 1) });
+			new QTreeWidgetItem(age, { tr("Variance"), QString::number(summary.ageVariance(), 'f', 1) });
+			
+			for (int i = 0; i < Summary::AgeBinCount; ++i)
+			{
+				const auto bin = i == Summary::AgeBinCount - 1
+				                 ? QString("%1+").arg(i * Summary::AgeBinWidth)
+				                 : QString("%1-%2").arg(i * Summary::AgeBinWidth)
+				                                   .arg((i + 1) * Summary::AgeBinWidth - 1);
+				new QTreeWidgetItem(age, { bin, QString::number(summary.ageHistogram.at(i)),
+				                           share(summary.ageHistogram.at(i), summary.demographicFaces) });
+			}
+			
+			addCounts(addSection(tr("Gender")), namedCounts(summary.genders), summary.demographicFaces);
+			addCounts(addSection(tr("Ethnicity")), namedCounts(summary.ethnicities), summary.demographicFaces);
+			
+			QVector<QPair<QString, qint64>> attributes { };
+			
+			for (auto it = summary.attributes.constBegin(); it != summary.attributes.constEnd(); ++it)
+			{
+				attributes.push_back({ QString("%1: %2")
+						                       .arg(g_stringTable->string(StringCode(it.key() >> 32)),
+						                            g_stringTable->string(StringCode(it.key()))),
+				                       it.value() });
+			}
+			addCounts(addSection(tr("Attributes")), attributes, summary.attributeFaces);
+			
+			m_tree->expandAll();
+		}
+		
+		void StatisticsDialog::exportSummary()
+		{
+			auto file = QFileDialog::getSaveFileName(this, tr("Export Statistics"),
+			                                         QString("statistics.csv"),
+			                                         tr("CSV Files (*.csv)"));
+			
+			if (file.isEmpty())
+			{
+				return;
+			}
+			
+			QFile output(file);
+			
+			if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+			{
+				QMessageBox::warning(this, tr("Export Statistics"),
+				                     tr("Can't write \"%1\"").arg(file));
+				return;
+			}
+			
+			QTextStream(&output) << g_statistics->summary().toCsv();
+		}
+		
+		void StatisticsDialog::showEvent(QShowEvent* event)
+		{
+			QDialog::showEvent(event);
+			refresh();
+		}
+		
+		QTreeWidgetItem*
+		StatisticsDialog::addSection(const QString& name)
+		{
+			auto section = new QTreeWidgetItem(m_tree, { name });
+			section->setFirstColumnSpanned(true);
+			return section;
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
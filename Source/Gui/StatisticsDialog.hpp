@@ -0,0 +1,62 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <QDialog>
+
+class QTreeWidget;
+
+class QTreeWidgetItem;
+
+class QDialogButtonBox;
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 *
+		 * \brief Shows summary of all collected detection
+		 * results and exports it to csv file.
+		 *
+		 * \details Dialog follows \c Statistics updates
+		 * while it's visible.
+		 * */
+		class StatisticsDialog : public QDialog
+		{
+		Q_OBJECT
+		public:
+			StatisticsDialog(QWidget* parent, const QString& title = QString("Statistics"));
+		
+		public slots:
+			
+			/**
+			 * \brief Reloads summary from \c Statistics.
+			 * */
+			void refresh();
+			
+			/**
+			 * \brief Saves summary as csv file chosen by user.
+			 * */
+			void exportSummary();
+		
+		protected:
+			void showEvent(QShowEvent* event) Q_DECL_OVERRIDE;
+		
+		private:
+			void init();
+			
+			QTreeWidgetItem*
+			addSection(const QString& name);
+		
+		private:
+			QTreeWidget* m_tree;
+			
+			QDialogButtonBox* m_dialogButtonBox;
+		};
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,230 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Settings.hpp"
+#include "ResultsStore.hpp"
+#include "Gui/ImageLoader.hpp"
+#include "Gui/ThumbnailCache.hpp"
+
+#include <QDir>
+#include <QAtomicInt>
+#include <QPainter>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QImageReader>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		struct ThumbnailCache::Request
+		{
+			//! Set by GUI thread, read by task before loading
+			QAtomicInt canceled;
+			
+			//! Unset if any request isn't cancelable
+			bool cancelable;
+		};
+		
+		namespace
+		{
+			/**
+			 * \brief Reads thumbnail from cache file or
+			 * decodes and saves it there.
+			 * */
+			class ThumbnailTask : public QRunnable
+			{
+			public:
+				ThumbnailTask(ThumbnailCache* target, const QString& path, const QString& cacheFile,
+				              const std::shared_ptr<ThumbnailCache::Request>& request)
+						: m_target { target },
+						  m_path { path },
+						  m_cacheFile { cacheFile },
+						  m_request { request }
+				{ }
+				
+				void run() Q_DECL_OVERRIDE
+				{
+					const bool canceled = m_request->canceled.load();
+					QImage thumbnail { };
+					
+					if (!canceled)
+					{
+						thumbnail.load(m_cacheFile);
+						if (thumbnail.isNull())
+						{
+							thumbnail = decode();
+						}
+					}
+					
+					QMetaObject::invokeMethod(m_target, "insert", Qt::QueuedConnection,
+					                          Q_ARG(QString, m_path), Q_ARG(QImage, thumbnail),
+					                          Q_ARG(bool, canceled));
+				}
+			
+			private:
+				QImage decode() const
+				{
+					QImageReader reader(m_path);
+					reader.setAutoTransform(true);
+					
+					const auto size = reader.size();
+					if (size.isValid())
+					{
+						reader.setScaledSize(size.scaled(ThumbnailCache::Extent, ThumbnailCache::Extent,
+						                                 Qt::KeepAspectRatio));
+					}
+					
+					const auto image = reader.read();
+					if (image.isNull())
+					{
+						return image;
+					}
+					
+					// JPEG has no alpha, transparency is shown white
+					QImage thumbnail(image.size(), QImage::Format_RGB32);
+					thumbnail.fill(Qt::white);
+					QPainter painter(&thumbnail);
+					painter.drawImage(0, 0, image);
+					painter.end();
+					
+					QDir().mkpath(QFileInfo(m_cacheFile).absolutePath());
+					thumbnail.save(m_cacheFile, "JPG", 85);
+					return thumbnail;
+				}
+			
+			private:
+				//! Singleton, outlives pool tasks
+				ThumbnailCache* m_target;
+				
+				QString m_path;
+				
+				QString m_cacheFile;
+				
+				std::shared_ptr<ThumbnailCache::Request> m_request;
+			};
+		}
+		
+		ThumbnailCache::ThumbnailCache()
+				: QObject(nullptr),
+				  m_thumbnails { },
+				  m_pending { },
+				  m_failed { }
+		{
+			m_thumbnails.setMaxCost(MemoryCount);
+		}
+		
+		ThumbnailCache*
+		ThumbnailCache::getThumbnailCache()
+		{
+			static ThumbnailCache instance;
+			return &instance;
+		}
+		
+		QImage ThumbnailCache::thumbnail(const QString& path, bool cancelable)
+		{
+			if (auto cached = m_thumbnails.object(path))
+			{
+				return *cached;
+			}
+			
+			if (m_failed.contains(path))
+			{
+				return QImage();
+			}
+			
+			auto found = m_pending.constFind(path);
+			if (found != m_pending.constEnd())
+			{
+				// Task may not have started yet
+				const auto& request = found.value();
+				request->canceled.store(0);
+				request->cancelable = request->cancelable && cancelable;
+				return QImage();
+			}
+			
+			auto request = std::make_shared<Request>();
+			request->canceled.store(0);
+			request->cancelable = cancelable;
+			m_pending.insert(path, request);
+			start(path, request);
+			return QImage();
+		}
+		
+		QStringList ThumbnailCache::cancelable() const
+		{
+			QStringList paths { };
+			
+			for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it)
+			{
+				if (it.value()->cancelable && !it.value()->canceled.load())
+				{
+					paths.push_back(it.key());
+				}
+			}
+			return paths;
+		}
+		
+		void ThumbnailCache::cancel(const QStringList& paths)
+		{
+			for (const auto& path : paths)
+			{
+				const auto request = m_pending.value(path);
+				if (request && request->cancelable)
+				{
+					request->canceled.store(1);
+				}
+			}
+		}
+		
+		void ThumbnailCache::start(const QString& path, const std::shared_ptr<Request>& request)
+		{
+			// Settings are read on this thread only
+			ImageLoader::pool()->start(
+					new ThumbnailTask(this, path,
+					                  cacheFile(g_settingsManager->cachePath(), path,
+					                            QFileInfo(path).lastModified()),
+					                  request));
+		}
+		
+		QString
+		ThumbnailCache::cacheFile(const QString& directory, const QString& path, const QDateTime& modified)
+		{
+			const auto key = QString("%1|%2").arg(QFileInfo(path).absoluteFilePath())
+			                                 .arg(modified.toMSecsSinceEpoch());
+			return QDir(directory).filePath(QString("thumbnails/%1.jpg")
+					                                .arg(ResultsStore::pathHash(key), 16, 16, QChar('0')));
+		}
+		
+		void ThumbnailCache::insert(const QString& path, const QImage& thumbnail, bool canceled)
+		{
+			const auto request = m_pending.value(path);
+			
+			// Requested again after its task gave up
+			if (canceled && request && !request->canceled.load())
+			{
+				start(path, request);
+				return;
+			}
+			
+			m_pending.remove(path);
+			if (canceled)
+			{
+				return;
+			}
+			
+			if (thumbnail.isNull())
+			{
+				m_failed.insert(path);
+				return;
+			}
+			
+			m_thumbnails.insert(path, new QImage(thumbnail));
+			emit thumbnailReady(path);
+		}
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
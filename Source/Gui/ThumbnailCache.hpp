@@ -0,0 +1,111 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "Defines.hpp"
+
+#include <QSet>
+#include <QHash>
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QDateTime>
+
+
+namespace Tevian
+{
+	namespace Gui
+	{
+		/**
+		 * \author Alvin Ahmadov
+		 * \namespace Tevian::Gui
+		 *
+		 * \brief Small previews of image files.
+		 *
+		 * \details Thumbnails are generated in \c ImageLoader pool
+		 * and saved under cache directory, keyed by path and
+		 * modification time, so they survive restarts and are
+		 * rebuilt when file changes. Recently used thumbnails
+		 * are also kept in memory. Queued requests of views
+		 * can be canceled, so scrolled past cells don't delay
+		 * decoding of other images in the shared pool.
+		 *
+		 * \note Methods must be called from GUI thread.
+		 * */
+		class TEVIAN_API ThumbnailCache : public QObject
+		{
+		Q_OBJECT
+		public:
+			//! Longest side of thumbnail
+			static constexpr int Extent = 160;
+			
+			//! Thumbnails kept in memory
+			static constexpr int MemoryCount = 1024;
+			
+			static ThumbnailCache*
+			getThumbnailCache();
+			
+			//! Request shared with its loading task
+			struct Request;
+			
+			/**
+			 * \returns Thumbnail of image or null image if it
+			 * isn't loaded yet. Missing thumbnail is queued and
+			 * \c thumbnailReady is emitted when it's loaded.
+			 *
+			 * \param cancelable Request may be dropped by
+			 * \c cancel, set by views of many images.
+			 * */
+			QImage thumbnail(const QString& path, bool cancelable = false);
+			
+			/**
+			 * \returns Paths of cancelable requests that
+			 * aren't loaded yet.
+			 * */
+			QStringList cancelable() const;
+			
+			/**
+			 * \brief Drops cancelable requests of paths whose
+			 * loading hasn't started, no signal is emitted for
+			 * them. Path requested again is loaded anyway.
+			 * */
+			void cancel(const QStringList& paths);
+			
+			/**
+			 * \returns Path of cached thumbnail file.
+			 * */
+			static QString
+			cacheFile(const QString& directory, const QString& path, const QDateTime& modified);
+		
+		signals:
+			
+			void thumbnailReady(const QString& path);
+		
+		private slots:
+			
+			void insert(const QString& path, const QImage& thumbnail, bool canceled);
+		
+		private:
+			ThumbnailCache();
+			
+			void start(const QString& path, const std::shared_ptr<Request>& request);
+		
+		private:
+			QCache<QString, QImage> m_thumbnails;
+			
+			//! Paths being loaded
+			QHash<QString, std::shared_ptr<Request>> m_pending;
+			
+			//! Paths which aren't readable images
+			QSet<QString> m_failed;
+		};
+		
+		static ThumbnailCache* g_thumbnailCache = ThumbnailCache::getThumbnailCache();
+	}// namespace Gui
+}// namespace Tevian
\ No newline at end of file
@@ -16,22 +16,32 @@ namespace Tevian
 	namespace Gui
 	{
 		ViewPort::ViewPort(QWidget* parent)
-				: QGraphicsView(parent)
+				: QGraphicsView(parent),
+				  m_idleTimer { },
+				  m_interactive { false }
 		{
 			init();
 		}
 		
 		ViewPort::ViewPort(QGraphicsScene* scene, QWidget* parent)
-				: QGraphicsView(scene, parent)
+				: QGraphicsView(scene, parent),
+				  m_idleTimer { },
+				  m_interactive { false }
 		{
 			init();
 		}
 		
 		void ViewPort::scale(qreal v)
 		{
+			interact();
 			QGraphicsView::scale(v, v);
 		}
 		
+		bool ViewPort::isInteractive() const
+		{
+			return m_interactive;
+		}
+		
 		void ViewPort::init()
 		{
 			setAlignment(Qt::AlignCenter);
@@ -41,6 +51,41 @@ namespace Tevian
 			setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
 			setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
 			setContextMenuPolicy(Qt::ContextMenuPolicy::ActionsContextMenu);
+			
+			m_idleTimer.setSingleShot(true);
+			m_idleTimer.setInterval(IdleTimeout);
+			connect(&m_idleTimer, SIGNAL(timeout()), this, SLOT(finishInteraction()));
+		}
+		
+		void ViewPort::interact()
+		{
+			m_idleTimer.start();
+			
+			if (m_interactive)
+			{
+				return;
+			}
+			
+			m_interactive = true;
+			setRenderHint(QPainter::Antialiasing, false);
+			emit interactionChanged(true);
+		}
+		
+		void ViewPort::finishInteraction()
+		{
+			m_interactive = false;
+			setRenderHint(QPainter::Antialiasing, true);
+			emit interactionChanged(false);
+			
+			// Frames painted fast are replaced
+			viewport()->update();
+		}
+		
+		void ViewPort::scrollContentsBy(int dx, int dy)
+		{
+			// Scrollbars and hand drag end up here
+			interact();
+			QGraphicsView::scrollContentsBy(dx, dy);
 		}
 		
 		void ViewPort::wheelEvent(QWheelEvent* event)
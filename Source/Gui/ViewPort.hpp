@@ -9,6 +9,7 @@
 
 #include <memory>
 
+#include <QTimer>
 #include <QGraphicsView>
 
 
@@ -16,22 +17,64 @@ namespace Tevian
 {
 	namespace Gui
 	{
+		/**
+		 * \brief View of image scene.
+		 *
+		 * \details
+		 * While user zooms or drags view is interactive,
+		 * it paints without antialiasing and items may draw
+		 * simplified. Full quality comes back when view is
+		 * idle for \c IdleTimeout.
+		 * */
 		class TEVIAN_API ViewPort : public QGraphicsView
 		{
 		Q_OBJECT
 		public:
+			//! Milliseconds without zoom or drag until
+			//! full quality painting
+			static constexpr int IdleTimeout = 250;
+			
 			ViewPort(QWidget* parent = Q_NULLPTR);
 			
 			ViewPort(QGraphicsScene* scene, QWidget* parent = Q_NULLPTR);
 			
 			void scale(qreal v);
+			
+			bool isInteractive() const;
+		
+		signals:
+			
+			/**
+			 * \brief Emitted when zoom or drag starts and
+			 * when view becomes idle.
+			 * */
+			void interactionChanged(bool interactive);
 		
 		protected:
 			void init();
+			
+			/**
+			 * \brief Enters interactive mode or prolongs it.
+			 * */
+			void interact();
+			
+			void scrollContentsBy(int dx, int dy) Q_DECL_OVERRIDE;
 		
 		protected slots:
 			
 			void wheelEvent(QWheelEvent* event) Q_DECL_OVERRIDE;
+		
+		private slots:
+			
+			/**
+			 * \brief Restores full quality painting.
+			 * */
+			void finishInteraction();
+		
+		private:
+			QTimer m_idleTimer;
+			
+			bool m_interactive;
 		};
 	}// namespace Gui
 }// namespace Tevian
\ No newline at end of file
@@ -1,9 +1,14 @@
 #include "Commons.hpp"
+#include "FaceIndex.hpp"
+#include "ResultsStore.hpp"
+#include "Statistics.hpp"
 #include "Gui/Window.hpp"
 #include "Gui/PreferenceDialog.hpp"
+#include "Gui/StatisticsDialog.hpp"
+#include "Gui/ImageCache.hpp"
+#include "Gui/GalleryModel.hpp"
 
 #include <QStandardPaths>
-#include <QDirIterator>
 #include <QString>
 #include <QImageReader>
 #include <QImageWriter>
@@ -15,6 +20,7 @@
 #include <QStatusBar>
 #include <QToolBar>
 #include <QLabel>
+#include <QLineEdit>
 #include <QPushButton>
 #include <QToolButton>
 #include <QVBoxLayout>
@@ -22,6 +28,10 @@
 #include <QDialog>
 #include <QMessageBox>
 #include <QProgressBar>
+#include <QDockWidget>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThreadPool>
 
 namespace Tevian
 {
@@ -69,36 +79,79 @@ namespace Tevian
 			{
 				dialog.selectMimeTypeFilter("image/jpeg");
 			}
+		
+		}
+		
+		namespace
+		{
+			/**
+			 * \brief Makes stored results of dataset searchable
+			 * and counts them in summary, off GUI thread.
+			 * */
+			class DatasetTask : public QRunnable
+			{
+			public:
+				DatasetTask(const QString& directory, const QString& cachePath)
+						: m_directory { directory },
+						  m_cachePath { cachePath }
+				{ }
+				
+				void run() Q_DECL_OVERRIDE
+				{
+					// Private store, registry of stores belongs
+					// to GUI thread. Records are decoded and files
+					// checked once for index and statistics
+					const ResultsStore store(ResultsStore::datasetFile(m_directory, m_cachePath));
+					const auto images = store.currentImages();
+					
+					for (const auto& image : images)
+					{
+						g_faceIndex->insert(image.path, image.faces, image.facets);
+					}
+					g_statistics->insert(images);
+				}
 			
+			private:
+				QString m_directory;
+				
+				QString m_cachePath;
+			};
 		}
 		
 		Window::Window(bool enable_statusbar)
 				: m_enableStatusbar { enable_statusbar },
 				  m_imgBook(new ImageBook(this)),
 				  m_progressBar(new QProgressBar()),
-				  m_preferenceDialog(new PreferenceDialog(this, "Preferences"))
+				  m_preferenceDialog(new PreferenceDialog(this, "Preferences")),
+				  m_statisticsDialog(new StatisticsDialog(this, "Statistics")),
+				  m_gallery(new Gallery(this)),
+				  m_galleryDock(new QDockWidget(tr("Gallery"), this)),
+				  m_imageUsage(new QLabel(this)),
+				  m_searchEdit(nullptr),
+				  m_exporter(new BatchExporter(this)),
+				  m_scanner(nullptr),
+				  m_datasets { }
 		{
 			setCentralWidget(m_imgBook);
+			m_galleryDock->setWidget(m_gallery);
+			m_galleryDock->hide();
+			addDockWidget(Qt::LeftDockWidgetArea, m_galleryDock);
 			init();
 		}
 		
 		Window::~Window()
 		{
+			ResultsStore::flushAll();
 		}
 		
 		bool Window::load(const QString& file)
 		{
-			
-			if (!QImageReader::imageFormat(file).isEmpty())
+			if (DirectoryScanner::imageFormat(file).isEmpty())
 			{
-				m_imgBook->loadImage(file);
+				return false;
 			}
 			
-			if (m_enableStatusbar)
-			{
-				const QString message = tr("Opened \"%1\"").arg(QDir::toNativeSeparators(file));
-				statusBar()->showMessage(message);
-			}
+			openTab(file);
 			return true;
 		}
 		
@@ -129,30 +182,31 @@ namespace Tevian
 			
 			if (dialog->exec() == QDialog::Accepted)
 			{
-				// Exclude unsupported.
-				size_t filesCount {};
+				// Exclude unsupported, every file is probed once
+				QStringList images { };
 				
-				for (auto& file : dialog->selectedFiles())
+				for (const auto& file : dialog->selectedFiles())
 				{
-					if (!QImageReader::imageFormat(file).isEmpty())
+					if (!DirectoryScanner::imageFormat(file).isEmpty())
 					{
-						++filesCount;
+						images.push_back(file);
 					}
 				}
 				int current { };
 				
 				m_imgBook->hide();
+				m_progressBar->setRange(0, images.size());
 				m_progressBar->show();
 				
-				for (const auto& selectedFile : dialog->selectedFiles())
+				for (const auto& image : images)
 				{
-					load(selectedFile);
-					m_progressBar->setValue((++current) * filesCount);
+					openTab(image);
+					m_progressBar->setValue(++current);
 				}
 				
 				m_imgBook->show();
 				m_progressBar->hide();
-				
+			
 			}
 			delete dialog;
 		}
@@ -184,21 +238,24 @@ namespace Tevian
 			if (dialog->exec() == QFileDialog::Accepted)
 			{
 				
-				dialog->setNameFilter(tr("Image Files (*.png *.jpg *.jpeg *.bmp *webp)"));
-				m_imgBook->hide();
-				m_progressBar->show();
-				QDirIterator diriter(dialog->selectedFiles().first());
-				while (diriter.hasNext())
+				// Images are opened from gallery one by one,
+				// so large directories stay browsable. Tree is
+				// walked in background and gallery grows while
+				// files are found.
+				delete m_scanner;
+				m_scanner = new DirectoryScanner(DirectoryScanner::Options(), this);
+				connect(m_scanner, SIGNAL(available()), this, SLOT(takeScanned()));
+				connect(m_scanner, SIGNAL(finished(int, int)), this, SLOT(scanFinished(int, int)));
+				
+				m_gallery->setFiles(QStringList());
+				m_galleryDock->show();
+				m_scanner->start(dialog->selectedFiles());
+				
+				if (m_enableStatusbar)
 				{
-					auto file = diriter.next();
-					if (!file.isEmpty() && file.at(file.length() - 1) != '.')
-					{
-						load(file);
-					}
+					statusBar()->showMessage(tr("Scanning \"%1\"")
+							                         .arg(QDir::toNativeSeparators(dialog->selectedFiles().first())));
 				}
-				
-				m_imgBook->show();
-				m_progressBar->hide();
 			}
 			
 			delete dialog;
@@ -243,6 +300,28 @@ namespace Tevian
 			toolbar->addWidget(openDirBtn);
 			
 			
+			// Statistics
+			auto statisticsBtn = new QToolButton(this);
+			#ifndef _WIN32
+			statisticsBtn->setIcon(QIcon::fromTheme("x-office-spreadsheet"));
+			#else
+			statisticsBtn->setText("Statistics");
+			#endif
+			statisticsBtn->setToolTip(tr("Statistics"));
+			statisticsBtn->setShortcut(tr("Ctrl+I"));
+			toolbar->addWidget(statisticsBtn);
+			
+			// Export
+			auto exportBtn = new QToolButton(this);
+			#ifndef _WIN32
+			exportBtn->setIcon(QIcon::fromTheme("document-save-as"));
+			#else
+			exportBtn->setText("Export");
+			#endif
+			exportBtn->setToolTip(tr("Export annotated images"));
+			exportBtn->setShortcut(tr("Ctrl+E"));
+			toolbar->addWidget(exportBtn);
+			
 			// Settings
 			auto settingsBtn = new QToolButton(this);
 			#ifndef _WIN32
@@ -276,12 +355,43 @@ namespace Tevian
 			exitBtn->setShortcut(tr("Ctrl+Q"));
 			toolbar->addWidget(exitBtn);
 			
+			// Face search
+			m_searchEdit = new QLineEdit(this);
+			m_searchEdit->setPlaceholderText(tr("Search faces: glasses=yes gender=female age=30..40 score>0.9"));
+			m_searchEdit->setToolTip(tr("Shows images having matching faces, empty query shows all"));
+			m_searchEdit->setClearButtonEnabled(true);
+			m_searchEdit->setMaximumWidth(480);
+			toolbar->addWidget(m_searchEdit);
+			
 			// Connections
 			connect(openBtn, SIGNAL(clicked(bool)), this, SLOT(open()));
 			connect(openDirBtn, SIGNAL(clicked(bool)), this, SLOT(openDirectory()));
+			connect(statisticsBtn, SIGNAL(clicked(bool)), this, SLOT(statistics()));
+			connect(exportBtn, SIGNAL(clicked(bool)), this, SLOT(exportImages()));
+			connect(m_exporter, SIGNAL(progress(int, int, qreal)),
+			        this, SLOT(showExportProgress(int, int, qreal)));
+			connect(m_exporter, SIGNAL(finished(int, int)),
+			        this, SLOT(exportFinished(int, int)));
 			connect(settingsBtn, SIGNAL(clicked(bool)), this, SLOT(prefs()));
 			connect(aboutBtn, SIGNAL(clicked(bool)), this, SLOT(about()));
 			connect(exitBtn, SIGNAL(clicked(bool)), this, SLOT(close()));
+			connect(m_searchEdit, SIGNAL(returnPressed()), this, SLOT(searchFaces()));
+			// Decoded images budget, megabytes in settings
+			const auto budget = g_settingsManager->get(Settings::ImageBudget).toLongLong();
+			if (budget > 0)
+			{
+				g_imageCache->setBudget(budget * 1024 * 1024);
+			}
+			
+			statusBar()->addPermanentWidget(m_imageUsage);
+			showImageUsage(g_imageCache->usage(), g_imageCache->budget());
+			connect(g_imageCache, SIGNAL(usageChanged(qint64, qint64)),
+			        this, SLOT(showImageUsage(qint64, qint64)));
+			
+			connect(m_gallery, SIGNAL(imageActivated(
+					                          const QString&)),
+			        this, SLOT(openImage(
+					                   const QString&)));
 		}
 		
 		void Window::prefs()
@@ -289,6 +399,181 @@ namespace Tevian
 			m_preferenceDialog->show();
 		}
 		
+		void Window::statistics()
+		{
+			m_statisticsDialog->show();
+			m_statisticsDialog->raise();
+		}
+		
+		void Window::openImage(const QString& file)
+		{
+			load(file);
+		}
+		
+		void Window::openTab(const QString& file)
+		{
+			m_imgBook->loadImage(file);
+			
+			if (m_enableStatusbar)
+			{
+				const QString message = tr("Opened \"%1\"").arg(QDir::toNativeSeparators(file));
+				statusBar()->showMessage(message);
+			}
+		}
+		
+		void Window::showImageUsage(qint64 usage, qint64 budget)
+		{
+			m_imageUsage->setText(tr("Images: %1 / %2 MB")
+					                      .arg(usage / (1024 * 1024))
+					                      .arg(budget / (1024 * 1024)));
+		}
+		
+		void Window::exportImages()
+		{
+			if (m_exporter->isRunning())
+			{
+				m_exporter->cancel();
+				return;
+			}
+			
+			const auto files = m_gallery->galleryModel()->files();
+			
+			if (files.isEmpty())
+			{
+				QMessageBox::information(this, tr("Export"),
+				                         tr("Open directory with processed images first"));
+				return;
+			}
+			
+			const auto directory = QFileDialog::getExistingDirectory(this, tr("Export To"),
+			                                                         g_settingsManager->get(Settings::SavePath).toString());
+			if (directory.isEmpty())
+			{
+				return;
+			}
+			g_settingsManager->set(Settings::SavePath, directory);
+			
+			BatchExporter::Options options { };
+			options.directory = directory;
+			
+			const auto format = g_settingsManager->get(Settings::ExportFormat);
+			if (format.isValid())
+			{
+				options.format = format.toByteArray();
+			}
+			
+			const auto quality = g_settingsManager->get(Settings::ExportQuality);
+			if (quality.isValid())
+			{
+				options.quality = quality.toInt();
+			}
+			options.crops = g_settingsManager->get(Settings::ExportCrops).toBool();
+			
+			m_exporter->setOptions(options);
+			
+			if (m_exporter->start(files) > 0)
+			{
+				statusBar()->showMessage(tr("Exporting to \"%1\", press export again to cancel")
+						                         .arg(QDir::toNativeSeparators(directory)));
+			}
+		}
+		
+		void Window::showExportProgress(int done, int total, qreal imagesPerSecond)
+		{
+			statusBar()->showMessage(tr("Exported %1 of %2 images, %3 images/s")
+					                         .arg(done)
+					                         .arg(total)
+					                         .arg(imagesPerSecond, 0, 'f', 1));
+		}
+		
+		void Window::exportFinished(int written, int failed)
+		{
+			if (written + failed == 0)
+			{
+				statusBar()->showMessage(tr("No processed images to export"));
+				return;
+			}
+			statusBar()->showMessage(tr("Export finished: %1 written, %2 failed")
+					                         .arg(written)
+					                         .arg(failed));
+		}
+		
+		void Window::takeScanned()
+		{
+			QVector<DirectoryScanner::Entry> entries { };
+			if (!m_scanner || m_scanner->take(entries) == 0)
+			{
+				return;
+			}
+			
+			QStringList files { };
+			files.reserve(entries.size());
+			
+			for (const auto& entry : entries)
+			{
+				files.push_back(entry.path);
+				
+				// Make results of previous sessions searchable
+				// and count them in dataset summary
+				const auto directory = QFileInfo(entry.path).absolutePath();
+				if (!m_datasets.contains(directory))
+				{
+					m_datasets.insert(directory);
+					QThreadPool::globalInstance()->start(new DatasetTask(directory, g_settingsManager->cachePath()));
+				}
+			}
+			
+			// Batches come in order of walking threads
+			files.sort();
+			m_gallery->galleryModel()->addFiles(files);
+			
+			// Queue isn't empty yet, so no signal comes
+			if (entries.size() == DirectoryScanner::DefaultCapacity)
+			{
+				QMetaObject::invokeMethod(this, "takeScanned", Qt::QueuedConnection);
+			}
+		}
+		
+		void Window::scanFinished(int found, int skipped)
+		{
+			Q_UNUSED(skipped)
+			
+			takeScanned();
+			if (m_enableStatusbar)
+			{
+				statusBar()->showMessage(tr("Found %1 images").arg(found));
+			}
+		}
+		
+		void Window::searchFaces()
+		{
+			const auto text = m_searchEdit->text().trimmed();
+			if (text.isEmpty())
+			{
+				m_gallery->clearFilter();
+				return;
+			}
+			
+			FaceQuery query;
+			QString error;
+			if (!FaceQuery::parse(text, query, &error))
+			{
+				statusBar()->showMessage(error);
+				return;
+			}
+			
+			QSet<QString> images { };
+			const auto hits = g_faceIndex->hits(g_faceIndex->query(query));
+			for (const auto& hit : hits)
+			{
+				images.insert(hit.image);
+			}
+			
+			m_gallery->setFilter(images);
+			m_galleryDock->show();
+			statusBar()->showMessage(tr("%1 faces in %2 images").arg(hits.size()).arg(images.size()));
+		}
+		
 		void Window::about()
 		{
 			QMessageBox::about(this, tr("About Face Detector"),
@@ -9,14 +9,25 @@
 
 #include "Gui/ImageBook.hpp"
 #include "PreferenceDialog.hpp"
+#include "StatisticsDialog.hpp"
+#include "Gui/Gallery.hpp"
+#include "Gui/BatchExporter.hpp"
+#include "DirectoryScanner.hpp"
 
 #include <QMainWindow>
 #include <QMap>
+#include <QSet>
 #include <QProgressBar>
 
 
 class QAction;
 
+class QDockWidget;
+
+class QLabel;
+
+class QLineEdit;
+
 namespace Tevian
 {
 	namespace Gui
@@ -30,6 +41,11 @@ namespace Tevian
 			
 			~Window() Q_DECL_OVERRIDE;
 			
+			/**
+			 * \brief Opens tab of image.
+			 *
+			 * \returns false if file isn't readable image.
+			 * */
 			bool load(const QString& file);
 		
 		private slots:
@@ -40,7 +56,43 @@ namespace Tevian
 			
 			void prefs();
 			
+			void statistics();
+			
 			void about();
+			
+			/**
+			 * \brief Opens image chosen in gallery.
+			 * */
+			void openImage(const QString& file);
+			
+			/**
+			 * \brief Shows decoded images memory in status bar.
+			 * */
+			void showImageUsage(qint64 usage, qint64 budget);
+			
+			/**
+			 * \brief Exports gallery images having results
+			 * into chosen directory.
+			 * */
+			void exportImages();
+			
+			void showExportProgress(int done, int total, qreal imagesPerSecond);
+			
+			void exportFinished(int written, int failed);
+			
+			/**
+			 * \brief Moves files found by directory scan
+			 * into gallery.
+			 * */
+			void takeScanned();
+			
+			void scanFinished(int found, int skipped);
+			
+			/**
+			 * \brief Shows in gallery only images having
+			 * faces matching query of search entry.
+			 * */
+			void searchFaces();
 		
 		signals:
 			
@@ -48,6 +100,12 @@ namespace Tevian
 		
 		private:
 			void init();
+			
+			/**
+			 * \brief Opens tab of image which format
+			 * is already checked.
+			 * */
+			void openTab(const QString& file);
 		
 		private:
 			bool m_enableStatusbar;
@@ -57,6 +115,26 @@ namespace Tevian
 			QProgressBar* m_progressBar;
 			
 			PreferenceDialog* m_preferenceDialog;
+			
+			StatisticsDialog* m_statisticsDialog;
+			
+			//! Thumbnails of opened directory
+			Gallery* m_gallery;
+			
+			QDockWidget* m_galleryDock;
+			
+			QLabel* m_imageUsage;
+			
+			//! Face query, \see FaceQuery::parse
+			QLineEdit* m_searchEdit;
+			
+			BatchExporter* m_exporter;
+			
+			//! Walks opened directory, recreated for every one
+			DirectoryScanner* m_scanner;
+			
+			//! Directories with results loaded into index
+			QSet<QString> m_datasets;
 		};
 	}// namespace Gui
 }// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,96 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "HashTree.hpp"
+#include "PerceptualHash.hpp"
+
+#include <cstdlib>
+#include <algorithm>
+
+
+namespace Tevian
+{
+	HashTree::HashTree()
+			: m_nodes { }
+	{ }
+	
+	void HashTree::insert(quint64 hash, int id)
+	{
+		const int index = m_nodes.size();
+		m_nodes.push_back({ hash, id, { }});
+		
+		if (index == 0)
+		{
+			return;
+		}
+		
+		int node = 0;
+		while (true)
+		{
+			const int distance = PerceptualHash::distance(hash, m_nodes.at(node).hash);
+			auto& children = m_nodes[node].children;
+			
+			const auto child = std::find_if(children.cbegin(), children.cend(),
+			                                [distance](const QPair<int, int>& edge)
+			                                {
+				                                return edge.first == distance;
+			                                });
+			
+			if (child == children.cend())
+			{
+				children.push_back({ distance, index });
+				return;
+			}
+			node = child->second;
+		}
+	}
+	
+	QVector<HashTree::Match>
+	HashTree::find(quint64 hash, int radius) const
+	{
+		QVector<Match> matches { };
+		
+		if (m_nodes.isEmpty())
+		{
+			return matches;
+		}
+		
+		QVector<int> stack { 0 };
+		while (!stack.isEmpty())
+		{
+			const auto& node = m_nodes.at(stack.takeLast());
+			const int distance = PerceptualHash::distance(hash, node.hash);
+			
+			if (distance <= radius)
+			{
+				matches.push_back({ node.id, distance });
+			}
+			
+			for (const auto& child : node.children)
+			{
+				if (std::abs(child.first - distance) <= radius)
+				{
+					stack.push_back(child.second);
+				}
+			}
+		}
+		
+		std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b)
+		{
+			return a.distance < b.distance;
+		});
+		return matches;
+	}
+	
+	int HashTree::size() const
+	{
+		return m_nodes.size();
+	}
+	
+	void HashTree::clear()
+	{
+		m_nodes.clear();
+	}
+}// namespace Tevian
\ No newline at end of file
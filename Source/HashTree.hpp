@@ -0,0 +1,65 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QPair>
+#include <QVector>
+
+
+namespace Tevian
+{
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief BK-tree of 64-bit hashes by Hamming distance.
+	 *
+	 * \details Child of node is keyed by its distance to node,
+	 * so search within radius visits only children whose key
+	 * differs from query's distance by at most radius (triangle
+	 * inequality). Small radius visits small part of tree.
+	 * Nodes live in one vector and are never removed.
+	 * */
+	class TEVIAN_API HashTree
+	{
+	public:
+		struct Match
+		{
+			int id;
+			
+			int distance;
+		};
+		
+		HashTree();
+		
+		void insert(quint64 hash, int id);
+		
+		/**
+		 * \returns Hashes within \c radius, nearest first.
+		 * */
+		QVector<Match> find(quint64 hash, int radius) const;
+		
+		int size() const;
+		
+		void clear();
+	
+	private:
+		struct Node
+		{
+			quint64 hash;
+			
+			int id;
+			
+			//! Distance to child and its node index
+			QVector<QPair<int, int>> children;
+		};
+	
+	private:
+		QVector<Node> m_nodes;
+	};
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,164 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "PerceptualHash.hpp"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QtMath>
+#include <QtAlgorithms>
+
+
+namespace Tevian
+{
+	namespace
+	{
+		//! Side of thumbnail transformed by \c pHash
+		const int TransformSize = 32;
+		
+		//! Low frequencies taken along one axis
+		const int HashSize = 8;
+		
+		/**
+		 * \returns Grayscale thumbnail of given size, smooth
+		 * scaling works on 32-bit images only.
+		 * */
+		QImage thumbnail(const QImage& image, int width, int height)
+		{
+			return image.convertToFormat(QImage::Format_RGB32)
+			            .scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+			            .convertToFormat(QImage::Format_Grayscale8);
+		}
+	}
+	
+	quint64
+	PerceptualHash::hashFile(const QString& file, Method method, QSize* size)
+	{
+		QImageReader reader(file);
+		reader.setAutoTransform(true);
+		
+		auto original = reader.size();
+		if (original.isValid())
+		{
+			// Decoders like jpeg's scale while decoding,
+			// thumbnail is squeezed anyway
+			if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+			{
+				original.transpose();
+			}
+			reader.setScaledSize(QSize(DecodeSize, DecodeSize));
+		}
+		
+		const auto image = reader.read();
+		if (image.isNull())
+		{
+			if (size)
+			{
+				*size = QSize();
+			}
+			return 0;
+		}
+		
+		if (size)
+		{
+			*size = original.isValid() ? original : image.size();
+		}
+		return hash(image, method);
+	}
+	
+	quint64
+	PerceptualHash::hash(const QImage& image, Method method)
+	{
+		return method == DHash ? dHash(image) : pHash(image);
+	}
+	
+	quint64
+	PerceptualHash::dHash(const QImage& image)
+	{
+		const auto small = thumbnail(image, HashSize + 1, HashSize);
+		quint64 bits = 0;
+		
+		for (int y = 0; y < HashSize; ++y)
+		{
+			const uchar* line = small.constScanLine(y);
+			for (int x = 0; x < HashSize; ++x)
+			{
+				bits = (bits << 1) | (line[x] > line[x + 1] ? 1 : 0);
+			}
+		}
+		return bits;
+	}
+	
+	quint64
+	PerceptualHash::pHash(const QImage& image)
+	{
+		const auto small = thumbnail(image, TransformSize, TransformSize);
+		
+		// Cosine basis of low frequencies only, transform
+		// is separable: rows first, then columns
+		static const auto basis = []()
+		{
+			std::vector<double> values(HashSize * TransformSize);
+			for (int u = 0; u < HashSize; ++u)
+			{
+				for (int x = 0; x < TransformSize; ++x)
+				{
+					values[u * TransformSize + x] = std::cos((2 * x + 1) * u * M_PI / (2 * TransformSize));
+				}
+			}
+			return values;
+		}();
+		
+		double rows[TransformSize][HashSize];
+		for (int y = 0; y < TransformSize; ++y)
+		{
+			const uchar* line = small.constScanLine(y);
+			for (int u = 0; u < HashSize; ++u)
+			{
+				double sum = 0;
+				for (int x = 0; x < TransformSize; ++x)
+				{
+					sum += line[x] * basis[u * TransformSize + x];
+				}
+				rows[y][u] = sum;
+			}
+		}
+		
+		double coefficients[HashSize * HashSize];
+		for (int v = 0; v < HashSize; ++v)
+		{
+			for (int u = 0; u < HashSize; ++u)
+			{
+				double sum = 0;
+				for (int y = 0; y < TransformSize; ++y)
+				{
+					sum += rows[y][u] * basis[v * TransformSize + y];
+				}
+				coefficients[v * HashSize + u] = sum;
+			}
+		}
+		
+		// Mean brightness term would dominate median
+		std::vector<double> sorted(coefficients + 1, coefficients + HashSize * HashSize);
+		std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+		const auto median = sorted[sorted.size() / 2];
+		
+		quint64 bits = 0;
+		for (const auto coefficient : coefficients)
+		{
+			bits = (bits << 1) | (coefficient > median ? 1 : 0);
+		}
+		return bits;
+	}
+	
+	int PerceptualHash::distance(quint64 first, quint64 second)
+	{
+		return int(qPopulationCount(first ^ second));
+	}
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,63 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QSize>
+#include <QImage>
+#include <QString>
+
+
+namespace Tevian
+{
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief 64-bit perceptual hashes of images.
+	 *
+	 * \details Hashes are computed from grayscale thumbnail
+	 * squeezed to square, so re-saved, recompressed and resized
+	 * copies of image get hashes differing in few bits. \c DHash
+	 * compares neighbour pixels of 9x8 thumbnail, \c PHash takes
+	 * signs of low frequencies of 32x32 thumbnail's cosine
+	 * transform and is more robust to contrast and blur.
+	 * */
+	class TEVIAN_API PerceptualHash
+	{
+	public:
+		enum Method
+		{
+			DHash,
+			PHash
+		};
+		
+		//! Side of thumbnail file is decoded to
+		static constexpr int DecodeSize = 64;
+		
+		/**
+		 * \brief Decodes file at thumbnail size and hashes it.
+		 *
+		 * \param size Set to image size after orientation
+		 * is applied, invalid if file can't be read.
+		 * */
+		static quint64
+		hashFile(const QString& file, Method method, QSize* size = nullptr);
+		
+		static quint64
+		hash(const QImage& image, Method method);
+		
+		static quint64
+		dHash(const QImage& image);
+		
+		static quint64
+		pHash(const QImage& image);
+		
+		//! Count of differing bits
+		static int distance(quint64 first, quint64 second);
+	};
+}// namespace Tevian
\ No newline at end of file
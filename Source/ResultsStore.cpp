@@ -0,0 +1,625 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "ResultsStore.hpp"
+#include "Settings.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+
+#include <QDir>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+
+
+namespace Tevian
+{
+	using namespace Details;
+	
+	namespace
+	{
+		const char StoreMagic[8] = { 'T', 'V', 'R', 'S', 'L', 'T', '\0', '\0' };
+		
+		const quint32 StoreVersion = 2;
+		
+		//! Steps of coordinate on either side of zero
+		const qreal QuantumSteps = std::numeric_limits<qint16>::max();
+		
+		const int MaxFaceSize = std::numeric_limits<quint16>::max();
+		
+		static_assert(sizeof(StoreHeader) == 80, "Unexpected StoreHeader layout");
+		static_assert(sizeof(StoreImage) == 48, "Unexpected StoreImage layout");
+		static_assert(sizeof(StoreFace) == 40, "Unexpected StoreFace layout");
+		
+		std::map<QString, std::unique_ptr<ResultsStore>> g_stores;
+		
+		QString normalizePath(const QString& path)
+		{
+			return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+		}
+		
+		qint16 quantize(qreal value, qreal quantum)
+		{
+			return qint16(qBound(-int(QuantumSteps), qRound(value / quantum), int(QuantumSteps)));
+		}
+		
+		quint64 align(quint64 offset)
+		{
+			return (offset + 7) & ~quint64(7);
+		}
+		
+		/**
+		 * \returns true if section of \c count items of \c T
+		 * fits into mapped data.
+		 * */
+		template<typename T>
+		bool fits(quint64 offset, quint32 count, qint64 size)
+		{
+			return offset <= quint64(size)
+			       && quint64(count) * sizeof(T) <= quint64(size) - offset;
+		}
+	}
+	
+	ResultsStore::ResultsStore(const QString& file)
+			: m_fileName { file },
+			  m_data { nullptr },
+			  m_header { nullptr },
+			  m_codes { },
+			  m_pending { }
+	{
+		map();
+	}
+	
+	ResultsStore::~ResultsStore()
+	{
+		unmap();
+	}
+	
+	ResultsStore*
+	ResultsStore::forDataset(const QString& directory)
+	{
+		auto& store = g_stores[normalizePath(directory)];
+		
+		if (!store)
+		{
+			store = std::unique_ptr<ResultsStore>(new ResultsStore(datasetFile(directory)));
+		}
+		return store.get();
+	}
+	
+	ResultsStore*
+	ResultsStore::forImage(const QString& image)
+	{
+		return forDataset(QFileInfo(image).absolutePath());
+	}
+	
+	void ResultsStore::flushAll()
+	{
+		for (auto& store : g_stores)
+		{
+			store.second->save();
+		}
+	}
+	
+	QString
+	ResultsStore::datasetFile(const QString& directory)
+	{
+		return datasetFile(directory, g_settingsManager->cachePath());
+	}
+	
+	QString
+	ResultsStore::datasetFile(const QString& directory, const QString& cachePath)
+	{
+		auto name = QString::number(pathHash(normalizePath(directory)), 16);
+		return QDir(cachePath).filePath(QString("results/%1.tvr").arg(name));
+	}
+	
+	quint64
+	ResultsStore::pathHash(const QString& path)
+	{
+		// FNV-1a, stable between runs unlike seeded qHash
+		quint64 hash = 14695981039346656037ULL;
+		
+		for (const auto& c : path)
+		{
+			hash ^= c.unicode();
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	
+	bool ResultsStore::isCurrent(const Image& image)
+	{
+		QFileInfo info(image.path);
+		
+		return info.exists()
+		       && info.size() == image.size
+		       && info.lastModified().toMSecsSinceEpoch() == image.modified;
+	}
+	
+	bool ResultsStore::isMapped() const
+	{
+		return m_header != nullptr;
+	}
+	
+	int ResultsStore::size() const
+	{
+		int count = m_pending.size();
+		
+		if (m_header)
+		{
+			auto records = section<StoreImage>(m_header->imagesOffset);
+			for (quint32 i = 0; i < m_header->imageCount; ++i)
+			{
+				if (!m_pending.contains(string(records[i].pathString)))
+				{
+					++count;
+				}
+			}
+		}
+		return count;
+	}
+	
+	QStringList ResultsStore::paths() const
+	{
+		QStringList paths = m_pending.keys();
+		
+		if (m_header)
+		{
+			auto records = section<StoreImage>(m_header->imagesOffset);
+			for (quint32 i = 0; i < m_header->imageCount; ++i)
+			{
+				auto path = string(records[i].pathString);
+				if (!m_pending.contains(path))
+				{
+					paths.push_back(path);
+				}
+			}
+		}
+		return paths;
+	}
+	
+	bool ResultsStore::contains(const QString& image) const
+	{
+		auto path = normalizePath(image);
+		return m_pending.contains(path) || lookup(path);
+	}
+	
+	QVector<ResultsStore::Image> ResultsStore::currentImages() const
+	{
+		QVector<Image> images { };
+		
+		for (const auto& path : paths())
+		{
+			Image image;
+			
+			if (find(path, image) && isCurrent(image))
+			{
+				images.push_back(image);
+			}
+		}
+		return images;
+	}
+	
+	bool ResultsStore::find(const QString& image, Image& result) const
+	{
+		auto path = normalizePath(image);
+		auto pending = m_pending.constFind(path);
+		
+		if (pending != m_pending.constEnd())
+		{
+			result = pending.value();
+			return true;
+		}
+		
+		if (auto record = lookup(path))
+		{
+			decode(*record, result);
+			return true;
+		}
+		return false;
+	}
+	
+	bool ResultsStore::isProcessed(const QString& image, qint64 modified, qint64 size) const
+	{
+		auto path = normalizePath(image);
+		auto pending = m_pending.constFind(path);
+		
+		if (pending != m_pending.constEnd())
+		{
+			return pending->modified == modified && pending->size == size;
+		}
+		
+		auto record = lookup(path);
+		return record && record->modified == modified && record->size == size;
+	}
+	
+	void ResultsStore::insert(const Image& image)
+	{
+		auto path = normalizePath(image.path);
+		auto& pending = m_pending[path];
+		pending = image;
+		pending.path = path;
+	}
+	
+	bool ResultsStore::save()
+	{
+		if (m_pending.isEmpty())
+		{
+			return true;
+		}
+		
+		QVector<Image> images { };
+		
+		if (m_header)
+		{
+			auto records = section<StoreImage>(m_header->imagesOffset);
+			images.reserve(int(m_header->imageCount) + m_pending.size());
+			
+			for (quint32 i = 0; i < m_header->imageCount; ++i)
+			{
+				Image image;
+				decode(records[i], image);
+				if (!m_pending.contains(image.path))
+				{
+					images.push_back(image);
+				}
+			}
+		}
+		
+		for (const auto& image : m_pending)
+		{
+			images.push_back(image);
+		}
+		
+		QVector<QPair<quint64, int>> order { };
+		order.reserve(images.size());
+		
+		for (int i = 0; i < images.size(); ++i)
+		{
+			order.push_back({ pathHash(images.at(i).path), i });
+		}
+		std::sort(order.begin(), order.end());
+		
+		QVector<StoreImage> imageTable { };
+		QVector<StoreFace> faceTable { };
+		QVector<StorePoint> pointTable { };
+		QVector<StoreAttribute> attributeTable { };
+		QVector<StoreString> stringIndex { };
+		QByteArray stringData { };
+		QHash<QString, quint32> strings { };
+		QHash<StringCode, quint32> codes { };
+		
+		auto intern = [ & ](const QString& value) -> quint32
+		{
+			auto found = strings.constFind(value);
+			if (found != strings.constEnd())
+			{
+				return found.value();
+			}
+			
+			auto utf8 = value.toUtf8();
+			stringIndex.push_back({ quint32(stringData.size()), quint32(utf8.size()) });
+			stringData.append(utf8);
+			
+			auto index = quint32(stringIndex.size() - 1);
+			strings.insert(value, index);
+			return index;
+		};
+		
+		// Interned strings are hashed once per file
+		auto internCode = [ & ](StringCode code) -> quint32
+		{
+			auto found = codes.constFind(code);
+			if (found != codes.constEnd())
+			{
+				return found.value();
+			}
+			
+			auto index = intern(g_stringTable->string(code));
+			codes.insert(code, index);
+			return index;
+		};
+		
+		for (const auto& entry : order)
+		{
+			const auto& image = images.at(entry.second);
+			StoreImage record { };
+			
+			// Largest absolute coordinate defines quantization
+			// step of image
+			qreal extent = 1.0;
+			for (const auto& face : image.faces)
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					extent = qMax(extent, qreal(qAbs(face.bounds[i])));
+				}
+				for (const auto& point : face.landmarks)
+				{
+					extent = qMax(extent, qMax(qAbs(point.x()), qAbs(point.y())));
+				}
+			}
+			
+			record.pathHash = entry.first;
+			record.modified = image.modified;
+			record.size = image.size;
+			record.pathString = intern(image.path);
+			record.firstFace = quint32(faceTable.size());
+			record.quantum = float(extent / QuantumSteps);
+			record.threshold = image.threshold;
+			record.minSize = quint16(qBound(0, image.minSize, MaxFaceSize));
+			record.maxSize = quint16(qBound(0, image.maxSize, MaxFaceSize));
+			record.faceCount = quint16(image.faces.size());
+			record.facets = image.facets;
+			
+			for (const auto& face : image.faces)
+			{
+				StoreFace faceRecord { };
+				
+				for (int i = 0; i < 4; ++i)
+				{
+					faceRecord.bbox[i] = quantize(face.bounds[i], record.quantum);
+				}
+				
+				faceRecord.firstPoint = quint32(pointTable.size());
+				faceRecord.pointCount = quint16(face.landmarks.size());
+				for (const auto& point : face.landmarks)
+				{
+					pointTable.push_back({ quantize(point.x(), record.quantum),
+					                       quantize(point.y(), record.quantum) });
+				}
+				
+				faceRecord.firstAttribute = quint32(attributeTable.size());
+				faceRecord.attributeCount = quint16(face.attributes.size());
+				for (const auto& attribute : face.attributes)
+				{
+					attributeTable.push_back({ internCode(attribute.key), internCode(attribute.value) });
+				}
+				
+				faceRecord.score = face.score;
+				faceRecord.ageMean = float(face.demographics._age._mean);
+				faceRecord.ageVariance = float(face.demographics._age._variance);
+				faceRecord.gender = internCode(face.demographics._gender);
+				faceRecord.ethnicity = internCode(face.demographics._ethnicity);
+				faceTable.push_back(faceRecord);
+			}
+			imageTable.push_back(record);
+		}
+		
+		StoreHeader header { };
+		std::memcpy(header.magic, StoreMagic, sizeof(StoreMagic));
+		header.version = StoreVersion;
+		header.imageCount = quint32(imageTable.size());
+		header.faceCount = quint32(faceTable.size());
+		header.pointCount = quint32(pointTable.size());
+		header.attributeCount = quint32(attributeTable.size());
+		header.stringCount = quint32(stringIndex.size());
+		header.imagesOffset = align(sizeof(StoreHeader));
+		header.facesOffset = align(header.imagesOffset + imageTable.size() * sizeof(StoreImage));
+		header.pointsOffset = align(header.facesOffset + faceTable.size() * sizeof(StoreFace));
+		header.attributesOffset = align(header.pointsOffset + pointTable.size() * sizeof(StorePoint));
+		header.stringIndexOffset = align(header.attributesOffset
+		                                 + attributeTable.size() * sizeof(StoreAttribute));
+		header.stringDataOffset = align(header.stringIndexOffset + stringIndex.size() * sizeof(StoreString));
+		
+		QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+		QSaveFile out(m_fileName);
+		
+		if (!out.open(QFile::WriteOnly))
+		{
+			qWarning() << (__FUNCTION__) << "Can not write" << m_fileName;
+			return false;
+		}
+		
+		auto write = [ &out ](quint64 offset, const void* data, qint64 size)
+		{
+			static const char padding[8] = { };
+			out.write(padding, qint64(offset) - out.pos());
+			out.write(reinterpret_cast<const char*>(data), size);
+		};
+		
+		write(0, &header, sizeof(header));
+		write(header.imagesOffset, imageTable.constData(), imageTable.size() * sizeof(StoreImage));
+		write(header.facesOffset, faceTable.constData(), faceTable.size() * sizeof(StoreFace));
+		write(header.pointsOffset, pointTable.constData(), pointTable.size() * sizeof(StorePoint));
+		write(header.attributesOffset, attributeTable.constData(),
+		      attributeTable.size() * sizeof(StoreAttribute));
+		write(header.stringIndexOffset, stringIndex.constData(), stringIndex.size() * sizeof(StoreString));
+		write(header.stringDataOffset, stringData.constData(), stringData.size());
+		
+		// Mapped file must be released before replacing it
+		unmap();
+		
+		if (!out.commit())
+		{
+			qWarning() << (__FUNCTION__) << "Can not write" << m_fileName;
+			map();
+			return false;
+		}
+		
+		m_pending.clear();
+		return map();
+	}
+	
+	bool ResultsStore::map()
+	{
+		unmap();
+		m_file.setFileName(m_fileName);
+		
+		if (!m_file.exists() || !m_file.open(QFile::ReadOnly))
+		{
+			return false;
+		}
+		
+		const auto size = m_file.size();
+		
+		if (size >= qint64(sizeof(StoreHeader)))
+		{
+			m_data = m_file.map(0, size);
+		}
+		
+		if (!m_data)
+		{
+			m_file.close();
+			return false;
+		}
+		
+		auto header = reinterpret_cast<const StoreHeader*>(m_data);
+		
+		bool valid = std::memcmp(header->magic, StoreMagic, sizeof(StoreMagic)) == 0
+		             && header->version == StoreVersion
+		             && fits<StoreImage>(header->imagesOffset, header->imageCount, size)
+		             && fits<StoreFace>(header->facesOffset, header->faceCount, size)
+		             && fits<StorePoint>(header->pointsOffset, header->pointCount, size)
+		             && fits<StoreAttribute>(header->attributesOffset, header->attributeCount, size)
+		             && fits<StoreString>(header->stringIndexOffset, header->stringCount, size)
+		             && header->stringDataOffset <= quint64(size);
+		
+		if (!valid)
+		{
+			qWarning() << (__FUNCTION__) << "Ignoring invalid results file" << m_fileName;
+			unmap();
+			return false;
+		}
+		
+		m_header = header;
+		return true;
+	}
+	
+	void ResultsStore::unmap()
+	{
+		if (m_data)
+		{
+			m_file.unmap(const_cast<uchar*>(m_data));
+		}
+		
+		m_file.close();
+		m_data = nullptr;
+		m_header = nullptr;
+		m_codes.clear();
+	}
+	
+	const StoreImage*
+	ResultsStore::lookup(const QString& path) const
+	{
+		if (!m_header)
+		{
+			return nullptr;
+		}
+		
+		const auto hash = pathHash(path);
+		auto first = section<StoreImage>(m_header->imagesOffset);
+		auto last = first + m_header->imageCount;
+		
+		auto record = std::lower_bound(first, last, hash,
+		                               [ ](const StoreImage& image, quint64 value)
+		                               {
+			                               return image.pathHash < value;
+		                               });
+		
+		for (; record != last && record->pathHash == hash; ++record)
+		{
+			if (string(record->pathString) == path)
+			{
+				return record;
+			}
+		}
+		return nullptr;
+	}
+	
+	void ResultsStore::decode(const StoreImage& record, Image& result) const
+	{
+		const auto faces = section<StoreFace>(m_header->facesOffset);
+		const auto points = section<StorePoint>(m_header->pointsOffset);
+		const auto attributes = section<StoreAttribute>(m_header->attributesOffset);
+		const qreal quantum = record.quantum;
+		
+		result.path = string(record.pathString);
+		result.modified = record.modified;
+		result.size = record.size;
+		result.facets = record.facets;
+		result.threshold = record.threshold;
+		result.minSize = record.minSize;
+		result.maxSize = record.maxSize;
+		result.faces.clear();
+		result.faces.reserve(record.faceCount);
+		
+		for (quint32 i = record.firstFace;
+		     i < record.firstFace + record.faceCount && i < m_header->faceCount; ++i)
+		{
+			const auto& faceRecord = faces[i];
+			Face face;
+			
+			for (int j = 0; j < 4; ++j)
+			{
+				face.bounds[j] = qRound(faceRecord.bbox[j] * quantum);
+			}
+			
+			face.landmarks.reserve(faceRecord.pointCount);
+			for (quint32 j = faceRecord.firstPoint;
+			     j < faceRecord.firstPoint + faceRecord.pointCount && j < m_header->pointCount; ++j)
+			{
+				face.landmarks.push_back(QPointF(points[j].x * quantum, points[j].y * quantum));
+			}
+			
+			for (quint32 j = faceRecord.firstAttribute;
+			     j < faceRecord.firstAttribute + faceRecord.attributeCount
+			     && j < m_header->attributeCount; ++j)
+			{
+				face.attributes.set(code(attributes[j].key), code(attributes[j].value));
+			}
+			
+			face.score = faceRecord.score;
+			face.demographics._age._mean = faceRecord.ageMean;
+			face.demographics._age._variance = faceRecord.ageVariance;
+			face.demographics._gender = code(faceRecord.gender);
+			face.demographics._ethnicity = code(faceRecord.ethnicity);
+			result.faces.push_back(face);
+		}
+	}
+	
+	QString ResultsStore::string(quint32 index) const
+	{
+		if (!m_header || index >= m_header->stringCount)
+		{
+			return QString();
+		}
+		
+		const auto& entry = section<StoreString>(m_header->stringIndexOffset)[index];
+		const auto end = m_header->stringDataOffset + entry.offset + entry.length;
+		
+		if (end > quint64(m_file.size()))
+		{
+			return QString();
+		}
+		return QString::fromUtf8(reinterpret_cast<const char*>(m_data + m_header->stringDataOffset + entry.offset),
+		                         int(entry.length));
+	}
+	
+	StringCode ResultsStore::code(quint32 index) const
+	{
+		if (!m_header || index >= m_header->stringCount)
+		{
+			return StringTable::Empty;
+		}
+		
+		// File strings are interned on first use only
+		if (m_codes.isEmpty())
+		{
+			m_codes.fill(StringTable::NoCode, int(m_header->stringCount));
+		}
+		
+		if (m_codes.at(int(index)) == StringTable::NoCode)
+		{
+			m_codes[int(index)] = g_stringTable->intern(string(index));
+		}
+		return m_codes.at(int(index));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,324 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "Commons.hpp"
+#include "FaceData.hpp"
+#include "FaceDetector.hpp"
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPointF>
+
+
+namespace Tevian
+{
+	namespace Details
+	{
+		/// Binary layout of results file.
+		/// Sections follow the header in the order of
+		/// its offsets, each one aligned to 8 bytes.
+		
+		struct StoreHeader
+		{
+			char magic[8];
+			
+			quint32 version;
+			
+			quint32 imageCount;
+			
+			quint32 faceCount;
+			
+			quint32 pointCount;
+			
+			quint32 attributeCount;
+			
+			quint32 stringCount;
+			
+			quint64 imagesOffset;
+			
+			quint64 facesOffset;
+			
+			quint64 pointsOffset;
+			
+			quint64 attributesOffset;
+			
+			quint64 stringIndexOffset;
+			
+			quint64 stringDataOffset;
+		};
+		
+		/**
+		 * \brief Per-image record. Records are sorted by
+		 * \c pathHash to allow binary search on mapped file.
+		 * */
+		struct StoreImage
+		{
+			quint64 pathHash;
+			
+			qint64 modified;
+			
+			qint64 size;
+			
+			quint32 pathString;
+			
+			quint32 firstFace;
+			
+			//! Size of one quantization step in pixels
+			float quantum;
+			
+			float threshold;
+			
+			quint16 minSize;
+			
+			quint16 maxSize;
+			
+			quint16 faceCount;
+			
+			quint16 facets;
+		};
+		
+		struct StoreFace
+		{
+			//! Quantized x, y, width, height, signed as
+			//! boxes of faces on image edge start outside
+			qint16 bbox[4];
+			
+			quint32 firstPoint;
+			
+			quint32 firstAttribute;
+			
+			float score;
+			
+			float ageMean;
+			
+			float ageVariance;
+			
+			quint32 gender;
+			
+			quint32 ethnicity;
+			
+			quint16 pointCount;
+			
+			quint16 attributeCount;
+		};
+		
+		struct StorePoint
+		{
+			qint16 x;
+			
+			qint16 y;
+		};
+		
+		struct StoreAttribute
+		{
+			quint32 key;
+			
+			quint32 value;
+		};
+		
+		struct StoreString
+		{
+			quint32 offset;
+			
+			quint32 length;
+		};
+	}
+	
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Binary storage of detection results of a dataset.
+	 *
+	 * \details Results of all processed images of one directory
+	 * are kept in one file under cache path. The file is memory-mapped
+	 * on open and image records are found by binary search over
+	 * hash-sorted table, thus showing stored results needs neither
+	 * json parsing nor backend request.
+	 * Coordinates are quantized to signed 16 bits with per-image
+	 * step, so negative offsets of boxes on image edge are kept,
+	 * strings (paths, attribute keys and values) are interned in
+	 * the file's string table and mapped to \c StringTable codes
+	 * on read.
+	 *
+	 * \note New results are held in memory until \c save() called.
+	 * */
+	class TEVIAN_API ResultsStore
+	{
+	public:
+		struct Image
+		{
+			QString path;
+			
+			qint64 modified = 0;
+			
+			qint64 size = 0;
+			
+			Facets facets = NoFacets;
+			
+			float threshold = 0.0;
+			
+			int minSize = 0;
+			
+			int maxSize = 0;
+			
+			QVector<Details::Face> faces;
+		};
+	
+	public:
+		/**
+		 * \param file Path to results file. If file doesn't
+		 * exist it will be created on first \c save().
+		 * */
+		explicit ResultsStore(const QString& file);
+		
+		~ResultsStore();
+		
+		/**
+		 * \returns Store of given dataset directory.
+		 * Stores are created once and live until exit.
+		 * */
+		static ResultsStore*
+		forDataset(const QString& directory);
+		
+		/**
+		 * \returns Store of directory containing image.
+		 * */
+		static ResultsStore*
+		forImage(const QString& image);
+		
+		/**
+		 * \brief Saves all opened stores.
+		 * */
+		static void flushAll();
+		
+		/**
+		 * \returns Path of results file for dataset directory.
+		 * */
+		static QString
+		datasetFile(const QString& directory);
+		
+		/**
+		 * \brief Doesn't touch settings, may be called
+		 * from any thread.
+		 * */
+		static QString
+		datasetFile(const QString& directory, const QString& cachePath);
+		
+		/**
+		 * \returns Stable hash of image path, used as
+		 * lookup key in the file.
+		 * */
+		static quint64
+		pathHash(const QString& path);
+		
+		/**
+		 * \returns true if file modification time and size
+		 * are the same as stored ones.
+		 * */
+		static bool
+		isCurrent(const Image& image);
+		
+		bool isMapped() const;
+		
+		/**
+		 * \returns Number of stored images, including
+		 * unsaved ones.
+		 * */
+		int size() const;
+		
+		/**
+		 * \returns Paths of all stored images, including
+		 * unsaved ones.
+		 * */
+		QStringList paths() const;
+		
+		bool contains(const QString& image) const;
+		
+		/**
+		 * \returns true if stored results of image are of
+		 * file with given modification time and size.
+		 *
+		 * \details Only image record is read, so checking
+		 * files of private store from scanning thread
+		 * is safe.
+		 * */
+		bool isProcessed(const QString& image, qint64 modified, qint64 size) const;
+		
+		/**
+		 * \brief Decodes stored results of image.
+		 *
+		 * \returns false if there's no record of image.
+		 * */
+		bool find(const QString& image, Image& result) const;
+		
+		/**
+		 * \brief Decodes stored results of all images
+		 * whose files didn't change since.
+		 *
+		 * \note Every image file is checked on disk.
+		 * */
+		QVector<Image> currentImages() const;
+		
+		/**
+		 * \brief Adds or replaces results of image.
+		 * */
+		void insert(const Image& image);
+		
+		/**
+		 * \brief Writes mapped and new records to file
+		 * and maps it again.
+		 * */
+		bool save();
+	
+	private:
+		bool map();
+		
+		void unmap();
+		
+		const Details::StoreImage*
+		lookup(const QString& path) const;
+		
+		void decode(const Details::StoreImage& record, Image& result) const;
+		
+		QString string(quint32 index) const;
+		
+		/**
+		 * \returns \c StringTable code of file string.
+		 * */
+		StringCode code(quint32 index) const;
+		
+		template<typename T>
+		const T* section(quint64 offset) const
+		{
+			return reinterpret_cast<const T*>(m_data + offset);
+		}
+	
+	private:
+		QString m_fileName;
+		
+		QFile m_file;
+		
+		const uchar* m_data;
+		
+		const Details::StoreHeader* m_header;
+		
+		//! \c StringTable codes of file strings,
+		//! \c StringTable::NoCode if not interned yet
+		mutable QVector<StringCode> m_codes;
+		
+		//! Inserted but not saved results
+		QHash<QString, Image> m_pending;
+		
+		Q_DISABLE_COPY(ResultsStore)
+	};
+}
\ No newline at end of file
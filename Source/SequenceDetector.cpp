@@ -0,0 +1,381 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "SequenceDetector.hpp"
+#include "FaceApi.hpp"
+#include "FaceDetector.hpp"
+
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QImageIOHandler>
+
+
+namespace Tevian
+{
+	struct SequenceDetector::Job
+	{
+		QMutex mutex;
+		
+		QQueue<QStringList> sequences;
+		
+		bool cancelled;
+		
+		//! Reset when detector is destroyed
+		SequenceDetector* target;
+	};
+	
+	namespace
+	{
+		//! Landmarks fewer than this are replaced by
+		//! grid over box for tracking
+		const int MinPoints = 3;
+		
+		/**
+		 * \brief Reads boxes and landmarks of response scaled
+		 * to tracking frame.
+		 * */
+		QVector<SequenceTracker::Face> readFaces(const QJsonDocument& document, qreal scale)
+		{
+			QVector<SequenceTracker::Face> faces { };
+			
+			for (const auto& detected : FaceDetector::readFaces(document, LandmarksFacet))
+			{
+				SequenceTracker::Face face { };
+				face.box = QRectF(detected.bounds[0] * scale, detected.bounds[1] * scale,
+				                  detected.bounds[2] * scale, detected.bounds[3] * scale);
+				
+				face.points.reserve(detected.landmarks.size());
+				for (const auto& point : detected.landmarks)
+				{
+					face.points.push_back(point * scale);
+				}
+				
+				if (face.points.size() < MinPoints)
+				{
+					face.points.clear();
+					for (int row = 1; row <= 3; ++row)
+					{
+						for (int column = 1; column <= 3; ++column)
+						{
+							face.points.push_back(QPointF(face.box.x() + face.box.width() * column / 4,
+							                              face.box.y() + face.box.height() * row / 4));
+						}
+					}
+				}
+				faces.push_back(face);
+			}
+			return faces;
+		}
+		
+		/**
+		 * \returns Keyframe response with boxes and landmarks
+		 * of tracked faces, other facets are kept.
+		 * */
+		QJsonDocument rewrite(const QJsonDocument& keyframe, const QVector<SequenceTracker::Face>& faces,
+		                      qreal scale)
+		{
+			auto response = keyframe.object();
+			const auto key = JsonReader::facesKey(response);
+			auto array = response.value(key).toArray();
+			
+			for (int i = 0; i < array.size() && i < faces.size(); ++i)
+			{
+				auto object = array.at(i).toObject();
+				const auto& face = faces.at(i);
+				
+				object.insert("bbox", QJsonObject {{ "x",      qRound(face.box.x() / scale) },
+				                                   { "y",      qRound(face.box.y() / scale) },
+				                                   { "width",  qRound(face.box.width() / scale) },
+				                                   { "height", qRound(face.box.height() / scale) }});
+				
+				// Grid points of faces without landmarks
+				// aren't written
+				if (object.value("landmarks").toArray().size() == face.points.size())
+				{
+					QJsonArray landmarks { };
+					for (const auto& point : face.points)
+					{
+						landmarks.push_back(QJsonObject {{ "x", qRound(point.x() / scale) },
+						                                 { "y", qRound(point.y() / scale) }});
+					}
+					object.insert("landmarks", landmarks);
+				}
+				array[i] = object;
+			}
+			
+			response.insert(key, array);
+			return QJsonDocument(response);
+		}
+		
+		class SequenceWorker : public QRunnable
+		{
+		public:
+			SequenceWorker(const SequenceDetector::Options& options,
+			               const std::shared_ptr<SequenceDetector::Job>& job)
+					: m_options { options },
+					  m_job { job }
+			{ }
+			
+			void run() Q_DECL_OVERRIDE
+			{
+				// Created in worker thread, network manager
+				// of api must live here
+				Client::FaceApi api(m_options.detector.url, m_options.detector.path);
+				BatchDetector::configure(api, m_options.detector);
+				
+				QStringList frames;
+				while (take(frames) && process(api, frames))
+				{ }
+				
+				QMutexLocker locker(&m_job->mutex);
+				if (m_job->target)
+				{
+					QMetaObject::invokeMethod(m_job->target, "finishWorker", Qt::QueuedConnection);
+				}
+			}
+		
+		private:
+			bool take(QStringList& frames)
+			{
+				QMutexLocker locker(&m_job->mutex);
+				
+				if (m_job->cancelled || m_job->sequences.isEmpty())
+				{
+					return false;
+				}
+				frames = m_job->sequences.dequeue();
+				return true;
+			}
+			
+			/**
+			 * \returns false if detection is cancelled.
+			 * */
+			bool process(Client::FaceApi& api, const QStringList& frames)
+			{
+				SequenceTracker tracker(m_options.tracker);
+				QJsonDocument keyDocument;
+				QString keyframe;
+				bool tracking = false;
+				int sinceKey = 0;
+				
+				for (const auto& file : frames)
+				{
+					qreal scale = 1.0;
+					const auto frame = decode(file, scale);
+					
+					bool key = !tracking || frame.isNull()
+					           || sinceKey + 1 >= m_options.keyframeInterval
+					           || tracker.change(frame) > m_options.changeThreshold;
+					
+					// Lost face needs keyframe too
+					if (!key && !tracker.track(frame))
+					{
+						key = true;
+					}
+					
+					if (!key)
+					{
+						++sinceKey;
+						if (!post("tracked", Q_ARG(QString, file),
+						          Q_ARG(QJsonDocument, rewrite(keyDocument, tracker.faces(), scale)),
+						          Q_ARG(QString, keyframe)))
+						{
+							return false;
+						}
+						continue;
+					}
+					
+					QElapsedTimer timer;
+					timer.start();
+					
+					QJsonDocument document;
+					api.detect(file, document);
+					
+					const auto latency = timer.elapsed();
+					const auto error = BatchDetector::errorOf(document);
+					
+					if (!error.isEmpty())
+					{
+						tracking = false;
+						if (!post("failed", Q_ARG(QString, file), Q_ARG(QString, error), Q_ARG(qint64, latency)))
+						{
+							return false;
+						}
+						continue;
+					}
+					
+					if (!post("detected", Q_ARG(QString, file), Q_ARG(QJsonDocument, document),
+					          Q_ARG(qint64, latency)))
+					{
+						return false;
+					}
+					
+					tracking = !frame.isNull();
+					if (tracking)
+					{
+						tracker.reset(frame, readFaces(document, scale));
+						keyDocument = document;
+						keyframe = file;
+						sinceKey = 0;
+					}
+				}
+				return true;
+			}
+			
+			/**
+			 * \brief Posts result to detector.
+			 *
+			 * \returns false if detection is cancelled.
+			 * */
+			bool post(const char* method, QGenericArgument file, QGenericArgument document,
+			          QGenericArgument last)
+			{
+				QMutexLocker locker(&m_job->mutex);
+				
+				if (!m_job->target || m_job->cancelled)
+				{
+					return false;
+				}
+				QMetaObject::invokeMethod(m_job->target, method, Qt::QueuedConnection, file, document, last);
+				return true;
+			}
+			
+			/**
+			 * \brief Decodes grayscale frame for tracking with
+			 * longer side not above \c trackSize.
+			 *
+			 * \param scale Set to tracking frame pixels
+			 * per image pixel
+			 * */
+			QImage decode(const QString& file, qreal& scale) const
+			{
+				QImageReader reader(file);
+				reader.setAutoTransform(true);
+				
+				auto original = reader.size();
+				const int limit = m_options.trackSize;
+				const bool rotated = reader.transformation() & QImageIOHandler::TransformationRotate90;
+				bool scaled = false;
+				
+				// Decoders like jpeg's scale while decoding, which
+				// is much cheaper than full frame. Scaled size is
+				// of stored image, so rotated ones are scaled after.
+				if (original.isValid() && !rotated && qMax(original.width(), original.height()) > limit)
+				{
+					reader.setScaledSize(original.scaled(limit, limit, Qt::KeepAspectRatio));
+					scaled = true;
+				}
+				
+				auto image = reader.read();
+				if (image.isNull())
+				{
+					return image;
+				}
+				
+				if (!scaled)
+				{
+					original = image.size();
+				}
+				
+				if (qMax(image.width(), image.height()) > limit)
+				{
+					image = image.scaled(limit, limit, Qt::KeepAspectRatio, Qt::FastTransformation);
+				}
+				
+				scale = qreal(image.width()) / original.width();
+				return SequenceTracker::grayscale(image);
+			}
+		
+		private:
+			SequenceDetector::Options m_options;
+			
+			std::shared_ptr<SequenceDetector::Job> m_job;
+		};
+	}
+	
+	SequenceDetector::SequenceDetector(const Options& options, QObject* parent)
+			: QObject(parent),
+			  m_options { options },
+			  m_pool { },
+			  m_job { std::make_shared<Job>() },
+			  m_workers { 0 }
+	{
+		m_job->cancelled = false;
+		m_job->target = this;
+		m_options.keyframeInterval = qMax(1, m_options.keyframeInterval);
+		m_options.detector.concurrency = qMax(1, m_options.detector.concurrency);
+		m_pool.setMaxThreadCount(m_options.detector.concurrency);
+	}
+	
+	SequenceDetector::~SequenceDetector()
+	{
+		{
+			QMutexLocker locker(&m_job->mutex);
+			m_job->target = nullptr;
+			m_job->cancelled = true;
+		}
+		m_pool.waitForDone();
+	}
+	
+	void SequenceDetector::start(const QVector<QStringList>& sequences)
+	{
+		if (m_workers > 0)
+		{
+			return;
+		}
+		
+		{
+			QMutexLocker locker(&m_job->mutex);
+			m_job->cancelled = false;
+			m_job->sequences.clear();
+			
+			for (const auto& frames : sequences)
+			{
+				if (!frames.isEmpty())
+				{
+					m_job->sequences.enqueue(frames);
+				}
+			}
+			m_workers = qMin(m_options.detector.concurrency, m_job->sequences.size());
+		}
+		
+		if (m_workers == 0)
+		{
+			QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+			return;
+		}
+		
+		for (int i = 0; i < m_workers; ++i)
+		{
+			m_pool.start(new SequenceWorker(m_options, m_job));
+		}
+	}
+	
+	void SequenceDetector::cancel()
+	{
+		QMutexLocker locker(&m_job->mutex);
+		m_job->cancelled = true;
+		m_job->sequences.clear();
+	}
+	
+	bool SequenceDetector::isRunning() const
+	{
+		return m_workers > 0;
+	}
+	
+	void SequenceDetector::finishWorker()
+	{
+		if (--m_workers == 0)
+		{
+			emit finished();
+		}
+	}
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,112 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <memory>
+
+#include "BatchDetector.hpp"
+#include "SequenceTracker.hpp"
+
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+#include <QThreadPool>
+#include <QJsonDocument>
+
+
+namespace Tevian
+{
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Detects faces on image sequences sending only
+	 * keyframes to backend.
+	 *
+	 * \details Frames of one sequence are processed in order by
+	 * one worker owning its \c FaceApi, sequences run in parallel.
+	 * Frame is sent to backend if it's first one, keyframe interval
+	 * passed, its thumbnail differs from keyframe's more than
+	 * threshold or tracking lost a face. Faces of other frames are
+	 * moved by \c SequenceTracker from previous frame, response of
+	 * keyframe with tracked boxes and landmarks is posted for them.
+	 * Tracking runs on frames decoded at reduced size.
+	 * */
+	class TEVIAN_API SequenceDetector : public QObject
+	{
+	Q_OBJECT
+	public:
+		struct Options
+		{
+			BatchDetector::Options detector;
+			
+			SequenceTracker::Options tracker;
+			
+			//! Frames sent to backend at least this often
+			int keyframeInterval = 10;
+			
+			//! Thumbnail change forcing keyframe, 0..1
+			qreal changeThreshold = 0.06;
+			
+			//! Longer side of frames tracking runs on
+			int trackSize = 640;
+		};
+		
+		//! Sequences and state shared with workers
+		struct Job;
+		
+		explicit SequenceDetector(const Options& options, QObject* parent = nullptr);
+		
+		~SequenceDetector() Q_DECL_OVERRIDE;
+		
+		/**
+		 * \brief Starts detecting, frames of every sequence
+		 * must be in order.
+		 * */
+		void start(const QVector<QStringList>& sequences);
+		
+		/**
+		 * \brief Drops sequences not started yet, started
+		 * ones stop at next frame.
+		 * */
+		void cancel();
+		
+		bool isRunning() const;
+	
+	signals:
+		
+		/**
+		 * \brief Emitted for keyframe sent to backend.
+		 *
+		 * \param latency Request time in milliseconds
+		 * */
+		void detected(const QString& file, const QJsonDocument& document, qint64 latency);
+		
+		/**
+		 * \brief Emitted for frame with tracked faces.
+		 *
+		 * \param keyframe Frame response is based on
+		 * */
+		void tracked(const QString& file, const QJsonDocument& document, const QString& keyframe);
+		
+		void failed(const QString& file, const QString& error, qint64 latency);
+		
+		void finished();
+	
+	private slots:
+		
+		void finishWorker();
+	
+	private:
+		Options m_options;
+		
+		QThreadPool m_pool;
+		
+		std::shared_ptr<Job> m_job;
+		
+		int m_workers;
+	};
+}// namespace Tevian
\ No newline at end of file
@@ -0,0 +1,357 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "SequenceTracker.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+namespace Tevian
+{
+	namespace
+	{
+		//! Patches flatter than this standard deviation
+		//! match anywhere
+		const qreal MinContrast = 4.0;
+		
+		//! Scale change of face between two frames
+		const qreal MaxScaleStep = 1.25;
+		
+		bool inside(const QImage& image, int x, int y, int radius)
+		{
+			return x - radius >= 0 && y - radius >= 0
+			       && x + radius < image.width() && y + radius < image.height();
+		}
+		
+		/**
+		 * \returns Sum of squared differences of patches
+		 * centered at given points.
+		 * */
+		qint64 difference(const QImage& first, int x1, int y1,
+		                  const QImage& second, int x2, int y2, int radius)
+		{
+			qint64 sum = 0;
+			for (int dy = -radius; dy <= radius; ++dy)
+			{
+				const uchar* a = first.constScanLine(y1 + dy) + x1;
+				const uchar* b = second.constScanLine(y2 + dy) + x2;
+				
+				for (int dx = -radius; dx <= radius; ++dx)
+				{
+					const int d = int(a[dx]) - int(b[dx]);
+					sum += d * d;
+				}
+			}
+			return sum;
+		}
+		
+		qreal contrast(const QImage& image, int x, int y, int radius)
+		{
+			qint64 sum = 0;
+			qint64 squares = 0;
+			
+			for (int dy = -radius; dy <= radius; ++dy)
+			{
+				const uchar* line = image.constScanLine(y + dy) + x;
+				for (int dx = -radius; dx <= radius; ++dx)
+				{
+					sum += line[dx];
+					squares += line[dx] * line[dx];
+				}
+			}
+			
+			const qreal count = (2 * radius + 1) * (2 * radius + 1);
+			const qreal mean = sum / count;
+			return std::sqrt(qMax(0.0, squares / count - mean * mean));
+		}
+		
+		/**
+		 * \brief Tries offsets within \c range around \c offset,
+		 * which is set to the best one.
+		 *
+		 * \returns Difference of best match, -1 if no patch
+		 * fits into \c second.
+		 * */
+		qint64 search(const QImage& first, const QImage& second, int x, int y,
+		              int radius, int range, QPoint& offset)
+		{
+			const auto start = offset;
+			qint64 best = -1;
+			
+			for (int dy = -range; dy <= range; ++dy)
+			{
+				for (int dx = -range; dx <= range; ++dx)
+				{
+					const int tx = x + start.x() + dx;
+					const int ty = y + start.y() + dy;
+					
+					if (!inside(second, tx, ty, radius))
+					{
+						continue;
+					}
+					
+					const auto sum = difference(first, x, y, second, tx, ty, radius);
+					if (best < 0 || sum < best)
+					{
+						best = sum;
+						offset = QPoint(start.x() + dx, start.y() + dy);
+					}
+				}
+			}
+			return best;
+		}
+		
+		/**
+		 * \returns Offset of parabola vertex through three
+		 * differences, -0.5..0.5.
+		 * */
+		qreal vertex(qint64 left, qint64 centre, qint64 right)
+		{
+			const qreal curvature = left - 2 * centre + right;
+			return curvature > 0 ? qBound(-0.5, (left - right) / (2 * curvature), 0.5) : 0.0;
+		}
+		
+		QImage halve(const QImage& image)
+		{
+			QImage half(image.width() / 2, image.height() / 2, QImage::Format_Grayscale8);
+			
+			for (int y = 0; y < half.height(); ++y)
+			{
+				const uchar* a = image.constScanLine(2 * y);
+				const uchar* b = image.constScanLine(2 * y + 1);
+				uchar* line = half.scanLine(y);
+				
+				for (int x = 0; x < half.width(); ++x)
+				{
+					line[x] = uchar((a[2 * x] + a[2 * x + 1] + b[2 * x] + b[2 * x + 1] + 2) / 4);
+				}
+			}
+			return half;
+		}
+		
+		qreal median(QVector<qreal> values)
+		{
+			auto middle = values.begin() + values.size() / 2;
+			std::nth_element(values.begin(), middle, values.end());
+			return *middle;
+		}
+		
+		qreal spread(const QVector<QPointF>& points)
+		{
+			QPointF centre { };
+			for (const auto& point : points)
+			{
+				centre += point;
+			}
+			centre /= points.size();
+			
+			qreal sum = 0;
+			for (const auto& point : points)
+			{
+				sum += std::hypot(point.x() - centre.x(), point.y() - centre.y());
+			}
+			return sum / points.size();
+		}
+	}
+	
+	SequenceTracker::SequenceTracker(const Options& options)
+			: m_options { options },
+			  m_previous { },
+			  m_previousHalf { },
+			  m_thumbnail { },
+			  m_faces { }
+	{ }
+	
+	void SequenceTracker::reset(const QImage& frame, const QVector<Face>& faces)
+	{
+		m_previous = frame;
+		m_previousHalf = halve(frame);
+		m_thumbnail = thumbnail(frame);
+		m_faces = faces;
+	}
+	
+	bool SequenceTracker::track(const QImage& frame)
+	{
+		if (frame.size() != m_previous.size())
+		{
+			return false;
+		}
+		
+		const auto half = halve(frame);
+		
+		for (auto& face : m_faces)
+		{
+			const auto& points = face.points;
+			QVector<QPointF> moved(points.size());
+			QVector<bool> matched(points.size(), false);
+			QVector<qreal> dxs { };
+			QVector<qreal> dys { };
+			
+			for (int i = 0; i < points.size(); ++i)
+			{
+				if (trackPoint(frame, half, points.at(i), moved[i]))
+				{
+					matched[i] = true;
+					dxs.push_back(moved.at(i).x() - points.at(i).x());
+					dys.push_back(moved.at(i).y() - points.at(i).y());
+				}
+			}
+			
+			if (dxs.isEmpty() || dxs.size() * 2 < points.size())
+			{
+				return false;
+			}
+			
+			// Unmatched points follow the face
+			const QPointF motion(median(dxs), median(dys));
+			QVector<QPointF> before { };
+			QVector<QPointF> after { };
+			
+			for (int i = 0; i < points.size(); ++i)
+			{
+				if (matched.at(i))
+				{
+					before.push_back(points.at(i));
+					after.push_back(moved.at(i));
+				} else
+				{
+					moved[i] = points.at(i) + motion;
+				}
+			}
+			
+			qreal scale = 1.0;
+			if (before.size() > 1 && spread(before) > 0)
+			{
+				scale = qBound(1 / MaxScaleStep, spread(after) / spread(before), MaxScaleStep);
+			}
+			
+			const auto centre = face.box.center() + motion;
+			face.box.setSize(face.box.size() * scale);
+			face.box.moveCenter(centre);
+			face.points = moved;
+		}
+		
+		m_previous = frame;
+		m_previousHalf = half;
+		return true;
+	}
+	
+	qreal SequenceTracker::change(const QImage& frame) const
+	{
+		const auto current = thumbnail(frame);
+		
+		if (current.size() != m_thumbnail.size() || current.isEmpty())
+		{
+			return 1.0;
+		}
+		
+		qint64 sum = 0;
+		for (int i = 0; i < current.size(); ++i)
+		{
+			sum += std::abs(int(current.at(i)) - int(m_thumbnail.at(i)));
+		}
+		return sum / (255.0 * current.size());
+	}
+	
+	const QVector<SequenceTracker::Face>&
+	SequenceTracker::faces() const
+	{
+		return m_faces;
+	}
+	
+	QImage
+	SequenceTracker::grayscale(const QImage& image)
+	{
+		return image.convertToFormat(QImage::Format_Grayscale8);
+	}
+	
+	bool SequenceTracker::trackPoint(const QImage& frame, const QImage& half,
+	                                 const QPointF& point, QPointF& tracked) const
+	{
+		const int radius = m_options.patchRadius;
+		const int x = qRound(point.x());
+		const int y = qRound(point.y());
+		
+		if (!inside(m_previous, x, y, radius) || contrast(m_previous, x, y, radius) < MinContrast)
+		{
+			return false;
+		}
+		
+		// Coarse search covers whole range at quarter cost,
+		// full resolution one only corrects it
+		QPoint offset(0, 0);
+		const int halfRadius = qMax(2, radius / 2);
+		
+		if (inside(m_previousHalf, x / 2, y / 2, halfRadius)
+		    && search(m_previousHalf, half, x / 2, y / 2, halfRadius, m_options.searchRadius / 2, offset) >= 0)
+		{
+			offset *= 2;
+		}
+		
+		const auto best = search(m_previous, frame, x, y, radius, 2, offset);
+		const qreal count = (2 * radius + 1) * (2 * radius + 1);
+		
+		if (best < 0 || std::sqrt(best / count) / 255.0 > m_options.maxError)
+		{
+			return false;
+		}
+		
+		const int tx = x + offset.x();
+		const int ty = y + offset.y();
+		qreal fx = 0;
+		qreal fy = 0;
+		
+		if (inside(frame, tx, ty, radius + 1))
+		{
+			fx = vertex(difference(m_previous, x, y, frame, tx - 1, ty, radius), best,
+			            difference(m_previous, x, y, frame, tx + 1, ty, radius));
+			fy = vertex(difference(m_previous, x, y, frame, tx, ty - 1, radius), best,
+			            difference(m_previous, x, y, frame, tx, ty + 1, radius));
+		}
+		
+		// Patch is centered at rounded point, so fraction
+		// of point is carried over
+		tracked = point + QPointF(offset.x() + fx, offset.y() + fy);
+		return true;
+	}
+	
+	QVector<uchar>
+	SequenceTracker::thumbnail(const QImage& frame)
+	{
+		QVector<uchar> cells { };
+		
+		if (frame.width() < ThumbnailSize || frame.height() < ThumbnailSize)
+		{
+			return cells;
+		}
+		
+		cells.reserve(ThumbnailSize * ThumbnailSize);
+		for (int row = 0; row < ThumbnailSize; ++row)
+		{
+			const int top = row * frame.height() / ThumbnailSize;
+			const int bottom = (row + 1) * frame.height() / ThumbnailSize;
+			
+			for (int column = 0; column < ThumbnailSize; ++column)
+			{
+				const int left = column * frame.width() / ThumbnailSize;
+				const int right = (column + 1) * frame.width() / ThumbnailSize;
+				qint64 sum = 0;
+				
+				for (int y = top; y < bottom; ++y)
+				{
+					const uchar* line = frame.constScanLine(y);
+					for (int x = left; x < right; ++x)
+					{
+						sum += line[x];
+					}
+				}
+				cells.push_back(uchar(sum / qMax(1, (bottom - top) * (right - left))));
+			}
+		}
+		return cells;
+	}
+}// namespace Tevian
\ No newline at end of file
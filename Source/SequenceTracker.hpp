@@ -0,0 +1,111 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Defines.hpp"
+
+#include <QImage>
+#include <QRectF>
+#include <QPointF>
+#include <QVector>
+
+
+namespace Tevian
+{
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Follows faces through frames of image sequence.
+	 *
+	 * \details Faces of keyframe are given by detection. Every
+	 * face point (landmark, or grid over box if there are no
+	 * landmarks) is moved to the next frame by matching its
+	 * patch within search window, coarse at half resolution
+	 * and refined to subpixel at full one. Box follows median
+	 * motion and spread of matched points. Frames must be
+	 * \c grayscale ones of equal size.
+	 * */
+	class TEVIAN_API SequenceTracker
+	{
+	public:
+		struct Options
+		{
+			//! Half side of matched patch
+			int patchRadius = 6;
+			
+			//! Largest motion between frames
+			int searchRadius = 16;
+			
+			//! Root mean square patch difference, 0..1,
+			//! point isn't matched above it
+			qreal maxError = 0.12;
+		};
+		
+		struct Face
+		{
+			QRectF box;
+			
+			QVector<QPointF> points;
+		};
+		
+		//! Side of thumbnail compared by \c change
+		static constexpr int ThumbnailSize = 32;
+		
+		explicit SequenceTracker(const Options& options = Options());
+		
+		/**
+		 * \brief Sets keyframe and its detected faces,
+		 * tracking goes on from it.
+		 * */
+		void reset(const QImage& frame, const QVector<Face>& faces);
+		
+		/**
+		 * \brief Moves faces to next frame.
+		 *
+		 * \returns false if a face is lost, i.e. less than
+		 * half of its points are matched. Faces are left
+		 * undefined then, keyframe must be set.
+		 * */
+		bool track(const QImage& frame);
+		
+		/**
+		 * \returns Mean absolute difference of thumbnails
+		 * of frame and keyframe, 0..1.
+		 * */
+		qreal change(const QImage& frame) const;
+		
+		const QVector<Face>& faces() const;
+		
+		static QImage
+		grayscale(const QImage& image);
+	
+	private:
+		/**
+		 * \brief Finds point of previous frame in \c frame.
+		 *
+		 * \returns false if patch has no texture to match
+		 * or best match is too different.
+		 * */
+		bool trackPoint(const QImage& frame, const QImage& half,
+		                const QPointF& point, QPointF& tracked) const;
+		
+		static QVector<uchar>
+		thumbnail(const QImage& frame);
+	
+	private:
+		Options m_options;
+		
+		QImage m_previous;
+		
+		//! Half resolution previous frame for coarse search
+		QImage m_previousHalf;
+		
+		QVector<uchar> m_thumbnail;
+		
+		QVector<Face> m_faces;
+	};
+}// namespace Tevian
\ No newline at end of file
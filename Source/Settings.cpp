@@ -5,6 +5,8 @@
 #include "Settings.hpp"
 #include <memory>
 
+#include <QStandardPaths>
+
 
 namespace Tevian
 {
@@ -63,6 +65,14 @@ namespace Tevian
 				break;
 			case Key::Token             : m_instance->setValue("login/token", value);
 				break;
+			case Key::ImageBudget       : m_instance->setValue("data/image-budget", value);
+				break;
+			case Key::ExportFormat      : m_instance->setValue("export/format", value);
+				break;
+			case Key::ExportQuality     : m_instance->setValue("export/quality", value);
+				break;
+			case Key::ExportCrops       : m_instance->setValue("export/crops", value);
+				break;
 		}
 	}
 	
@@ -83,6 +93,10 @@ namespace Tevian
 			case Key::Email             : return m_instance->value("login/email");
 			case Key::Password          : return m_instance->value("login/password");
 			case Key::Token             : return m_instance->value("login/token");
+			case Key::ImageBudget       : return m_instance->value("data/image-budget");
+			case Key::ExportFormat      : return m_instance->value("export/format");
+			case Key::ExportQuality     : return m_instance->value("export/quality");
+			case Key::ExportCrops       : return m_instance->value("export/crops");
 			default: break;
 		}
 	}
@@ -112,6 +126,18 @@ namespace Tevian
 		m_loginData->m_token = token.toLocal8Bit();
 	}
 	
+	QString
+	Settings::cachePath()
+	{
+		auto path = get(Key::CachePath).toString();
+		
+		if (path.isEmpty())
+		{
+			path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+		}
+		return path;
+	}
+	
 	QString
 	Settings::email()
 	{
@@ -40,7 +40,16 @@ namespace Tevian
 			ApiPath,
 			Email,
 			Password,
-			Token
+			Token,
+			
+			//! Decoded images budget in megabytes
+			ImageBudget,
+			
+			//! Batch export writer format and quality,
+			//! and whether face crops are written
+			ExportFormat,
+			ExportQuality,
+			ExportCrops
 		};
 		
 		~Settings() Q_DECL_OVERRIDE;
@@ -70,6 +79,12 @@ namespace Tevian
 		
 		QByteArray token();
 		
+		/**
+		 * \returns Cache directory from settings or
+		 * standard cache location if it's not set.
+		 * */
+		QString cachePath();
+		
 		void save();
 	
 	public slots:
@@ -0,0 +1,442 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Statistics.hpp"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QPair>
+#include <QThread>
+#include <QRunnable>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThreadPool>
+
+
+namespace Tevian
+{
+	using namespace Details;
+	
+	namespace
+	{
+		//! Smaller sets are aggregated on calling thread
+		const int ParallelMinimum = 64;
+		
+		QString normalizePath(const QString& path)
+		{
+			return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+		}
+		
+		template<typename Key, typename Value>
+		void addCounts(QHash<Key, Value>& to, const QHash<Key, Value>& from, int sign)
+		{
+			for (auto it = from.constBegin(); it != from.constEnd(); ++it)
+			{
+				auto& count = to[it.key()];
+				count += sign * it.value();
+				
+				if (count == 0)
+				{
+					to.remove(it.key());
+				}
+			}
+		}
+		
+		QString csvField(const QString& value)
+		{
+			if (value.contains(',') || value.contains('"') || value.contains('\n'))
+			{
+				return QString("\"%1\"").arg(QString(value).replace("\"", "\"\""));
+			}
+			return value;
+		}
+		
+		/**
+		 * \brief Aggregates a range of images to its
+		 * own partial, no data is shared with other tasks.
+		 * */
+		class AggregateTask : public QRunnable
+		{
+		public:
+			AggregateTask(const QVector<ResultsStore::Image>& images, int first, int last,
+			              Summary& result, Summary* partials)
+					: m_images(images),
+					  m_first { first },
+					  m_last { last },
+					  m_result(result),
+					  m_partials { partials }
+			{ }
+			
+			void run() Q_DECL_OVERRIDE
+			{
+				for (int i = m_first; i < m_last; ++i)
+				{
+					const auto& image = m_images.at(i);
+					
+					// Partials let images be replaced later,
+					// result is their sum
+					if (m_partials)
+					{
+						auto& partial = m_partials[i];
+						partial.add(image.faces, image.facets);
+						m_result += partial;
+					} else
+					{
+						m_result.add(image.faces, image.facets);
+					}
+				}
+			}
+		
+		private:
+			const QVector<ResultsStore::Image>& m_images;
+			
+			int m_first;
+			
+			int m_last;
+			
+			Summary& m_result;
+			
+			//! Per-image results, each task writes its own range
+			Summary* m_partials;
+		};
+	}
+	
+	class Statistics::InsertTask : public QRunnable
+	{
+	public:
+		InsertTask(const QVector<ResultsStore::Image>& images, Statistics* statistics)
+				: m_images(images),
+				  m_statistics { statistics }
+		{ }
+		
+		void run() Q_DECL_OVERRIDE
+		{
+			QVector<Summary> partials { };
+			const auto merged = aggregate(m_images, &partials);
+			m_statistics->merge(m_images, partials, merged);
+		}
+	
+	private:
+		QVector<ResultsStore::Image> m_images;
+		
+		Statistics* m_statistics;
+	};
+	
+	/// Summary
+	Summary::Summary()
+			: images { },
+			  faces { },
+			  demographicFaces { },
+			  attributeFaces { },
+			  ageHistogram(AgeBinCount),
+			  ageMeans { },
+			  ageVariances { },
+			  scores { },
+			  genders { },
+			  ethnicities { },
+			  attributes { }
+	{ }
+	
+	void Summary::add(const QVector<Face>& faces, Facets facets)
+	{
+		const bool demographics = facets & DemographicsFacet;
+		const bool attributed = facets & AttributesFacet;
+		
+		++images;
+		this->faces += faces.size();
+		
+		for (const auto& face : faces)
+		{
+			scores.add(face.score);
+			
+			if (demographics)
+			{
+				const auto& age = face.demographics._age;
+				const int bin = qBound(0, int(age._mean) / AgeBinWidth, AgeBinCount - 1);
+				
+				++demographicFaces;
+				++ageHistogram[bin];
+				ageMeans.add(age._mean);
+				ageVariances.add(age._variance);
+				++genders[face.demographics._gender];
+				++ethnicities[face.demographics._ethnicity];
+			}
+			
+			if (attributed)
+			{
+				++attributeFaces;
+				for (const auto& attribute : face.attributes)
+				{
+					++attributes[(quint64(attribute.key) << 32) | attribute.value];
+				}
+			}
+		}
+	}
+	
+	Summary& Summary::operator+=(const Summary& other)
+	{
+		images += other.images;
+		faces += other.faces;
+		demographicFaces += other.demographicFaces;
+		attributeFaces += other.attributeFaces;
+		
+		for (int i = 0; i < AgeBinCount; ++i)
+		{
+			ageHistogram[i] += other.ageHistogram.at(i);
+		}
+		
+		ageMeans += other.ageMeans;
+		ageVariances += other.ageVariances;
+		scores += other.scores;
+		addCounts(genders, other.genders, 1);
+		addCounts(ethnicities, other.ethnicities, 1);
+		addCounts(attributes, other.attributes, 1);
+		return *this;
+	}
+	
+	Summary& Summary::operator-=(const Summary& other)
+	{
+		images -= other.images;
+		faces -= other.faces;
+		demographicFaces -= other.demographicFaces;
+		attributeFaces -= other.attributeFaces;
+		
+		for (int i = 0; i < AgeBinCount; ++i)
+		{
+			ageHistogram[i] -= other.ageHistogram.at(i);
+		}
+		
+		ageMeans -= other.ageMeans;
+		ageVariances -= other.ageVariances;
+		scores -= other.scores;
+		addCounts(genders, other.genders, -1);
+		addCounts(ethnicities, other.ethnicities, -1);
+		addCounts(attributes, other.attributes, -1);
+		return *this;
+	}
+	
+	double Summary::ageVariance() const
+	{
+		// Law of total variance over per-face estimates
+		return ageMeans.variance() + ageVariances.mean();
+	}
+	
+	QString Summary::toCsv() const
+	{
+		QString csv;
+		
+		auto row = [ & ](const QString& section, const QString& key, double value, qint64 total)
+		{
+			// Multi-arg form, keys may contain '%'
+			csv += QString("%1,%2,%3,%4\n")
+					.arg(csvField(section),
+					     csvField(key),
+					     QString::number(value, 'g', 12),
+					     total > 0 ? QString::number(value / total) : QString());
+		};
+		
+		// Hashes have no stable order, rows are sorted by key
+		auto counts = [ & ](const QString& section, const QHash<StringCode, qint64>& values, qint64 total)
+		{
+			QVector<QPair<QString, qint64>> sorted { };
+			
+			for (auto it = values.constBegin(); it != values.constEnd(); ++it)
+			{
+				sorted.push_back({ g_stringTable->string(it.key()), it.value() });
+			}
+			
+			std::sort(sorted.begin(), sorted.end());
+			for (const auto& item : sorted)
+			{
+				row(section, item.first, item.second, total);
+			}
+		};
+		
+		csv += "section,key,value,share\n";
+		row("total", "images", images, 0);
+		row("total", "faces", faces, 0);
+		row("score", "mean", scores.mean(), 0);
+		row("age", "mean", ageMeans.mean(), 0);
+		row("age", "variance", ageVariance(), 0);
+		
+		for (int i = 0; i < AgeBinCount; ++i)
+		{
+			const auto key = i == AgeBinCount - 1
+			                 ? QString("%1+").arg(i * AgeBinWidth)
+			                 : QString("%1-%2").arg(i * AgeBinWidth).arg((i + 1) * AgeBinWidth - 1);
+			row("age", key, ageHistogram.at(i), demographicFaces);
+		}
+		
+		counts("gender", genders, demographicFaces);
+		counts("ethnicity", ethnicities, demographicFaces);
+		
+		QVector<QPair<QString, qint64>> sorted { };
+		
+		for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+		{
+			sorted.push_back({ QString("%1=%2")
+					                   .arg(g_stringTable->string(StringCode(it.key() >> 32)),
+					                        g_stringTable->string(StringCode(it.key()))),
+			                   it.value() });
+		}
+		
+		std::sort(sorted.begin(), sorted.end());
+		for (const auto& item : sorted)
+		{
+			row("attribute", item.first, item.second, attributeFaces);
+		}
+		return csv;
+	}
+	
+	/// Statistics
+	Statistics::Statistics()
+			: QObject(nullptr),
+			  m_summary { },
+			  m_images { }
+	{ }
+	
+	Statistics*
+	Statistics::getStatistics()
+	{
+		static Statistics instance;
+		return &instance;
+	}
+	
+	Summary
+	Statistics::aggregate(const QVector<ResultsStore::Image>& images, QVector<Summary>* partials)
+	{
+		Summary* partialData = nullptr;
+		
+		if (partials)
+		{
+			*partials = QVector<Summary>(images.size());
+			partialData = partials->data();
+		}
+		
+		const int threads = images.size() < ParallelMinimum
+		                    ? 1
+		                    : qMax(1, QThread::idealThreadCount());
+		const int chunk = (images.size() + threads - 1) / qMax(1, threads);
+		
+		// One partial per task, merged when all are done
+		QVector<Summary> results(threads);
+		
+		if (threads == 1)
+		{
+			AggregateTask(images, 0, images.size(), results[0], partialData).run();
+			return results.at(0);
+		}
+		
+		QThreadPool pool;
+		pool.setMaxThreadCount(threads);
+		
+		for (int i = 0; i < threads; ++i)
+		{
+			const int first = qMin(images.size(), i * chunk);
+			const int last = qMin(images.size(), first + chunk);
+			pool.start(new AggregateTask(images, first, last, results[i], partialData));
+		}
+		pool.waitForDone();
+		
+		Summary summary;
+		for (const auto& result : results)
+		{
+			summary += result;
+		}
+		return summary;
+	}
+	
+	void Statistics::insert(const QString& image, const QVector<Face>& faces, Facets facets)
+	{
+		Summary partial;
+		partial.add(faces, facets);
+		
+		{
+			QMutexLocker locker(&m_mutex);
+			replace(normalizePath(image), partial);
+		}
+		emit updated();
+	}
+	
+	int Statistics::insert(const ResultsStore& store)
+	{
+		// Store registry is used by calling thread only,
+		// its copied results are aggregated by pool
+		return insert(store.currentImages());
+	}
+	
+	int Statistics::insert(const QVector<ResultsStore::Image>& images)
+	{
+		if (!images.isEmpty())
+		{
+			QThreadPool::globalInstance()->start(new InsertTask(images, this));
+		}
+		return images.size();
+	}
+	
+	bool Statistics::contains(const QString& image) const
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_images.contains(normalizePath(image));
+	}
+	
+	qint64 Statistics::faces(const QString& image) const
+	{
+		QMutexLocker locker(&m_mutex);
+		const auto found = m_images.constFind(normalizePath(image));
+		return found == m_images.constEnd() ? -1 : found->faces;
+	}
+	
+	Summary Statistics::summary() const
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_summary;
+	}
+	
+	void Statistics::clear()
+	{
+		{
+			QMutexLocker locker(&m_mutex);
+			m_summary = Summary();
+			m_images.clear();
+		}
+		emit updated();
+	}
+	
+	void Statistics::merge(const QVector<ResultsStore::Image>& images,
+	                       const QVector<Summary>& partials, Summary merged)
+	{
+		{
+			QMutexLocker locker(&m_mutex);
+			
+			// Images detected while store was aggregated
+			// hold newer results
+			for (int i = 0; i < images.size(); ++i)
+			{
+				const auto path = normalizePath(images.at(i).path);
+				
+				if (m_images.contains(path))
+				{
+					merged -= partials.at(i);
+				} else
+				{
+					m_images.insert(path, partials.at(i));
+				}
+			}
+			m_summary += merged;
+		}
+		emit updated();
+	}
+	
+	void Statistics::replace(const QString& path, const Summary& partial)
+	{
+		auto& current = m_images[path];
+		
+		m_summary -= current;
+		m_summary += partial;
+		current = partial;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include "Commons.hpp"
+#include "FaceDetector.hpp"
+#include "ResultsStore.hpp"
+#include "StringTable.hpp"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+
+namespace Tevian
+{
+	namespace Details
+	{
+		/**
+		 * \brief Count, sum and sum of squares of values.
+		 *
+		 * \details Sums are additive, so partials of threads
+		 * are merged and results of replaced image are
+		 * subtracted without visiting other faces.
+		 * */
+		struct Moments
+		{
+			qint64 count = 0;
+			
+			double sum = 0.0;
+			
+			double squares = 0.0;
+			
+			inline void add(double value)
+			{
+				++count;
+				sum += value;
+				squares += value * value;
+			}
+			
+			inline Moments& operator+=(const Moments& other)
+			{
+				count += other.count;
+				sum += other.sum;
+				squares += other.squares;
+				return *this;
+			}
+			
+			inline Moments& operator-=(const Moments& other)
+			{
+				count -= other.count;
+				sum -= other.sum;
+				squares -= other.squares;
+				return *this;
+			}
+			
+			inline double mean() const
+			{
+				return count ? sum / count : 0.0;
+			}
+			
+			inline double variance() const
+			{
+				return count ? qMax(0.0, squares / count - mean() * mean()) : 0.0;
+			}
+		};
+	}
+	
+	/**
+	 * \brief Aggregated demographics and attributes
+	 * of a set of faces.
+	 * */
+	struct TEVIAN_API Summary
+	{
+		//! Width of age histogram bin in years
+		static constexpr int AgeBinWidth = 5;
+		
+		//! Last bin holds all older ages
+		static constexpr int AgeBinCount = 20;
+		
+		Summary();
+		
+		/**
+		 * \brief Adds results of one image.
+		 * */
+		void add(const QVector<Details::Face>& faces, Facets facets);
+		
+		Summary& operator+=(const Summary& other);
+		
+		Summary& operator-=(const Summary& other);
+		
+		/**
+		 * \returns Variance of age over all faces, spread of
+		 * age means plus mean of per-face age variances.
+		 * */
+		double ageVariance() const;
+		
+		/**
+		 * \brief Writes summary as csv rows of
+		 * section, key, value and share of faces.
+		 * */
+		QString toCsv() const;
+		
+		int images;
+		
+		qint64 faces;
+		
+		//! Faces having demographics facet
+		qint64 demographicFaces;
+		
+		//! Faces having attributes facet
+		qint64 attributeFaces;
+		
+		//! Number of faces in each age bin
+		QVector<qint64> ageHistogram;
+		
+		//! \c Demographics::Age::_mean of faces
+		Details::Moments ageMeans;
+		
+		//! \c Demographics::Age::_variance of faces
+		Details::Moments ageVariances;
+		
+		Details::Moments scores;
+		
+		QHash<StringCode, qint64> genders;
+		
+		QHash<StringCode, qint64> ethnicities;
+		
+		//! Counts by attribute key and value codes
+		QHash<quint64, qint64> attributes;
+	};
+	
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Summary of all collected detection results.
+	 *
+	 * \details Stored datasets are reduced in parallel off
+	 * calling thread, each thread aggregates its share of
+	 * images into partials that are merged at the end. Newly
+	 * detected images replace their previous contribution
+	 * only, so summary stays current without aggregating
+	 * whole dataset again.
+	 *
+	 * \note Statistics is thread safe.
+	 * */
+	class TEVIAN_API Statistics : public QObject
+	{
+	Q_OBJECT
+	public:
+		static Statistics*
+		getStatistics();
+		
+		/**
+		 * \brief Aggregates images using all cores.
+		 *
+		 * \param partials If not null, receives summary
+		 * of every image in the same order.
+		 * */
+		static Summary
+		aggregate(const QVector<ResultsStore::Image>& images,
+		          QVector<Summary>* partials = nullptr);
+		
+		/**
+		 * \brief Adds or replaces results of image.
+		 * */
+		void insert(const QString& image, const QVector<Details::Face>& faces,
+		            Facets facets);
+		
+		/**
+		 * \brief Adds all current results of store, images
+		 * already held keep their results.
+		 *
+		 * \details Results are read on calling thread and
+		 * aggregated on global thread pool, \c updated is
+		 * emitted when they are added to summary.
+		 *
+		 * \returns Number of images to aggregate.
+		 * */
+		int insert(const ResultsStore& store);
+		
+		/**
+		 * \brief Adds decoded results, images already
+		 * held keep their results.
+		 *
+		 * \details Aggregated on global thread pool like
+		 * results of store.
+		 * */
+		int insert(const QVector<ResultsStore::Image>& images);
+		
+		bool contains(const QString& image) const;
+		
+		/**
+		 * \returns Number of faces found on image,
+		 * -1 if image has no results.
+		 * */
+		qint64 faces(const QString& image) const;
+		
+		Summary summary() const;
+		
+		void clear();
+	
+	signals:
+		
+		/**
+		 * \brief Emitted when summary changes,
+		 * possibly from other thread.
+		 * */
+		void updated();
+	
+	private:
+		//! Aggregates results of store
+		class InsertTask;
+		
+		Statistics();
+		
+		void replace(const QString& path, const Summary& partial);
+		
+		/**
+		 * \brief Adds aggregated images that aren't
+		 * held yet.
+		 *
+		 * \param merged Sum of \c partials
+		 * */
+		void merge(const QVector<ResultsStore::Image>& images,
+		           const QVector<Summary>& partials, Summary merged);
+	
+	private:
+		mutable QMutex m_mutex;
+		
+		Summary m_summary;
+		
+		//! Contribution of every image to summary
+		QHash<QString, Summary> m_images;
+	};
+	
+	static Statistics* g_statistics = Statistics::getStatistics();
+}
\ No newline at end of file
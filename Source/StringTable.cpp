@@ -0,0 +1,87 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "StringTable.hpp"
+
+
+namespace Tevian
+{
+	StringTable::StringTable()
+			: m_codes { },
+			  m_strings { }
+	{
+		m_strings.emplace_back();
+		m_codes.insert(QString(), Empty);
+	}
+	
+	StringTable*
+	StringTable::getStringTable()
+	{
+		// Initialized on first use, so stores and detectors
+		// created during static initialization see the table
+		static StringTable instance;
+		return &instance;
+	}
+	
+	StringCode StringTable::intern(const QString& value)
+	{
+		if (value.isEmpty())
+		{
+			return Empty;
+		}
+		
+		{
+			QReadLocker locker(&m_lock);
+			auto found = m_codes.constFind(value);
+			if (found != m_codes.constEnd())
+			{
+				return found.value();
+			}
+		}
+		
+		QWriteLocker locker(&m_lock);
+		
+		// May be added by other thread while unlocked
+		auto found = m_codes.constFind(value);
+		if (found != m_codes.constEnd())
+		{
+			return found.value();
+		}
+		
+		const auto code = StringCode(m_strings.size());
+		m_strings.push_back(value);
+		m_codes.insert(value, code);
+		return code;
+	}
+	
+	StringCode StringTable::find(const QString& value) const
+	{
+		if (value.isEmpty())
+		{
+			return Empty;
+		}
+		
+		QReadLocker locker(&m_lock);
+		return m_codes.value(value, NoCode);
+	}
+	
+	const QString&
+	StringTable::string(StringCode code) const
+	{
+		QReadLocker locker(&m_lock);
+		
+		if (code >= m_strings.size())
+		{
+			return m_strings.front();
+		}
+		return m_strings[code];
+	}
+	
+	int StringTable::size() const
+	{
+		QReadLocker locker(&m_lock);
+		return int(m_strings.size());
+	}
+}
\ No newline at end of file
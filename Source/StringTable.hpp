@@ -0,0 +1,84 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+#pragma once
+
+
+#include <deque>
+
+#include "Defines.hpp"
+
+#include <QHash>
+#include <QString>
+#include <QReadWriteLock>
+
+
+namespace Tevian
+{
+	//! Code of interned string, valid during process lifetime
+	using StringCode = quint32;
+	
+	/**
+	 * \author Alvin Ahmadov
+	 * \namespace Tevian
+	 *
+	 * \brief Process-wide table of interned strings.
+	 *
+	 * \details Attribute keys, attribute values and
+	 * demographics categories repeat across all faces,
+	 * so faces keep integer codes and each distinct
+	 * string is stored once. Code \c Empty always
+	 * denotes empty string.
+	 *
+	 * \note Table is thread safe, strings are never
+	 * removed, so returned references stay valid.
+	 * */
+	class TEVIAN_API StringTable
+	{
+	public:
+		static constexpr StringCode Empty = 0;
+		
+		//! Returned by \c find for unknown strings
+		static constexpr StringCode NoCode = StringCode(-1);
+		
+		static StringTable*
+		getStringTable();
+		
+		/**
+		 * \returns Code of string, adding it to
+		 * table if it's new.
+		 * */
+		StringCode intern(const QString& value);
+		
+		/**
+		 * \returns Code of string or \c NoCode if string
+		 * isn't interned. Doesn't modify table.
+		 * */
+		StringCode find(const QString& value) const;
+		
+		/**
+		 * \returns Interned string of code or empty
+		 * string if code is unknown.
+		 * */
+		const QString&
+		string(StringCode code) const;
+		
+		int size() const;
+	
+	private:
+		StringTable();
+	
+	private:
+		mutable QReadWriteLock m_lock;
+		
+		QHash<QString, StringCode> m_codes;
+		
+		//! Deque keeps references valid on growth
+		std::deque<QString> m_strings;
+		
+		Q_DISABLE_COPY(StringTable)
+	};
+	
+	static StringTable* g_stringTable = StringTable::getStringTable();
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+/**
+ *  Copyright (C) 2019
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ */
+
+#include "Defines.hpp"
+#include "FaceDetector.hpp"
+#include "Gui/FacePainter.hpp"
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include <QImage>
+#include <QPainter>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QCommandLineParser>
+
+
+using namespace Tevian;
+using namespace Tevian::Gui;
+
+namespace
+{
+	//! Landmarks per face of detect response
+	const int PointCount = 68;
+	
+	/**
+	 * \returns Faces with landmarks spread over
+	 * image of given size, same for every run.
+	 * */
+	QVector<Details::Face> makeFaces(int count, const QSize& size)
+	{
+		std::mt19937 random(count);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		QVector<Details::Face> faces(count);
+		
+		for (auto& face : faces)
+		{
+			const int extent = 60 + int(unit(random) * 140);
+			const int x = int(unit(random) * (size.width() - extent));
+			const int y = int(unit(random) * (size.height() - extent));
+			
+			face.bounds = { x, y, extent, extent };
+			face.landmarks.reserve(PointCount);
+			for (int i = 0; i < PointCount; ++i)
+			{
+				face.landmarks.push_back(QPointF(x + unit(random) * extent, y + unit(random) * extent));
+			}
+		}
+		return faces;
+	}
+	
+	/**
+	 * \brief Landmark drawing replaced by sprite, pen and
+	 * brush per face and ellipse per point.
+	 * */
+	void paintLoop(QPainter* painter, const QVector<Details::Face>& faces, int pointSize)
+	{
+		const QColor pencolor(50, 100, 120, 200);
+		const QColor brushcolor(100, 100, 100, 120);
+		
+		for (const auto& face : faces)
+		{
+			painter->setPen(pencolor);
+			painter->setBrush(brushcolor);
+			painter->drawPoints(face.landmarks.constData(), face.landmarks.size());
+			for (const auto& point : face.landmarks)
+			{
+				painter->drawEllipse(QRectF(point.x(), point.y(), pointSize, pointSize));
+			}
+		}
+		painter->setPen(Qt::NoPen);
+		painter->setBrush(Qt::NoBrush);
+	}
+	
+	/**
+	 * \returns Median milliseconds of frame, fill of
+	 * target isn't counted.
+	 * */
+	template<typename Paint>
+	double measure(QImage& target, qreal zoom, int frames, Paint paint)
+	{
+		QVector<qint64> times { };
+		times.reserve(frames);
+		
+		for (int frame = -1; frame < frames; ++frame)
+		{
+			target.fill(Qt::white);
+			
+			QElapsedTimer timer;
+			timer.start();
+			
+			QPainter painter(&target);
+			painter.setRenderHint(QPainter::Antialiasing);
+			painter.scale(zoom, zoom);
+			paint(&painter);
+			painter.end();
+			
+			// First frame builds caches, it isn't counted
+			if (frame >= 0)
+			{
+				times.push_back(timer.nsecsElapsed());
+			}
+		}
+		
+		if (times.isEmpty())
+		{
+			return 0.0;
+		}
+		
+		std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+		return times.at(times.size() / 2) / 1e6;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication::setApplicationName("TevianBench");
+	
+	// Pixmap sprite needs gui application, run with
+	// -platform offscreen when there's no display
+	QGuiApplication app(argc, argv);
+	
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measures drawing of face landmarks into offscreen image.");
+	parser.addHelpOption();
+	
+	QCommandLineOption facesOption("faces", "Faces per frame.", "count", "50");
+	QCommandLineOption framesOption("frames", "Measured frames.", "count", "200");
+	QCommandLineOption sizeOption("size", "Side of square target image.", "pixels", "2048");
+	
+	parser.addOptions({ facesOption, framesOption, sizeOption });
+	parser.process(app);
+	
+	QTextStream output(stdout);
+	
+	const int frames = parser.value(framesOption).toInt();
+	const int extent = parser.value(sizeOption).toInt();
+	const auto faces = makeFaces(parser.value(facesOption).toInt(), QSize(extent, extent));
+	
+	QImage target(extent, extent, QImage::Format_ARGB32_Premultiplied);
+	FacePainter facePainter;
+	facePainter.setFaces(faces);
+	
+	FacePainter imagePainter(FacePainter::Image);
+	imagePainter.setFaces(faces);
+	
+	output << "Qt " << qVersion() << ", platform " << QGuiApplication::platformName() << endl;
+	output << faces.size() << " faces x " << PointCount << " points, "
+	       << frames << " frames of " << extent << "x" << extent << ", median per frame" << endl;
+	
+	for (const qreal zoom : { 0.5, 1.0, 2.0 })
+	{
+		const auto loop = measure(target, zoom, frames, [ & ](QPainter* painter)
+		{
+			paintLoop(painter, faces, facePainter.pointSize());
+		});
+		
+		const auto sprite = measure(target, zoom, frames, [ & ](QPainter* painter)
+		{
+			for (int face = 0; face < facePainter.size(); ++face)
+			{
+				facePainter.paintLandmarks(painter, face);
+			}
+		});
+		
+		const auto path = measure(target, zoom, frames, [ & ](QPainter* painter)
+		{
+			for (int face = 0; face < imagePainter.size(); ++face)
+			{
+				imagePainter.paintLandmarks(painter, face);
+			}
+		});
+		
+		output << "zoom " << zoom
+		       << ": loop " << QString::number(loop, 'f', 3) << " ms"
+		       << ", sprite " << QString::number(sprite, 'f', 3) << " ms"
+		       << ", path " << QString::number(path, 'f', 3) << " ms"
+		       << ", speedup " << QString::number(loop / qMax(1e-6, sprite), 'f', 2) << endl;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,600 @@
+#include "Defines.hpp"
+#include "Settings.hpp"
+#include "BatchDetector.hpp"
+#include "DirectoryScanner.hpp"
+#include "FolderWatcher.hpp"
+#include "SequenceDetector.hpp"
+#include "Deduplicator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <QFileInfo>
+#include <QCollator>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+
+using namespace Tevian;
+
+namespace
+{
+	enum ExitCode
+	{
+		//! Every image is detected
+		Success = 0,
+		//! Some requests failed
+		PartialFailure = 1,
+		//! Bad arguments or nothing to process
+		UsageError = 2,
+		//! Every request failed, backend or login is wrong
+		TotalFailure = 3
+	};
+	
+	/**
+	 * \brief Expands argument to image files: glob by its
+	 * directory, "-" by lines of standard input. Directories
+	 * are left to scanner.
+	 * */
+	void collect(const QString& argument, QStringList& files, QStringList& directories)
+	{
+		if (argument == "-")
+		{
+			QTextStream input(stdin);
+			QString line;
+			while (input.readLineInto(&line))
+			{
+				line = line.trimmed();
+				if (!line.isEmpty() && line != "-")
+				{
+					collect(line, files, directories);
+				}
+			}
+			return;
+		}
+		
+		const QFileInfo info(argument);
+		
+		if (info.isDir())
+		{
+			directories.push_back(argument);
+		} else if (argument.contains(QRegExp("[*?\\[]")))
+		{
+			const QDir directory(info.path());
+			for (const auto& name : directory.entryList({ info.fileName() }, QDir::Files, QDir::Name))
+			{
+				files.push_back(directory.filePath(name));
+			}
+		} else
+		{
+			files.push_back(argument);
+		}
+	}
+	
+	//! Set by signal handler, polled by event loop
+	volatile std::sig_atomic_t g_interrupted = 0;
+	
+	void interrupt(int)
+	{
+		g_interrupted = 1;
+	}
+	
+	/**
+	 * \brief Writes one line per image, flushed so
+	 * consumers can stream.
+	 * */
+	void writeRecord(QFile& output, const QJsonObject& record)
+	{
+		output.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+		output.write("\n");
+		output.flush();
+	}
+	
+	QJsonObject detectedRecord(const QString& file, const QJsonDocument& document, qint64 latency)
+	{
+		return {{ "file",       file },
+		        { "ok",         true },
+		        { "latency_ms", latency },
+		        { "response",   document.isArray()
+		                        ? QJsonValue(document.array())
+		                        : QJsonValue(document.object()) }};
+	}
+	
+	QJsonObject failedRecord(const QString& file, const QString& error, qint64 latency)
+	{
+		return {{ "file",       file },
+		        { "ok",         false },
+		        { "latency_ms", latency },
+		        { "error",      error }};
+	}
+	
+	/**
+	 * \brief Detects images dropped into directories until
+	 * interrupted, results are also saved to results store.
+	 *
+	 * \param interval Seconds between throughput reports,
+	 * none if 0
+	 * */
+	int watchFolders(const QStringList& directories, const FolderWatcher::Options& options,
+	                 QFile& output, int interval)
+	{
+		QTextStream errors(stderr);
+		FolderWatcher watcher(options);
+		
+		QObject::connect(&watcher, &FolderWatcher::detected,
+		                 [&output](const QString& file, const QJsonDocument& document, qint64 latency)
+		                 {
+			                 writeRecord(output, detectedRecord(file, document, latency));
+		                 });
+		QObject::connect(&watcher, &FolderWatcher::failed,
+		                 [&output](const QString& file, const QString& error, qint64 latency)
+		                 {
+			                 writeRecord(output, failedRecord(file, error, latency));
+		                 });
+		QObject::connect(&watcher, &FolderWatcher::finished, qApp, &QCoreApplication::quit);
+		
+		if (watcher.watch(directories) == 0)
+		{
+			errors << "No directory can be watched" << endl;
+			return UsageError;
+		}
+		
+		auto report = [&]()
+		{
+			errors << "Throughput: " << QString::number(watcher.throughput(), 'f', 2) << " images/s"
+			       << ", queue: " << watcher.queueDepth()
+			       << ", detected: " << watcher.detectedCount()
+			       << ", failed: " << watcher.failedCount() << endl;
+		};
+		
+		QTimer reportTimer;
+		QObject::connect(&reportTimer, &QTimer::timeout, report);
+		if (interval > 0)
+		{
+			reportTimer.start(interval * 1000);
+		}
+		
+		// Files in flight are finished after interrupt,
+		// handler can't stop watcher itself
+		std::signal(SIGINT, interrupt);
+		std::signal(SIGTERM, interrupt);
+		
+		QTimer interruptTimer;
+		QObject::connect(&interruptTimer, &QTimer::timeout,
+		                 [&]()
+		                 {
+			                 if (g_interrupted)
+			                 {
+				                 interruptTimer.stop();
+				                 watcher.stop();
+			                 }
+		                 });
+		interruptTimer.start(200);
+		
+		QCoreApplication::exec();
+		report();
+		
+		if (watcher.failedCount() == 0)
+		{
+			return Success;
+		}
+		return watcher.detectedCount() == 0 ? TotalFailure : PartialFailure;
+	}
+	
+	/**
+	 * \brief Orders frames by name, numbers in names
+	 * are compared by value.
+	 * */
+	void sortFrames(QStringList& frames)
+	{
+		QCollator collator;
+		collator.setNumericMode(true);
+		std::sort(frames.begin(), frames.end(), collator);
+	}
+	
+	/**
+	 * \brief Detects faces on frame sequences, frames between
+	 * keyframes get tracked faces without request.
+	 * */
+	int detectSequences(const QVector<QStringList>& sequences, const SequenceDetector::Options& options,
+	                    QFile& output)
+	{
+		QTextStream errors(stderr);
+		SequenceDetector detector(options);
+		int frames = 0;
+		int requests = 0;
+		int failures = 0;
+		
+		QObject::connect(&detector, &SequenceDetector::detected,
+		                 [&](const QString& file, const QJsonDocument& document, qint64 latency)
+		                 {
+			                 ++frames;
+			                 ++requests;
+			                 writeRecord(output, detectedRecord(file, document, latency));
+		                 });
+		QObject::connect(&detector, &SequenceDetector::tracked,
+		                 [&](const QString& file, const QJsonDocument& document, const QString& keyframe)
+		                 {
+			                 ++frames;
+			                 auto record = detectedRecord(file, document, 0);
+			                 record.insert("tracked", true);
+			                 record.insert("keyframe", keyframe);
+			                 writeRecord(output, record);
+		                 });
+		QObject::connect(&detector, &SequenceDetector::failed,
+		                 [&](const QString& file, const QString& error, qint64 latency)
+		                 {
+			                 ++frames;
+			                 ++requests;
+			                 ++failures;
+			                 writeRecord(output, failedRecord(file, error, latency));
+		                 });
+		QObject::connect(&detector, &SequenceDetector::finished, qApp, &QCoreApplication::quit);
+		
+		QElapsedTimer timer;
+		timer.start();
+		detector.start(sequences);
+		QCoreApplication::exec();
+		
+		const double seconds = qMax<qint64>(1, timer.elapsed()) / 1000.0;
+		errors << "Frames: " << frames
+		       << ", requests: " << requests
+		       << ", tracked: " << frames - requests
+		       << ", failed: " << failures
+		       << ", time: " << QString::number(seconds, 'f', 2) << " s"
+		       << ", throughput: " << QString::number(frames / seconds, 'f', 2) << " frames/s" << endl;
+		
+		if (failures == 0)
+		{
+			return Success;
+		}
+		return failures == frames ? TotalFailure : PartialFailure;
+	}
+	
+	qint64 percentile(const QVector<qint64>& sorted, double p)
+	{
+		if (sorted.isEmpty())
+		{
+			return 0;
+		}
+		const int rank = int(std::ceil(p * sorted.size())) - 1;
+		return sorted.at(qBound(0, rank, sorted.size() - 1));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication::setOrganizationName(ORGANIZATION);
+	QCoreApplication::setOrganizationDomain(BACKEND_URL);
+	QCoreApplication::setApplicationName(PROJECT_NAME);
+	QCoreApplication::setApplicationVersion(PROJECT_VERSION);
+	
+	QCoreApplication app(argc, argv);
+	
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Detects faces on images and writes one JSON record per image.");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addPositionalArgument("inputs", "Image files, directories, globs or - to read paths from stdin.",
+	                             "<inputs...>");
+	
+	QCommandLineOption jobsOption({ "j", "jobs" }, "Concurrent requests.", "count", "4");
+	QCommandLineOption outputOption({ "o", "output" }, "Output file, stdout by default.", "file");
+	QCommandLineOption urlOption("url", "Backend url.", "url");
+	QCommandLineOption pathOption("api-path", "Path of openapi.json on backend.", "path");
+	QCommandLineOption emailOption("email", "Login email.", "email");
+	QCommandLineOption passwordOption("password", "Login password.", "password");
+	QCommandLineOption timeoutOption("timeout", "Request timeout in milliseconds.", "ms", "30000");
+	QCommandLineOption thresholdOption("threshold", "Face score threshold.", "value", "0");
+	QCommandLineOption minSizeOption("min-size", "Minimal face size.", "pixels", "0");
+	QCommandLineOption maxSizeOption("max-size", "Maximal face size.", "pixels", "0");
+	QCommandLineOption landmarksOption("landmarks", "Request face landmarks.");
+	QCommandLineOption attributesOption("attributes", "Request face attributes.");
+	QCommandLineOption demographicsOption("demographics", "Request demographics.");
+	QCommandLineOption skipProcessedOption("skip-processed",
+	                                       "Skip files of directories having current stored results.");
+	QCommandLineOption watchOption("watch", "Watch input directories and detect images dropped into them "
+	                                        "until interrupted.");
+	QCommandLineOption settleOption("settle", "Milliseconds new file must stay unchanged in watch mode.",
+	                                "ms", "1000");
+	QCommandLineOption sequenceOption("sequence", "Treat every input directory, and other inputs together, "
+	                                              "as frame sequence and track faces between keyframes.");
+	QCommandLineOption keyframeOption("keyframe-interval", "Frames between forced keyframes in sequence mode.",
+	                                  "count", "10");
+	QCommandLineOption changeOption("change-threshold", "Frame change forcing keyframe in sequence mode, 0..1.",
+	                                "value", "0.06");
+	QCommandLineOption dedupOption("dedup", "Reuse response of earlier image for images whose perceptual hashes "
+	                                        "differ by at most given bits.", "bits");
+	QCommandLineOption hashOption("hash", "Perceptual hash of --dedup, dhash or phash.", "method", "phash");
+	QCommandLineOption statsOption("stats-interval", "Seconds between throughput reports in watch mode.",
+	                               "seconds", "10");
+	
+	parser.addOptions({ jobsOption, outputOption, urlOption, pathOption, emailOption, passwordOption,
+	                    timeoutOption, thresholdOption, minSizeOption, maxSizeOption,
+	                    landmarksOption, attributesOption, demographicsOption, skipProcessedOption,
+	                    watchOption, settleOption, statsOption, sequenceOption, keyframeOption, changeOption,
+	                    dedupOption, hashOption });
+	parser.process(app);
+	
+	QTextStream errors(stderr);
+	
+	if (parser.positionalArguments().isEmpty())
+	{
+		errors << "No inputs given, see --help" << endl;
+		return UsageError;
+	}
+	
+	QStringList files { };
+	QStringList directories { };
+	for (const auto& argument : parser.positionalArguments())
+	{
+		collect(argument, files, directories);
+	}
+	
+	if (files.isEmpty() && directories.isEmpty())
+	{
+		errors << "No image files found" << endl;
+		return UsageError;
+	}
+	
+	// Settings of gui are defaults of options
+	BatchDetector::Options options { };
+	options.url = parser.value(urlOption);
+	options.path = parser.value(pathOption);
+	options.email = parser.isSet(emailOption) ? parser.value(emailOption) : g_settingsManager->email();
+	options.password = parser.isSet(passwordOption) ? parser.value(passwordOption) : g_settingsManager->password();
+	options.concurrency = parser.value(jobsOption).toInt();
+	options.timeout = parser.value(timeoutOption).toInt();
+	options.threshold = parser.value(thresholdOption).toFloat();
+	options.minSize = parser.value(minSizeOption).toInt();
+	options.maxSize = parser.value(maxSizeOption).toInt();
+	options.facets = (parser.isSet(landmarksOption) ? LandmarksFacet : NoFacets)
+	                 | (parser.isSet(attributesOption) ? AttributesFacet : NoFacets)
+	                 | (parser.isSet(demographicsOption) ? DemographicsFacet : NoFacets);
+	
+	if (options.url.isEmpty())
+	{
+		options.url = g_settingsManager->url().isEmpty() ? QString(BACKEND_URL) : g_settingsManager->url();
+	}
+	if (options.path.isEmpty())
+	{
+		options.path = g_settingsManager->path().isEmpty() ? QString(API_PATH) : g_settingsManager->path();
+	}
+	
+	if (options.concurrency < 1 || options.timeout < 1)
+	{
+		errors << "Job count and timeout must be positive" << endl;
+		return UsageError;
+	}
+	
+	Deduplicator::Options dedupOptions { };
+	dedupOptions.distance = parser.value(dedupOption).toInt();
+	dedupOptions.method = parser.value(hashOption) == "dhash" ? PerceptualHash::DHash : PerceptualHash::PHash;
+	const bool deduplicate = parser.isSet(dedupOption);
+	
+	if (dedupOptions.distance < 0 || (parser.value(hashOption) != "dhash" && parser.value(hashOption) != "phash"))
+	{
+		errors << "Hash distance must not be negative, method must be dhash or phash" << endl;
+		return UsageError;
+	}
+	
+	QFile outputFile;
+	if (parser.isSet(outputOption))
+	{
+		outputFile.setFileName(parser.value(outputOption));
+		if (!outputFile.open(QFile::WriteOnly | QFile::Truncate))
+		{
+			errors << "Can't write " << outputFile.fileName() << endl;
+			return UsageError;
+		}
+	} else
+	{
+		outputFile.open(stdout, QFile::WriteOnly);
+	}
+	
+	if (parser.isSet(watchOption))
+	{
+		if (!files.isEmpty())
+		{
+			errors << "Only directories can be watched" << endl;
+			return UsageError;
+		}
+		
+		FolderWatcher::Options watchOptions { };
+		watchOptions.detector = options;
+		watchOptions.settle = parser.value(settleOption).toInt();
+		return watchFolders(directories, watchOptions, outputFile, parser.value(statsOption).toInt());
+	}
+	
+	if (parser.isSet(sequenceOption))
+	{
+		QVector<QStringList> sequences { };
+		for (const auto& directory : directories)
+		{
+			QStringList frames { };
+			for (const auto& info : QDir(directory).entryInfoList(QDir::Files))
+			{
+				if (!DirectoryScanner::sniff(info.filePath()).isEmpty())
+				{
+					frames.push_back(info.filePath());
+				}
+			}
+			sortFrames(frames);
+			sequences.push_back(frames);
+		}
+		
+		if (!files.isEmpty())
+		{
+			sortFrames(files);
+			sequences.push_back(files);
+		}
+		
+		SequenceDetector::Options sequenceOptions { };
+		sequenceOptions.detector = options;
+		sequenceOptions.keyframeInterval = parser.value(keyframeOption).toInt();
+		sequenceOptions.changeThreshold = parser.value(changeOption).toDouble();
+		return detectSequences(sequences, sequenceOptions, outputFile);
+	}
+	
+	int failures = 0;
+	int total = files.size();
+	int skipped = 0;
+	QVector<qint64> latencies { };
+	latencies.reserve(files.size());
+	
+	auto write = [&outputFile](const QJsonObject& record)
+	{
+		writeRecord(outputFile, record);
+	};
+	
+	// Missing files don't cost a request
+	QStringList existing { };
+	for (const auto& file : files)
+	{
+		if (QFileInfo(file).isFile())
+		{
+			existing.push_back(file);
+			continue;
+		}
+		write({{ "file",  file },
+		       { "ok",    false },
+		       { "error", "No such file" }});
+		++failures;
+	}
+	
+	BatchDetector detector(options);
+	QElapsedTimer timer;
+	
+	DirectoryScanner::Options scanOptions { };
+	scanOptions.skipProcessed = parser.isSet(skipProcessedOption);
+	DirectoryScanner scanner(scanOptions);
+	bool scanning = !directories.isEmpty();
+	Deduplicator deduplicator(dedupOptions);
+	
+	// Unique images come back by signal
+	auto submit = [&](const QStringList& found)
+	{
+		if (deduplicate)
+		{
+			deduplicator.add(found);
+		} else
+		{
+			detector.add(found);
+		}
+	};
+	
+	// Detector queue is kept short, so scanner waits for
+	// requests instead of holding whole tree in memory
+	auto feed = [&]()
+	{
+		const int room = 2 * options.concurrency - detector.pending() - deduplicator.pending();
+		QVector<DirectoryScanner::Entry> entries { };
+		
+		if (room > 0 && scanner.take(entries, room) > 0)
+		{
+			QStringList found { };
+			for (const auto& entry : entries)
+			{
+				found.push_back(entry.path);
+			}
+			total += found.size();
+			submit(found);
+		}
+		
+		if (!scanning && scanner.isFinished() && deduplicator.pending() == 0)
+		{
+			detector.close();
+		}
+	};
+	
+	QObject::connect(&detector, &BatchDetector::detected,
+	                 [&](const QString& file, const QJsonDocument& document, qint64 latency)
+	                 {
+		                 latencies.push_back(latency);
+		                 write(detectedRecord(file, document, latency));
+		                 deduplicator.setResult(file, document);
+		                 feed();
+	                 });
+	QObject::connect(&detector, &BatchDetector::failed,
+	                 [&](const QString& file, const QString& error, qint64 latency)
+	                 {
+		                 latencies.push_back(latency);
+		                 ++failures;
+		                 write(failedRecord(file, error, latency));
+		                 deduplicator.setFailed(file);
+		                 feed();
+	                 });
+	QObject::connect(&detector, &BatchDetector::finished, &app, &QCoreApplication::quit);
+	QObject::connect(&deduplicator, &Deduplicator::unique,
+	                 [&](const QString& file)
+	                 {
+		                 detector.add({ file });
+		                 feed();
+	                 });
+	QObject::connect(&deduplicator, &Deduplicator::duplicate,
+	                 [&](const QString& file, const QString& original, const QJsonDocument& document)
+	                 {
+		                 auto record = detectedRecord(file, document, 0);
+		                 record.insert("duplicate_of", original);
+		                 write(record);
+		                 feed();
+	                 });
+	QObject::connect(&scanner, &DirectoryScanner::available, feed);
+	QObject::connect(&scanner, &DirectoryScanner::finished,
+	                 [&](int, int skippedFiles)
+	                 {
+		                 scanning = false;
+		                 skipped = skippedFiles;
+		                 feed();
+	                 });
+	
+	if (!existing.isEmpty() || scanning)
+	{
+		timer.start();
+		submit(existing);
+		if (scanning)
+		{
+			scanner.start(directories);
+		} else
+		{
+			feed();
+		}
+		detector.start();
+		app.exec();
+	}
+	
+	if (total == 0)
+	{
+		errors << (skipped > 0 ? "Every image file is processed" : "No image files found") << endl;
+		return skipped > 0 ? Success : UsageError;
+	}
+	
+	std::sort(latencies.begin(), latencies.end());
+	const double seconds = qMax<qint64>(1, timer.isValid() ? timer.elapsed() : 0) / 1000.0;
+	
+	errors << "Images: " << total
+	       << ", skipped: " << skipped
+	       << ", duplicates: " << deduplicator.duplicates()
+	       << ", failed: " << failures
+	       << ", time: " << QString::number(seconds, 'f', 2) << " s"
+	       << ", throughput: " << QString::number(latencies.size() / seconds, 'f', 2) << " images/s" << endl
+	       << "Latency ms: p50 " << percentile(latencies, 0.50)
+	       << ", p90 " << percentile(latencies, 0.90)
+	       << ", p99 " << percentile(latencies, 0.99)
+	       << ", max " << (latencies.isEmpty() ? 0 : latencies.last()) << endl;
+	
+	if (failures == 0)
+	{
+		return Success;
+	}
+	return failures == total ? TotalFailure : PartialFailure;
+}
\ No newline at end of file